@@ -16,6 +16,7 @@ namespace async_pipeline {
 class STTProcessor;
 class LLMProcessor;
 class TTSProcessor;
+class TextNormalizerProcessor;
 class PipelineManager;
 
 enum class PopResult {
@@ -44,6 +45,8 @@ struct MessageStats {
 
 struct TextMessage {
     std::string text;
+    bool end_of_response = false;  // marks the end of one LLM response (text is empty)
+    std::string voice;             // TTS voice for this request; empty = session voice
     
     TextMessage() = default;
     TextMessage(std::string txt) : text(std::move(txt)) {}
@@ -52,6 +55,9 @@ struct TextMessage {
 struct AudioChunkMessage {
     std::vector<int16_t> audio_data;
     unsigned int sample_rate;
+    uint64_t chunk_id = 0;  // reported back when the chunk starts playing; 0 = untracked
+    uint64_t turn_id = 0;   // response the chunk belongs to
+    bool filler = false;    // pre-rendered acknowledgement; yields to real speech
     
     AudioChunkMessage() : sample_rate(22050) {}
     AudioChunkMessage(std::vector<int16_t> audio, unsigned int rate = 22050)
@@ -72,6 +78,10 @@ struct ControlMessage {
     
     Type type;
     
+    // When the event behind this signal happened (e.g. speech onset for a
+    // barge-in), for end-to-end latency; default-constructed if unknown
+    std::chrono::steady_clock::time_point origin{};
+    
 #ifdef ENABLE_STATS_LOGGING
     MessageStats stats;
     
@@ -136,17 +146,40 @@ public:
         return true;
     }
 
+    // Blocking push that re-checks still_wanted() under the queue lock once
+    // space is available, so an item made stale while the producer waited
+    // (e.g. by an interrupt that also flushed the queue) is dropped instead
+    // of queued. Returns false only on shutdown.
+    template <typename Pred>
+    bool push_blocking(T item, Pred still_wanted) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        
+        if (shutdown_) return false;
+        
+        not_full_.wait(lock, [this] { 
+            return queue_.size() < max_size_ || shutdown_; 
+        });
+        
+        if (shutdown_) return false;
+        if (!still_wanted()) return true;
+        
+        queue_.push(std::move(item));
+        not_empty_.notify_one();
+        return true;
+    }
+
     // Pop with timeout - returns PopResult indicating success or failure reason
     PopResult pop(T& item, std::chrono::milliseconds timeout = std::chrono::milliseconds(100)) {
         std::unique_lock<std::mutex> lock(mutex_);
         
         if (!not_empty_.wait_for(lock, timeout, [this] { 
-            return !queue_.empty() || shutdown_ || external_interrupt_requested(); 
+            return !queue_.empty() || shutdown_ || woken_ || external_interrupt_requested(); 
         })) {
             return PopResult::TIMEOUT;
         }
         
         if (shutdown_) return PopResult::SHUTDOWN;
+        if (consume_wake()) return PopResult::INTERRUPTED;
         if (external_interrupt_requested()) return PopResult::INTERRUPTED;
         if (queue_.empty()) return PopResult::EMPTY;
         
@@ -161,10 +194,11 @@ public:
         std::unique_lock<std::mutex> lock(mutex_);
         
         not_empty_.wait(lock, [this] { 
-            return !queue_.empty() || shutdown_ || external_interrupt_requested(); 
+            return !queue_.empty() || shutdown_ || woken_ || external_interrupt_requested(); 
         });
         
         if (shutdown_) return PopResult::SHUTDOWN;
+        if (consume_wake()) return PopResult::INTERRUPTED;
         if (external_interrupt_requested()) return PopResult::INTERRUPTED;
         if (queue_.empty()) return PopResult::EMPTY;
         
@@ -222,6 +256,16 @@ public:
         not_empty_.notify_all();
         not_full_.notify_all();
     }
+    
+    // Make the current (or next) pop()/pop_blocking() return INTERRUPTED
+    // once, so a consumer waiting for data gets to its control signals first
+    void wake() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            woken_ = true;
+        }
+        not_empty_.notify_all();
+    }
 
 private:
     mutable std::mutex mutex_;
@@ -230,8 +274,15 @@ private:
     std::condition_variable not_full_;
     size_t max_size_;
     std::atomic<bool> shutdown_;
+    bool woken_ = false;  // guarded by mutex_
     std::atomic<bool>* interrupt_flag_;
     
+    bool consume_wake() {
+        const bool woken = woken_;
+        woken_ = false;
+        return woken;
+    }
+    
     bool external_interrupt_requested() const {
         return interrupt_flag_ && interrupt_flag_->load(std::memory_order_acquire);
     }
@@ -283,6 +334,7 @@ public:
             control_queue_.push(msg);
         }
         control_signal_.notify_one(); // Wake up processor immediately
+        wake();                       // including out of a wait for input
         // Reduce logging noise: log only shutdown and pause/resume at info level
         if (msg.type == ControlMessage::SHUTDOWN || msg.type == ControlMessage::PAUSE || msg.type == ControlMessage::RESUME) {
             std::cout << "[" << name_ << "] Control signal received: " << control_type_to_string(msg.type) << std::endl;
@@ -358,6 +410,10 @@ protected:
         return false; // Return true if handled, false to continue with default processing
     }
     
+    // Override to break process() out of a blocking wait on its input (e.g.
+    // SafeQueue::wake()); called by signal_control from the signalling thread
+    virtual void wake() {}
+    
     // Main thread loop with signal-based control
     void run() {
         while (running_) {
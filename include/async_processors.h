@@ -5,6 +5,12 @@
 #include "llm.h"
 #include "tts.h"
 #include "common-sdl.h"
+#include "resampler.h"
+#include "chunk_joiner.h"
+#include "text_normalizer.h"
+#include "audio_sink.h"
+#include "echo_canceller.h"
+#include "playback_clock.h"
 #include <sys/types.h>
 #include <unistd.h>
 #include <alsa/asoundlib.h>
@@ -13,30 +19,62 @@
 #include <sys/mman.h>
 #include <fcntl.h>
 #include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
 #include <thread>
 
 namespace async_pipeline {
 
-// Shared memory structure for phoneme timing data
+// Shared memory ring of phoneme timing data for the avatar process.
+//
+// Single producer (the TTS playback thread), single consumer. Indices are
+// free-running counters; slot = index & (MAX_PHONEMES - 1) and the ring is
+// full when write_index - read_index == MAX_PHONEMES.
+//   Producer: fill slots, then write_index.store(release).
+//   Consumer: write_index.load(acquire), read slots, then read_index.store(release).
+// Readers must check magic and version (magic is published last, with
+// release) before trusting the layout. The two indices sit on separate cache
+// lines so producer and consumer do not false-share.
 struct PhonemeQueueHeader {
-    std::atomic<uint32_t> write_index{0};
-    std::atomic<uint32_t> read_index{0};
+    static constexpr uint32_t MAGIC = 0x4d485054;  // "TPHM"
+    static constexpr uint32_t VERSION = 2;
+    static constexpr size_t MAX_PHONEMES = 1024;   // power of two
+    
+    std::atomic<uint32_t> magic{0};
+    uint32_t version = VERSION;
+    uint32_t capacity = MAX_PHONEMES;
+    uint32_t entry_size = 0;
     std::atomic<bool> shutdown_flag{false};
-    static constexpr size_t MAX_PHONEMES = 1024;
+    
+    // Interruption: entries below cancel_index that start at or after
+    // cancel_time_us (CLOCK_MONOTONIC, us) will not play. cancel_time_us is
+    // stored first, then cancel_index with release.
+    std::atomic<uint64_t> cancel_time_us{0};
+    std::atomic<uint32_t> cancel_index{0};
+    
+    alignas(64) std::atomic<uint32_t> write_index{0};  // written by the producer only
+    alignas(64) std::atomic<uint32_t> read_index{0};   // written by the consumer only
 };
 
 struct PhonemeData {
     int64_t phoneme_id;
     float duration_seconds;
-    uint64_t timestamp_us;
+    uint64_t start_time_us;  // scheduled playback start, CLOCK_MONOTONIC (steady_clock) us
 };
 
 // Shared memory queue for phoneme data
 struct PhonemeSharedQueue {
     PhonemeQueueHeader header;
-    PhonemeData phonemes[PhonemeQueueHeader::MAX_PHONEMES];
+    alignas(64) PhonemeData phonemes[PhonemeQueueHeader::MAX_PHONEMES];
 };
 
+static_assert((PhonemeQueueHeader::MAX_PHONEMES & (PhonemeQueueHeader::MAX_PHONEMES - 1)) == 0,
+              "MAX_PHONEMES must be a power of two");
+static_assert(std::atomic<uint32_t>::is_always_lock_free && std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory indices must be lock-free to work across processes");
+
 /**
  * STT processor that captures audio directly and produces transcribed text
  */
@@ -44,6 +82,29 @@ class STTProcessor : public BaseProcessor {
 public:
     STTProcessor(SafeQueue<TextMessage>& output_queue, std::unique_ptr<ISTT> stt_backend);
 
+    // Notified of sustained speech (barge-in); call before start()
+    void set_speech_start_handler(ISTT::SpeechStartCallback handler) {
+        speech_start_handler_ = std::move(handler);
+    }
+    
+    // Playback signal for echo cancellation on the capture side; call before start()
+    void set_echo_reference(std::shared_ptr<EchoReference> reference) {
+        echo_reference_ = std::move(reference);
+    }
+    
+    // Notified of each partial transcript of the current utterance; call before start()
+    void set_partial_handler(ISTT::PartialResultCallback handler) {
+        partial_handler_ = std::move(handler);
+    }
+
+    // Notified when an utterance has been endpointed: by the backend at the
+    // endpoint itself when it reports one, otherwise when the transcript
+    // arrives, before it is queued for the LLM; call before start()
+    using UtteranceHandler = std::function<void(std::chrono::steady_clock::time_point endpoint)>;
+    void set_utterance_handler(UtteranceHandler handler) {
+        utterance_handler_ = std::move(handler);
+    }
+
 protected:
     bool initialize() override;
     void process() override;
@@ -54,6 +115,11 @@ private:
     SafeQueue<TextMessage>& output_queue_;
     std::unique_ptr<ISTT> stt_;
     std::atomic<bool> streaming_active_{false};
+    ISTT::SpeechStartCallback speech_start_handler_;
+    ISTT::PartialResultCallback partial_handler_;
+    UtteranceHandler utterance_handler_;
+    std::atomic<bool> endpoint_reported_{false};  // backend already reported this utterance's end
+    std::shared_ptr<EchoReference> echo_reference_;
 };
 
 /**
@@ -71,6 +137,7 @@ protected:
     void process() override;
     void cleanup() override;
     bool handle_control_message(const ControlMessage& msg) override;
+    void wake() override { input_queue_.wake(); }
 
 private:
     SafeQueue<TextMessage>& input_queue_;
@@ -81,14 +148,83 @@ private:
 };
 
 /**
- * Audio output processor that consumes audio chunks and plays them through ALSA
+ * Text normalizer that sits between the LLM and TTS: re-segments streamed
+ * response chunks at prosodic boundaries and expands numbers, units and
+ * symbols, stripping markup, so TTS gets fewer, speakable calls
+ */
+class TextNormalizerProcessor : public BaseProcessor {
+public:
+    TextNormalizerProcessor(SafeQueue<TextMessage>& input_queue, SafeQueue<TextMessage>& output_queue);
+
+protected:
+    bool initialize() override;
+    void process() override;
+    void cleanup() override;
+    bool handle_control_message(const ControlMessage& msg) override;
+    void wake() override { input_queue_.wake(); }
+
+private:
+    SafeQueue<TextMessage>& input_queue_;
+    SafeQueue<TextMessage>& output_queue_;
+    TextSegmenter segmenter_;
+    std::string voice_;  // voice of the response being segmented
+    
+    // Buffered text is flushed after this long without input (no end marker)
+    std::chrono::milliseconds idle_flush_{400};
+    
+#ifdef ENABLE_STATS_LOGGING
+    uint64_t chunks_in_ = 0;
+    uint64_t segments_out_ = 0;
+    uint64_t chars_in_ = 0;
+    double normalize_ms_ = 0.0;
+#endif
+    
+    bool emit_segment(const std::string& raw);
+};
+
+/**
+ * Audio output processor that consumes audio chunks and plays them through an
+ * AudioSink (ALSA by default; null, WAV file or memory for headless runs).
+ * The output rate is negotiated once at startup; chunks at any other rate are
+ * resampled on the fly instead of reopening the output.
  */
 class AudioOutputProcessor : public BaseProcessor {
 public:
-    AudioOutputProcessor(SafeQueue<AudioChunkMessage>& input_queue);
+    // Without a sink, the one selected by settings.audio.output.sink is created
+    AudioOutputProcessor(SafeQueue<AudioChunkMessage>& input_queue, unsigned int sample_rate = 22050,
+                         std::shared_ptr<AudioSink> sink = nullptr);
     
-    // Immediate audio interruption - stops ALSA playback instantly
+    // Immediate audio interruption - stops playback instantly
     void interrupt_audio_immediately();
+    
+    // Called on the playback thread just before a tracked chunk (chunk_id != 0)
+    // is written, with the time its first sample will be heard; set before start()
+    using PlaybackCallback = std::function<void(uint64_t chunk_id, std::chrono::steady_clock::time_point start_time)>;
+    void set_playback_callback(PlaybackCallback callback) {
+        playback_callback_ = std::move(callback);
+    }
+    
+    // Called on the playback thread when the queue runs empty, with the time
+    // the last written sample will have been heard; set before start()
+    using IdleCallback = std::function<void(std::chrono::steady_clock::time_point end_time)>;
+    void set_idle_callback(IdleCallback callback) {
+        idle_callback_ = std::move(callback);
+    }
+    
+    // Receives everything played, timed to when it is heard, so the capture
+    // side can cancel it out of the microphone; set before start()
+    void set_echo_reference(std::shared_ptr<EchoReference> reference) {
+        echo_reference_ = std::move(reference);
+    }
+    
+    // Playback health, safe to read from any thread
+    using OutputMetrics = AudioSinkMetrics;
+    OutputMetrics get_output_metrics() const;
+    
+    // What is audible right now, and where the last interruption cut playback;
+    // safe to call from any thread
+    PlaybackPosition playback_position() const;
+    PlaybackPosition last_interrupt_position() const { return clock_.last_drop(); }
 
 protected:
     bool initialize() override;
@@ -98,12 +234,31 @@ protected:
 
 private:
     SafeQueue<AudioChunkMessage>& input_queue_;
-    snd_pcm_t* alsa_handle_;
-    unsigned int sample_rate_;
+    std::shared_ptr<AudioSink> sink_;
+    std::atomic<bool> sink_open_{false};
+    unsigned int sample_rate_;  // requested rate, then the rate the sink accepted
+    
+    // Converts chunks whose rate differs from the output rate
+    PolyphaseResampler resampler_;
+    std::vector<int16_t> resampled_;
+    std::vector<int16_t> fade_;  // tail of a filler cut short by real speech
+    std::atomic<bool> interrupt_pending_{false};  // set on interrupt, applied on the playback thread
+    unsigned int unconvertible_rate_ = 0;  // source rate already handled by reopening the output
+    PlaybackCallback playback_callback_;
+    IdleCallback idle_callback_;
+    std::shared_ptr<EchoReference> echo_reference_;
+    PlaybackClock clock_;
+    
+    // Writes are split into slices this long while feeding the echo
+    // reference, so it only runs one slice ahead of the device
+    static constexpr size_t kEchoSliceFrames = 1024;
     
     bool init_audio_device();
+    bool reconfigure_audio_device(unsigned int sample_rate);
+    bool prepare_resampler(unsigned int in_rate);
     void close_audio_device();
-    void play_audio_chunk(const std::vector<int16_t>& chunk);
+    void play_audio_chunk(const std::vector<int16_t>& chunk, uint64_t chunk_id = 0, uint64_t turn_id = 0,
+                          bool filler = false);
 };
 
 /**
@@ -114,49 +269,212 @@ public:
     TTSProcessor(SafeQueue<TextMessage>& input_queue, std::unique_ptr<ITTS> tts_backend, std::atomic<bool>* interrupt_flag = nullptr);
 
     void stop() override;
+    
+    // Play through this sink instead of the configured one; call before start()
+    void set_audio_sink(std::shared_ptr<AudioSink> sink) {
+        audio_sink_ = std::move(sink);
+    }
+    
+    // Share what is played with the capture side's echo canceller; call before start()
+    void set_echo_reference(std::shared_ptr<EchoReference> reference) {
+        echo_reference_ = std::move(reference);
+    }
+    
+    // True from the first audible chunk of a response until playback goes idle
+    bool is_speaking() const { return is_speaking_; }
+    
+    // Barge-in: drop synthesis in flight and stop the device now, from any
+    // thread. Follow with an INTERRUPT carrying the same origin, which
+    // finishes the interruption (queues, turn numbering) on the TTS thread.
+    void interrupt_playback(std::chrono::steady_clock::time_point origin);
+    
+    // Session voice, used for text that does not name one; false if the
+    // backend does not have it
+    bool set_voice(const std::string& voice);
+    std::string voice() const {
+        std::lock_guard<std::mutex> lock(voice_mutex_);
+        return voice_;
+    }
+    
+    // The user finished an utterance: starts timing the response and, when
+    // recent responses took longer than the filler threshold to be heard,
+    // queues a pre-rendered acknowledgement. Called from the STT thread.
+    void on_user_utterance(std::chrono::steady_clock::time_point endpoint);
+    
+    // Playback clock of the internal audio output, mapped to chunk and turn ids
+    PlaybackPosition playback_position() const {
+        return audio_output_processor_ ? audio_output_processor_->playback_position() : PlaybackPosition{};
+    }
+    PlaybackPosition last_interrupt_position() const {
+        return audio_output_processor_ ? audio_output_processor_->last_interrupt_position() : PlaybackPosition{};
+    }
+    
+    // Playback metrics of the internal audio output (final values once stopped)
+    AudioOutputProcessor::OutputMetrics get_output_metrics() const {
+        return audio_output_processor_ ? audio_output_processor_->get_output_metrics()
+                                       : final_output_metrics_;
+    }
 
 protected:
     bool initialize() override;
     void process() override;
     void cleanup() override;
     bool handle_control_message(const ControlMessage& msg) override;
+    void wake() override { input_queue_.wake(); }
 
 private:
     SafeQueue<TextMessage>& input_queue_;
     std::unique_ptr<ITTS> tts_;
     std::atomic<bool> is_speaking_;
     pid_t tts_pid_;
+    
+#ifdef ENABLE_STATS_LOGGING
+    // Speech onset to dropped playback for interrupts with a known origin
+    uint64_t barge_ins_ = 0;
+    double barge_in_total_ms_ = 0.0;
+    double barge_in_max_ms_ = 0.0;
+#endif
     std::atomic<bool>* interrupt_flag_ = nullptr;
     
+    // Fillers, rendered once at startup (and kept by the audio cache across
+    // runs) so playing one needs no synthesis
+    struct Filler {
+        std::vector<int16_t> audio;
+        unsigned int sample_rate = 0;
+    };
+    std::vector<Filler> fillers_;  // read-only after initialize()
+    std::atomic<size_t> next_filler_{0};
+    double filler_threshold_ms_ = 0.0;
+    
+    // Endpoint to first audible response, averaged over recent turns
+    // (guarded by response_latency_mutex_); negative until measured
+    std::mutex response_latency_mutex_;
+    std::chrono::steady_clock::time_point pending_endpoint_{};
+    double response_latency_ms_ = -1.0;
+#ifdef ENABLE_STATS_LOGGING
+    uint64_t fillers_played_ = 0;
+#endif
+    
+    // Parallel synthesis: each worker thread owns a backend instance (tts_ plus
+    // clones) and results are reassembled in submission order for playback
+    struct SynthesisJob {
+        std::string text;
+        bool with_phonemes = false;
+        uint64_t generation = 0;
+        std::deque<TTSStreamChunk> chunks;  // synthesized, not yet queued for playback
+        bool done = false;
+        bool completed = false;        // its last chunk was synthesized
+        bool end_of_response = false;  // marker only: fade out the response's tail
+        uint64_t turn_id = 0;
+        std::string voice;
+    };
+    std::vector<std::unique_ptr<ITTS>> extra_tts_;
+    std::vector<std::thread> worker_threads_;
+    std::atomic<bool> workers_running_{false};
+    std::mutex jobs_mutex_;
+    std::condition_variable jobs_cv_;
+    std::map<uint64_t, SynthesisJob> jobs_;  // in flight, keyed by sequence number
+    std::deque<uint64_t> pending_jobs_;      // not yet picked up by a worker
+    uint64_t next_job_seq_ = 0;
+    uint64_t next_deliver_seq_ = 0;
+    std::atomic<uint64_t> job_generation_{0};  // bumped on interrupt to drop stale work
+    
+    // One thread feeds playback from the oldest job, so workers never wait on
+    // the audio queue; woken through deliver_cv_ (with jobs_mutex_)
+    std::thread delivery_thread_;
+    std::condition_variable deliver_cv_;
+    
+    // Seamless joins between delivered chunks (delivery thread only)
+    ChunkJoiner joiner_;
+    uint64_t joiner_generation_ = 0;
+    uint64_t delivered_turn_ = 0;
+    
+    // Responses are numbered as turns; each end-of-response marker or
+    // interruption starts the next one (processor thread only)
+    uint64_t current_turn_ = 1;
+    bool turn_has_speech_ = false;
+    
+    // Worker count tuning from the measured real-time factor (guarded by jobs_mutex_)
+    bool auto_tune_workers_ = true;
+    size_t active_workers_ = 1;
+    double rtf_average_ = 0.0;
+    
     // Internal audio output processing (not exposed externally)
     std::unique_ptr<SafeQueue<AudioChunkMessage>> audio_output_queue_;
     std::unique_ptr<AudioOutputProcessor> audio_output_processor_;
+    std::shared_ptr<AudioSink> audio_sink_;  // optional override of settings.audio.output.sink
+    std::shared_ptr<EchoReference> echo_reference_;
+    AudioOutputProcessor::OutputMetrics final_output_metrics_;
     
     // Face display control
     std::atomic<bool> face_shown_{false};
     
-    // Unix socket for face control
+    mutable std::mutex voice_mutex_;
+    std::string voice_;  // session voice; empty = the backend's default
+    
+    // Unix socket for face control. Clients stay connected and send
+    // newline-delimited commands: face_show, face_hide, face_toggle, status,
+    // voice [name], subscribe, unsubscribe. Subscribers get one event per line, with times
+    // in steady_clock microseconds of when the audio is heard:
+    //   speech_start <us> | chunk <us> <chunk_id> | speech_stop <us> |
+    //   speech_interrupted <us> | face_shown <0|1>
+    struct ControlClient {
+        std::string in;   // partial command line
+        std::string out;  // replies and events not yet sent
+        bool subscribed = false;
+    };
     int socket_fd_{-1};
+    int epoll_fd_{-1};
+    int event_fd_{-1};  // wakes the socket thread for shutdown and new events
     std::string socket_path_{"/tmp/tts_face_control.sock"};
     std::thread socket_thread_;
     std::atomic<bool> socket_running_{false};
+    std::map<int, ControlClient> control_clients_;  // socket thread only
+    std::mutex control_events_mutex_;
+    std::vector<std::string> control_events_;       // queued for subscribers
     
     // Shared memory for phoneme data
     PhonemeSharedQueue* shared_queue_{nullptr};
     int shared_mem_fd_{-1};
     std::string shared_mem_path_{"tts_phoneme_queue"};
     
+    // Phonemes wait here until their audio chunk starts playing, so the
+    // published start times follow the playback clock, not synthesis
+    std::mutex phonemes_mutex_;
+    std::map<uint64_t, std::vector<PhonemeTimingInfo>> pending_phonemes_;  // by chunk id
+    uint64_t next_chunk_id_ = 1;  // delivery thread only
+    
     void interrupt_current_speech();
     
+    // Synthesis worker methods
+    bool start_workers();
+    void stop_workers();
+    void synthesis_worker(ITTS* tts);
+    void delivery_loop();
+    bool push_joined_audio(std::vector<int16_t>&& audio, unsigned int sample_rate,
+                           std::vector<PhonemeTimingInfo>&& phonemes = {});
+    void cancel_pending_jobs();
+    bool speech_cancel_requested() const;
+    void render_fillers();
+    void update_worker_target(double synth_seconds, double audio_seconds);
+    
     // Unix socket methods
     bool setup_unix_socket();
     void socket_server_thread();
-    void handle_socket_command(const std::string& command);
+    void handle_socket_command(ControlClient& client, const std::string& command);
+    void accept_control_clients();
+    void read_control_client(int fd);
+    void flush_control_client(int fd);
+    void close_control_client(int fd);
+    void push_control_event(const std::string& event);
     void cleanup_socket();
     
     // Shared memory methods
     bool setup_shared_memory();
-    void send_phoneme_data(const std::vector<PhonemeTimingInfo>& phonemes);
+    void send_phoneme_data(const std::vector<PhonemeTimingInfo>& phonemes, std::chrono::steady_clock::time_point start_time);
+    void on_chunk_playback(uint64_t chunk_id, std::chrono::steady_clock::time_point start_time);
+    void on_playback_idle(std::chrono::steady_clock::time_point end_time);
+    void cancel_pending_phonemes();
     void cleanup_shared_memory();
 };
 
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "common.h"
+
+#include <alsa/asoundlib.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+//
+// Audio sinks
+//
+
+// Playback health, safe to read from any thread
+struct AudioSinkMetrics {
+    uint64_t xruns = 0;          // underruns while audio was still queued for playback
+    uint64_t idle_drains = 0;    // buffer ran dry because no audio was queued (gaps, end of speech)
+    uint64_t frames_written = 0;
+    double latency_ms = 0.0;     // audio queued ahead of the listener after the most recent write
+    double max_latency_ms = 0.0;
+
+    void print() const {
+        std::cout << "Xruns: " << xruns << ", Idle drains: " << idle_drains
+                  << ", Frames written: " << frames_written
+                  << ", Output latency: " << latency_ms << "ms (max " << max_latency_ms << "ms)"
+                  << std::endl;
+    }
+};
+
+// Destination for mono S16 playback audio. AudioOutputProcessor owns the
+// queue, resampling and interruption logic; a sink only has to accept frames
+// at the negotiated rate, blocking for as long as real playback would.
+class AudioSink {
+public:
+    virtual ~AudioSink() = default;
+
+    // Open for output at sample_rate, which is updated to the rate actually used
+    virtual bool open(unsigned int & sample_rate) = 0;
+
+    // Play out anything buffered and release the output
+    virtual void close() = 0;
+
+    // Write a block of frames. Returns early once abort is set; false on an
+    // unrecoverable error.
+    virtual bool write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) = 0;
+
+    // Called after each block with whether more audio is already queued, so
+    // an empty buffer in a pause is not mistaken for a glitch
+    virtual void end_of_block(bool more_queued) { (void) more_queued; }
+
+    // Discard buffered audio immediately; may be called from any thread
+    virtual void drop() {}
+
+    // Audio already accepted but not yet heard, in milliseconds
+    virtual double delay_ms() const { return 0.0; }
+
+    virtual const char * name() const = 0;
+
+    AudioSinkMetrics metrics() const;
+    uint64_t frames_written() const { return m_frames_written.load(); }
+
+protected:
+    std::atomic<uint64_t> m_xruns{0};
+    std::atomic<uint64_t> m_idle_drains{0};
+    std::atomic<uint64_t> m_frames_written{0};
+    std::atomic<double>   m_latency_ms{0.0};
+    std::atomic<double>   m_max_latency_ms{0.0};
+
+    void record_latency(double latency_ms);
+};
+
+// ALSA playback. Writes are driven by snd_pcm_avail and keep the device
+// buffer at a target fill rather than full, so interruptions stay cheap.
+class AlsaAudioSink : public AudioSink {
+public:
+    struct Options {
+        std::string device = "default";
+        size_t period_frames = 256;
+        unsigned int periods = 4;
+        bool mmap = false;          // mmap transfers, if the device supports them
+        int target_fill_ms = 40;
+    };
+
+    explicit AlsaAudioSink(const Options & options) : m_options(options) {}
+    ~AlsaAudioSink() override { close(); }
+
+    bool open(unsigned int & sample_rate) override;
+    void close() override;
+    bool write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) override;
+    void end_of_block(bool more_queued) override;
+    void drop() override;
+    double delay_ms() const override;
+    const char * name() const override { return "alsa"; }
+
+private:
+    Options m_options;
+    snd_pcm_t * m_handle = nullptr;
+    unsigned int m_sample_rate = 0;
+
+    snd_pcm_uframes_t m_period_frames = 0;
+    snd_pcm_uframes_t m_buffer_frames = 0;
+    snd_pcm_uframes_t m_target_fill_frames = 0;
+    bool m_mmap_active = false;
+    bool m_idle_drain_expected = true;  // nothing was queued after the last block
+
+    bool recover(int err);
+    void update_latency();
+};
+
+// Discards audio. Paced mode consumes it at the real-time rate (with a small
+// lead, like a device buffer) so end-to-end timing matches real playback;
+// unpaced mode returns immediately for throughput runs.
+class NullAudioSink : public AudioSink {
+public:
+    explicit NullAudioSink(bool paced = true, int lead_ms = 40) : m_paced(paced), m_lead_ms(lead_ms) {}
+
+    bool open(unsigned int & sample_rate) override;
+    void close() override {}
+    bool write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) override;
+    void drop() override;
+    double delay_ms() const override;
+    const char * name() const override { return m_paced ? "null (paced)" : "null"; }
+
+protected:
+    // Hook for sinks that keep what they are given
+    virtual void consume(const int16_t * data, size_t frames) { (void) data; (void) frames; }
+
+private:
+    bool m_paced;
+    int  m_lead_ms;
+    unsigned int m_sample_rate = 0;
+
+    mutable std::mutex m_clock_mutex;
+    std::chrono::steady_clock::time_point m_play_end;  // when everything written so far has played
+};
+
+// Writes playback audio to a 16-bit mono WAV file, unpaced
+class WavFileAudioSink : public AudioSink {
+public:
+    explicit WavFileAudioSink(std::string path) : m_path(std::move(path)) {}
+    ~WavFileAudioSink() override { close(); }
+
+    bool open(unsigned int & sample_rate) override;
+    void close() override;
+    bool write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) override;
+    const char * name() const override { return "wav"; }
+
+private:
+    std::string m_path;
+    wav_writer m_writer;
+    bool m_open = false;
+};
+
+// Captures playback audio in memory so tests can assert on the exact samples
+class MemoryAudioSink : public NullAudioSink {
+public:
+    explicit MemoryAudioSink(bool paced = false) : NullAudioSink(paced) {}
+
+    bool open(unsigned int & sample_rate) override;
+    const char * name() const override { return "memory"; }
+
+    std::vector<int16_t> captured() const;
+    unsigned int sample_rate() const;
+    void clear();
+
+protected:
+    void consume(const int16_t * data, size_t frames) override;
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<int16_t> m_audio;
+    unsigned int m_rate = 0;
+};
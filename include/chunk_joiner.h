@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// TTS chunk joiner
+//
+
+// Stitches consecutively synthesized PCM chunks into one seamless stream.
+// Trailing silence is trimmed on a 10 ms energy envelope (never speech), and
+// the end of each chunk is held back and joined to the start of the next one
+// with a short equal-power crossfade from a precomputed gain table. The final
+// chunk of an utterance gets a matching fade-out instead.
+class ChunkJoiner {
+public:
+    ChunkJoiner() = default;
+
+    // crossfade_ms     : overlap between consecutive chunks
+    // keep_silence_ms  : trailing silence left in place after the last voiced frame
+    // silence_threshold: frame RMS (full scale = 1.0) below which a frame is silent
+    void init(int sample_rate, int crossfade_ms = 8, int keep_silence_ms = 120, float silence_threshold = 0.003f);
+
+    // Drop any held-back audio (e.g. after an interruption)
+    void reset();
+
+    // Join the next chunk, appending the audio that is ready to play to out.
+    // With last set, everything is flushed and the held tail is cleared.
+    void push(const int16_t * in, size_t n, bool last, std::vector<int16_t> & out);
+
+    // Flush the held tail with a fade-out, as if the previous chunk was last
+    void flush(std::vector<int16_t> & out) { push(nullptr, 0, true, out); }
+
+    bool has_pending()  const { return !m_tail.empty(); }
+    int  sample_rate()  const { return m_sample_rate; }
+
+private:
+    int    m_sample_rate  = 0;
+    size_t m_frame        = 0;   // envelope frame length in samples
+    size_t m_keep_silence = 0;
+    float  m_threshold    = 0.0f;
+
+    std::vector<float>   m_fade_in;  // sin ramp; the fade-out is its reverse
+    std::vector<int16_t> m_tail;     // held-back end of the previous chunk
+
+    size_t voiced_length(const int16_t * in, size_t n) const;
+};
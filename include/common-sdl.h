@@ -3,6 +3,8 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_audio.h>
 
+#include "resampler.h"
+
 #include <atomic>
 #include <cstdint>
 #include <vector>
@@ -37,6 +39,10 @@ private:
     int m_len_ms = 0;
     int m_sample_rate = 0;
 
+    // The device is opened at its native rate and converted to m_sample_rate
+    PolyphaseResampler m_resampler;
+    std::vector<float> m_resampled;
+
     std::atomic_bool m_running;
     std::mutex       m_mutex;
 
@@ -2,14 +2,23 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <map>
+#include <memory>
 #include <vector>
 #include <random>
 #include <thread>
 #include <ctime>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <mutex>
+
+#include "pcm_kernels.h"
 
 //
 // GPT CLI argument parsing
@@ -58,6 +67,87 @@ std::string replace(
         const std::string & from,
         const std::string & to);
 
+// Byte trie over the vocabulary, for longest-match lookups that neither
+// allocate nor compare whole strings. The root's children are indexed
+// directly; deeper nodes keep their edges sorted by byte.
+struct gpt_token_trie {
+    struct node {
+        uint32_t first_edge = 0;
+        uint16_t n_edges    = 0;
+        int32_t  id         = -1;  // token ending here, -1 if none
+    };
+
+    std::vector<node>     nodes;       // nodes[0] is the root
+    std::vector<uint8_t>  edge_bytes;
+    std::vector<uint32_t> edge_nodes;
+    uint32_t root_next[256] = {};      // 0 = no child
+    size_t   n_tokens = 0;
+
+    void build(const std::map<std::string, int32_t> & token_to_id);
+    // tokens must be sorted bytewise
+    void build(const std::vector<std::pair<std::string_view, int32_t>> & sorted_tokens);
+
+    // Length of the longest token that is a prefix of s[0, n) and its id; 0 if none
+    size_t longest_match(const char * s, size_t n, int32_t & id) const;
+};
+
+// Memory-mapped binary vocabulary, written once from encoder.json by
+// gpt_vocab_save_binary. Layout, in native byte order: header, entries
+// {blob offset, length, id} sorted bytewise by token, id -> entry index,
+// perfect-hash displacements and slots, then the token blob. A lookup hashes
+// the text, reads one displacement and one slot and compares one string.
+class gpt_vocab_file {
+public:
+    gpt_vocab_file() = default;
+    ~gpt_vocab_file();
+    gpt_vocab_file(const gpt_vocab_file &) = delete;
+    gpt_vocab_file & operator=(const gpt_vocab_file &) = delete;
+
+    static bool is_binary(const std::string & fname);
+
+    bool open(const std::string & fname);
+    void close();
+
+    size_t size() const { return n_tokens; }
+
+    // id of the token spelled s[0, n), -1 if there is none
+    int32_t find(const char * s, size_t n) const;
+
+    // text of token `id`, empty if unknown
+    std::string_view token(int32_t id) const;
+
+    // i-th token in bytewise order
+    std::string_view token_at(size_t i, int32_t & id) const;
+
+    // trie over the mapped tokens, built on first use and kept until close()
+    const gpt_token_trie & trie() const;
+
+private:
+    struct entry {
+        uint32_t offset;
+        uint32_t length;
+        int32_t  id;
+    };
+
+    void *   mapped      = nullptr;
+    size_t   mapped_size = 0;
+
+    uint32_t n_tokens  = 0;
+    uint32_t n_ids     = 0;
+    uint32_t n_buckets = 0;
+    uint32_t n_slots   = 0;
+    uint64_t seed      = 0;
+
+    const entry *    entries  = nullptr;
+    const uint32_t * id_index = nullptr;
+    const uint32_t * disps    = nullptr;
+    const uint32_t * slots    = nullptr;
+    const char *     blob     = nullptr;
+
+    mutable std::mutex     trie_mutex;
+    mutable gpt_token_trie trie_cache;
+};
+
 struct gpt_vocab {
     using id    = int32_t;
     using token = std::string;
@@ -66,7 +156,21 @@ struct gpt_vocab {
     std::map<id, token> id_to_token;
     std::vector<std::string> special_tokens;
 
+    // set when loaded from a binary vocab; token_to_id and id_to_token are
+    // left empty then, so look tokens up through find() and token_text()
+    // (every caller in this tree does)
+    std::shared_ptr<const gpt_vocab_file> file;
+
+    // built by gpt_vocab_init for a JSON vocab; call build_trie() after
+    // changing token_to_id. A binary vocab uses file->trie() instead.
+    gpt_token_trie trie;
+
     void add_special_token(const std::string & token);
+    void build_trie();
+
+    size_t size() const;
+    id find(const std::string & text) const;  // -1 if unknown
+    std::string_view token_text(id i) const;  // empty if unknown
 };
 
 // poor-man's JSON parsing
@@ -88,6 +192,10 @@ void gpt_split_words(std::string str, std::vector<std::string>& words);
 // Regex (C++):
 // R"('s|'t|'re|'ve|'m|'ll|'d| ?[[:alpha:]]+| ?[[:digit:]]+| ?[^\s[:alpha:][:digit:]]+|\s+(?!\S)|\s+)"
 //
+// The C++ pattern is matched by hand, with the classes of the "C" locale
+// (ASCII letters, digits and whitespace), and each word is split into the
+// longest vocabulary tokens through vocab.trie
+//
 std::vector<gpt_vocab::id> gpt_tokenize(const gpt_vocab & vocab, const std::string & text);
 
 // test outputs of gpt_tokenize
@@ -99,8 +207,14 @@ std::vector<gpt_vocab::id> gpt_tokenize(const gpt_vocab & vocab, const std::stri
 //
 void test_gpt_tokenizer(gpt_vocab & vocab, const std::string & fpath_test);
 
-// load the tokens from encoder.json
-bool gpt_vocab_init(const std::string & fname, gpt_vocab & vocab);
+// load the tokens from encoder.json, or from a binary vocab: fname itself if
+// it is one or, when cache_dir is given, the binary copy of fname kept there.
+// That copy is written (and logged) on the first load and whenever fname is
+// newer; without cache_dir nothing is written.
+bool gpt_vocab_init(const std::string & fname, gpt_vocab & vocab, const std::string & cache_dir = "");
+
+// write the vocab in the gpt_vocab_file format
+bool gpt_vocab_save_binary(const gpt_vocab & vocab, const std::string & fname);
 
 // sample next token given probabilities for each embedding
 //
@@ -134,12 +248,40 @@ gpt_vocab::id gpt_sample_top_k_top_p_repeat(
 // Audio utils
 //
 
-// Write PCM data into WAV audio file
+// Write PCM data into WAV audio file. Samples are collected in a block
+// buffer and written a block at a time; the RIFF sizes are patched on
+// flush(), close() and after every header_interval bytes of audio, so a
+// crash loses at most that much of the file's declared length. With
+// background = true, full blocks are swapped into a fixed ring that a helper
+// thread writes out, so write() neither waits on the disk, takes a lock nor
+// allocates. If the disk falls ring_blocks behind, the blocks that do not fit
+// are dropped (write() returns false and dropped() counts them) rather than
+// stalling the producer.
 class wav_writer {
 private:
+    static constexpr size_t block_samples = 32768;          // 64 KiB per write
+    static constexpr uint32_t header_interval = 1u << 20;   // bytes between header patches
+    static constexpr size_t ring_blocks = 16;               // 1 MiB in flight in the background
+
     std::ofstream file;
     uint32_t dataSize = 0;
+    uint32_t unpatchedSize = 0;  // bytes written since the header was last patched
     std::string wav_filename;
+    std::vector<int16_t> block;
+    std::atomic<bool> failed{false};  // set by whichever thread writes
+
+    // Background writing: a single-producer ring of preallocated blocks.
+    // write() swaps its full block with the empty one in slot head and
+    // publishes it; the writer thread writes slots up to head, empties them
+    // and advances tail. signal wakes the writer for new blocks and on stop.
+    bool background = false;
+    std::thread writer;
+    std::vector<std::vector<int16_t>> ring;
+    std::atomic<size_t> ring_head{0};
+    std::atomic<size_t> ring_tail{0};
+    std::atomic<uint32_t> signal{0};
+    std::atomic<bool> stopping{false};
+    uint64_t dropped_samples = 0;
 
     bool write_header(const uint32_t sample_rate,
                       const uint16_t bits_per_sample,
@@ -168,66 +310,209 @@ private:
         return true;
     }
 
-    // It is assumed that PCM data is normalized to a range from -1 to 1
-    bool write_audio(const float * data, size_t length) {
-        for (size_t i = 0; i < length; ++i) {
-            const int16_t intSample = int16_t(data[i] * 32767);
-            file.write(reinterpret_cast<const char *>(&intSample), sizeof(int16_t));
-            dataSize += sizeof(int16_t);
+    void patch_header() {
+        file.seekp(4, std::ios::beg);
+        uint32_t fileSize = 36 + dataSize;
+        file.write(reinterpret_cast<char *>(&fileSize), 4);
+        file.seekp(40, std::ios::beg);
+        file.write(reinterpret_cast<char *>(&dataSize), 4);
+        file.seekp(0, std::ios::end);
+        unpatchedSize = 0;
+    }
+
+    // Called by whichever thread owns the file at the time
+    void write_samples(const int16_t * data, size_t length) {
+        const uint32_t bytes = static_cast<uint32_t>(length * sizeof(int16_t));
+        file.write(reinterpret_cast<const char *>(data), bytes);
+        if (!file) {
+            failed = true;
+            return;
         }
-        if (file.is_open()) {
-            file.seekp(4, std::ios::beg);
-            uint32_t fileSize = 36 + dataSize;
-            file.write(reinterpret_cast<char *>(&fileSize), 4);
-            file.seekp(40, std::ios::beg);
-            file.write(reinterpret_cast<char *>(&dataSize), 4);
-            file.seekp(0, std::ios::end);
+        dataSize += bytes;
+        unpatchedSize += bytes;
+        if (unpatchedSize >= header_interval) {
+            patch_header();
         }
-        return true;
     }
 
-    bool open_wav(const std::string & filename) {
-        if (filename != wav_filename) {
-            if (file.is_open()) {
-                file.close();
+    void writer_loop() {
+        size_t tail = ring_tail.load(std::memory_order_relaxed);
+        while (true) {
+            // Read signal before head, so a block published after the check
+            // changes it and the wait returns at once
+            const uint32_t seen = signal.load(std::memory_order_acquire);
+            if (ring_head.load(std::memory_order_acquire) == tail) {
+                if (stopping.load(std::memory_order_acquire)) {
+                    return;
+                }
+                signal.wait(seen, std::memory_order_acquire);
+                continue;
             }
+            std::vector<int16_t> & data = ring[tail % ring_blocks];
+            write_samples(data.data(), data.size());
+            data.clear();
+            ring_tail.store(++tail, std::memory_order_release);
+            ring_tail.notify_all();
         }
-        if (!file.is_open()) {
-            file.open(filename, std::ios::binary);
-            wav_filename = filename;
-            dataSize = 0;
+    }
+
+    void wake_writer() {
+        signal.fetch_add(1, std::memory_order_release);
+        signal.notify_one();
+    }
+
+    // Until the writer thread has written all but `behind` published blocks
+    void wait_for_writer(size_t behind) {
+        const size_t head = ring_head.load(std::memory_order_relaxed);
+        for (size_t tail = ring_tail.load(std::memory_order_acquire); head - tail > behind;
+             tail = ring_tail.load(std::memory_order_acquire)) {
+            ring_tail.wait(tail, std::memory_order_acquire);
         }
-        return file.is_open();
+    }
+
+    // Hand the current block to the file (directly or via the writer
+    // thread). With the ring full the block is dropped, unless wait is set.
+    void submit_block(bool wait = false) {
+        if (block.empty()) {
+            return;
+        }
+        if (!background) {
+            write_samples(block.data(), block.size());
+            block.clear();
+            return;
+        }
+        const size_t head = ring_head.load(std::memory_order_relaxed);
+        if (wait) {
+            wait_for_writer(ring_blocks - 1);
+        } else if (head - ring_tail.load(std::memory_order_acquire) >= ring_blocks) {
+            dropped_samples += block.size();
+            block.clear();
+            return;
+        }
+        block.swap(ring[head % ring_blocks]);  // the slot's emptied block keeps its capacity
+        ring_head.store(head + 1, std::memory_order_release);
+        wake_writer();
+    }
+
+    // Space left in the current block, submitting it first if full
+    size_t block_space() {
+        if (block.size() >= block_samples) {
+            submit_block();
+        }
+        return block_samples - block.size();
+    }
+
+    void stop_writer() {
+        if (!writer.joinable()) {
+            return;
+        }
+        stopping.store(true, std::memory_order_release);
+        wake_writer();
+        writer.join();
+        stopping = false;
+        ring_head = 0;
+        ring_tail = 0;
     }
 
 public:
     bool open(const std::string & filename,
               const    uint32_t   sample_rate,
               const    uint16_t   bits_per_sample,
-              const    uint16_t   channels) {
+              const    uint16_t   channels,
+              const    bool       write_in_background = false) {
 
-        if (open_wav(filename)) {
-            write_header(sample_rate, bits_per_sample, channels);
-        } else {
+        close();
+        file.open(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
             return false;
         }
-
+        wav_filename = filename;
+        dataSize = 0;
+        unpatchedSize = 0;
+        failed = false;
+        dropped_samples = 0;
+        block.clear();
+        block.reserve(block_samples);
+        write_header(sample_rate, bits_per_sample, channels);
+
+        background = write_in_background;
+        if (background) {
+            // Touch every slot now so write() does not page-fault on them later
+            ring.resize(ring_blocks);
+            for (auto & slot : ring) {
+                slot.resize(block_samples);
+                slot.clear();
+            }
+            writer = std::thread(&wav_writer::writer_loop, this);
+        }
         return true;
     }
 
+    // Write buffered samples out and bring the header up to date. Waits for
+    // the writer thread, which is idle afterwards until the next block.
+    bool flush() {
+        if (!file.is_open()) {
+            return false;
+        }
+        submit_block(true);
+        wait_for_writer(0);
+        patch_header();
+        file.flush();
+        return !failed && file.good();
+    }
+
     bool close() {
+        if (!file.is_open()) {
+            return true;
+        }
+        const bool ok = flush();
+        stop_writer();
         file.close();
-        return true;
+        if (dropped_samples > 0) {
+            fprintf(stderr, "wav_writer: %s: dropped %llu samples the disk did not keep up with\n",
+                    wav_filename.c_str(), static_cast<unsigned long long>(dropped_samples));
+        }
+        return ok && dropped_samples == 0;
     }
 
+    // Samples dropped because the background writer fell behind
+    uint64_t dropped() const {
+        return dropped_samples;
+    }
+
+    // It is assumed that PCM data is normalized to a range from -1 to 1.
+    // Returns false if the file failed or samples were dropped.
     bool write(const float * data, size_t length) {
-        return write_audio(data, length);
+        const uint64_t dropped_before = dropped_samples;
+        while (length > 0) {
+            const size_t n = std::min(length, block_space());
+            const size_t offset = block.size();
+            block.resize(offset + n);
+            pcm::float_to_int16(data, block.data() + offset, n);
+            data += n;
+            length -= n;
+        }
+        return !failed && dropped_samples == dropped_before;
     }
 
-    ~wav_writer() {
-        if (file.is_open()) {
-            file.close();
+    // 16-bit PCM written as is
+    bool write(const int16_t * data, size_t length) {
+        if (!background && block.empty() && length >= block_samples) {
+            write_samples(data, length);  // already a full block; skip the copy
+            return !failed;
+        }
+        const uint64_t dropped_before = dropped_samples;
+        while (length > 0) {
+            const size_t n = std::min(length, block_space());
+            block.insert(block.end(), data, data + n);
+            data += n;
+            length -= n;
         }
+        return !failed && dropped_samples == dropped_before;
+    }
+
+    ~wav_writer() {
+        close();
     }
 };
 
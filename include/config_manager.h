@@ -1,7 +1,9 @@
 #pragma once
 
 #include <string>
+#include <initializer_list>
 #include <optional>
+#include <vector>
 
 // JSON-based configuration manager
 #include <nlohmann/json.hpp>
@@ -39,7 +41,7 @@ public:
     
     std::string getNestedModelPath(const std::string& category, const std::string& backend, const std::string& component) const {
         try {
-            std::string pathFromConfig = config["models"][category][backend][component]["path"].get<std::string>();
+            std::string pathFromConfig = config.at("models").at(category).at(backend).at(component).at("path").get<std::string>();
             std::filesystem::path p(pathFromConfig);
             if (p.is_relative() && !configDirectory_.empty()) {
                 p = std::filesystem::path(configDirectory_) / p;
@@ -54,47 +56,342 @@ public:
         }
     }
     
-    std::string getAudioDevice() const {
+    // Returns true if an optional model component is configured and present on disk
+    bool hasNestedModelPath(const std::string& category, const std::string& backend, const std::string& component) const {
         try {
-            return config["settings"]["audio"]["alsa_device"].get<std::string>();
+            const auto& node = config.at("models").at(category).at(backend).at(component).at("path");
+            std::filesystem::path p(node.get<std::string>());
+            if (p.is_relative() && !configDirectory_.empty()) {
+                p = std::filesystem::path(configDirectory_) / p;
+            }
+            return std::filesystem::exists(p);
         } catch (const std::exception&) {
-            return "default";
+            return false;
         }
     }
     
-    int getAudioSampleRate() const {
+    // Names of the extra Paroli voices under models.tts.paroli.voices
+    std::vector<std::string> getTtsVoiceNames() const {
+        std::vector<std::string> names;
         try {
-            return config["settings"]["audio"]["sample_rate"].get<int>();
-        } catch (const std::exception& e) {
-            return 16000; // default
+            for (const auto& item : config.at("models").at("tts").at("paroli").at("voices").items()) {
+                names.push_back(item.key());
+            }
+        } catch (const std::exception&) {
         }
+        return names;
     }
     
-    int getAudioBufferMs() const {
+    // Path of one component (encoder, decoder, config) of a named Paroli voice;
+    // empty if it is not configured or missing on disk
+    std::string getTtsVoiceModelPath(const std::string& voice, const std::string& component) const {
         try {
-            return config["settings"]["audio"]["buffer_ms"].get<int>();
-        } catch (const std::exception& e) {
-            return 30000; // default
+            std::filesystem::path p(config.at("models").at("tts").at("paroli").at("voices")
+                                        .at(voice).at(component).at("path").get<std::string>());
+            if (p.is_relative() && !configDirectory_.empty()) {
+                p = std::filesystem::path(configDirectory_) / p;
+            }
+            if (!std::filesystem::exists(p)) {
+                std::cerr << "Voice " << voice << " " << component << " not found at: " << p.string() << std::endl;
+                return "";
+            }
+            return p.string();
+        } catch (const std::exception&) {
+            return "";
         }
     }
     
+    std::string getAudioDevice() const {
+        return getSetting<std::string>({"audio", "alsa_device"}, "default");
+    }
+    
+    int getAudioSampleRate() const {
+        return getSetting<int>({"audio", "sample_rate"}, 16000);
+    }
+    
+    int getAudioBufferMs() const {
+        return getSetting<int>({"audio", "buffer_ms"}, 30000);
+    }
+    
+    // Playback sink: "alsa", "null", "wav" or "memory"
+    std::string getAudioOutputSink() const {
+        return getSetting<std::string>({"audio", "output", "sink"}, "alsa");
+    }
+    
+    std::string getAudioOutputWavPath() const {
+        const std::string path = getSetting<std::string>({"audio", "output", "wav_path"}, "");
+        return path.empty() ? "tts_output.wav" : resolvePath(path);
+    }
+    
+    // Null and memory sinks consume audio at the real-time rate when true
+    bool getAudioOutputNullPaced() const {
+        return getSetting<bool>({"audio", "output", "null_paced"}, true);
+    }
+    
+    // Playback period in frames; smaller periods lower latency at the cost of wakeups
+    int getAudioOutputPeriodFrames() const {
+        return getSetting<int>({"audio", "output", "period_frames"}, 256);
+    }
+    
+    int getAudioOutputPeriods() const {
+        return getSetting<int>({"audio", "output", "periods"}, 4);
+    }
+    
+    bool getAudioOutputMmap() const {
+        return getSetting<bool>({"audio", "output", "mmap"}, false);
+    }
+    
+    // Audio kept queued in the device; writes wait once the buffer holds this much
+    int getAudioOutputTargetFillMs() const {
+        return getSetting<int>({"audio", "output", "target_fill_ms"}, 40);
+    }
+    
+    // Cancel the assistant's own playback out of the microphone signal
+    bool getAudioEchoEnabled() const {
+        return getSetting<bool>({"audio", "echo", "enabled"}, true);
+    }
+    
+    // Longest speaker-to-microphone echo path the canceller models; cost grows linearly
+    int getAudioEchoTailMs() const {
+        return getSetting<int>({"audio", "echo", "tail_ms"}, 100);
+    }
+    
+    float getAudioEchoStepSize() const {
+        return getSetting<float>({"audio", "echo", "step_size"}, 0.3f);
+    }
+    
+    // Strength of residual echo suppression after cancellation; 0 disables it
+    float getAudioEchoSuppression() const {
+        return getSetting<float>({"audio", "echo", "suppression"}, 4.0f);
+    }
+    
     float getVadThreshold() const {
-        try {
-            return config["settings"]["audio"]["vad_threshold"].get<float>();
-        } catch (const std::exception& e) {
-            return 0.6f; // default
-        }
+        return getSetting<float>({"audio", "vad_threshold"}, 0.6f);
     }
     
     int getVadCaptureMs() const {
-        try {
-            return config["settings"]["audio"]["vad_capture_ms"].get<int>();
-        } catch (const std::exception& e) {
-            return 10000; // default
-        }
+        return getSetting<int>({"audio", "vad_capture_ms"}, 10000);
+    }
+
+    // Minimum first-pass confidence at which the streaming STT result is committed
+    // without running the offline second pass
+    float getSttCommitConfidence() const {
+        return getSetting<float>({"stt", "commit_confidence"}, 0.85f);
+    }
+
+    // Number of concurrent audio sources (microphone included) decoded in one batch
+    int getSttMaxStreams() const {
+        return getSetting<int>({"stt", "max_streams"}, 1);
+    }
+
+    // Silero VAD parameters used by the sherpa STT backend
+    float getSttVadThreshold() const {
+        return getSetting<float>({"stt", "vad", "threshold"}, 0.3f);
+    }
+
+    float getSttVadMinSilenceDuration() const {
+        return getSetting<float>({"stt", "vad", "min_silence_duration"}, 0.25f); // seconds
     }
+
+    float getSttVadMinSpeechDuration() const {
+        return getSetting<float>({"stt", "vad", "min_speech_duration"}, 0.01f); // seconds
+    }
+
+    float getSttVadMaxSpeechDuration() const {
+        return getSetting<float>({"stt", "vad", "max_speech_duration"}, 8.0f); // seconds
+    }
+
+    // Streaming recognizer endpoint rules (see sherpa-onnx endpoint docs)
+    bool getSttEndpointEnabled() const {
+        return getSetting<bool>({"stt", "endpoint", "enabled"}, false);
+    }
+
+    float getSttEndpointRule1MinTrailingSilence() const {
+        return getSetting<float>({"stt", "endpoint", "rule1_min_trailing_silence"}, 2.4f); // seconds
+    }
+
+    float getSttEndpointRule2MinTrailingSilence() const {
+        return getSetting<float>({"stt", "endpoint", "rule2_min_trailing_silence"}, 1.2f); // seconds
+    }
+
+    float getSttEndpointRule3MinUtteranceLength() const {
+        return getSetting<float>({"stt", "endpoint", "rule3_min_utterance_length"}, 20.0f); // seconds
+    }
+
+    // Interrupt playback when the user starts talking over it
+    bool getSttBargeInEnabled() const {
+        return getSetting<bool>({"stt", "barge_in", "enabled"}, true);
+    }
+
+    // Speech needed before a barge-in fires, so clicks and the assistant's own
+    // voice leaking into the microphone do not cut playback short
+    int getSttBargeInMinSpeechMs() const {
+        return getSetting<int>({"stt", "barge_in", "min_speech_ms"}, 300);
+    }
+
+    // Zero padding appended after each speech segment; 0 = size it from the model
+    int getSttTailPaddingMs() const {
+        return getSetting<int>({"stt", "tail_padding_ms"}, 0);
+    }
+
+    // Number of parallel TTS synthesis workers; 0 = tune from the measured real-time factor
+    int getTtsWorkers() const {
+        return getSetting<int>({"tts", "workers"}, 0);
+    }
+
+    // Playback device rate; 0 opens the device at the voice's native rate
+    int getTtsOutputSampleRate() const {
+        return getSetting<int>({"tts", "output_sample_rate"}, 0);
+    }
+
+    // Upper bound on TTS workers (they share each voice's loaded models)
+    int getTtsMaxWorkers() const {
+        return getSetting<int>({"tts", "max_workers"}, 2);
+    }
+
+    // Synthesized-audio cache for repeated phrases
+    bool getTtsCacheEnabled() const {
+        return getSetting<bool>({"tts", "cache", "enabled"}, true);
+    }
+
+    int getTtsCacheMemoryMb() const {
+        return getSetting<int>({"tts", "cache", "memory_mb"}, 32);
+    }
+
+    // Only phrases up to this length are cached; long LLM sentences rarely repeat
+    int getTtsCacheMaxTextChars() const {
+        return getSetting<int>({"tts", "cache", "max_text_chars"}, 120);
+    }
+
+    // Directory for the on-disk tier; empty disables it
+    std::string getTtsCacheDiskPath() const {
+        return resolvePath(getSetting<std::string>({"tts", "cache", "disk_path"}, ""));
+    }
+
+    int getTtsCacheDiskMb() const {
+        return getSetting<int>({"tts", "cache", "disk_mb"}, 256);
+    }
+
+    // Word-level phoneme ID cache; also selects synthesis from phoneme IDs
+    bool getTtsPhonemeCacheEnabled() const {
+        return getSetting<bool>({"tts", "phoneme_cache", "enabled"}, true);
+    }
+
+    int getTtsPhonemeCacheMemoryKb() const {
+        return getSetting<int>({"tts", "phoneme_cache", "memory_kb"}, 1024);
+    }
+
+    // Text normalizer stage between LLM and TTS
+    bool getTtsNormalizerEnabled() const {
+        return getSetting<bool>({"tts", "normalizer", "enabled"}, true);
+    }
+
+    // Clause punctuation only ends a TTS segment once it has this many characters
+    int getTtsNormalizerMinChars() const {
+        return getSetting<int>({"tts", "normalizer", "min_chars"}, 32);
+    }
+
+    int getTtsNormalizerMaxChars() const {
+        return getSetting<int>({"tts", "normalizer", "max_chars"}, 200);
+    }
+
+    int getTtsNormalizerIdleFlushMs() const {
+        return getSetting<int>({"tts", "normalizer", "idle_flush_ms"}, 400);
+    }
+
+    // Voice used when a request does not name one ("default" = models.tts.paroli)
+    std::string getTtsDefaultVoice() const {
+        return getSetting<std::string>({"tts", "voices", "default"}, "default");
+    }
+
+    // Memory allowed for loaded voice models; idle voices are evicted beyond it
+    int getTtsVoiceMemoryBudgetMb() const {
+        return getSetting<int>({"tts", "voices", "memory_budget_mb"}, 512);
+    }
+
+    // Load the other voices in the background at startup, as far as the budget allows
+    bool getTtsVoicesPreload() const {
+        return getSetting<bool>({"tts", "voices", "preload"}, true);
+    }
+
+    // Pre-rendered acknowledgements played while a slow response is prepared
+    bool getTtsFillersEnabled() const {
+        return getSetting<bool>({"tts", "fillers", "enabled"}, true);
+    }
+
+    // Fillers play only when the expected wait for speech exceeds this
+    int getTtsFillersLatencyThresholdMs() const {
+        return getSetting<int>({"tts", "fillers", "latency_threshold_ms"}, 900);
+    }
+
+    // Filler phrases, used in turn; empty for a short chime instead
+    std::vector<std::string> getTtsFillerPhrases() const {
+        return getSetting<std::vector<std::string>>({"tts", "fillers", "phrases"}, {"Mm-hmm.", "Okay.", "Let me think.", "One moment."});
+    }
+
+    // ONNX Runtime graph optimization level for TTS models: disabled, basic, extended, all
+    std::string getTtsOnnxOptimizationLevel() const {
+        return getSetting<std::string>({"tts", "onnx", "graph_optimization_level"}, "all");
+    }
+
+    // Threads one TTS ONNX session uses inside an operator; 0 = share the
+    // cores among the synthesis workers
+    int getTtsOnnxIntraOpThreads() const {
+        return getSetting<int>({"tts", "onnx", "intra_op_threads"}, 0);
+    }
+
+    // Threads running independent operators; only used in "parallel" mode
+    int getTtsOnnxInterOpThreads() const {
+        return getSetting<int>({"tts", "onnx", "inter_op_threads"}, 1);
+    }
+
+    // Keep ONNX Runtime's CPU arena; disabling it frees memory between calls
+    bool getTtsOnnxCpuMemArena() const {
+        return getSetting<bool>({"tts", "onnx", "cpu_mem_arena"}, true);
+    }
+
+    // ONNX Runtime execution mode: "sequential" or "parallel"
+    std::string getTtsOnnxExecutionMode() const {
+        return getSetting<std::string>({"tts", "onnx", "execution_mode"}, "sequential");
+    }
+
+    // Directory for serialized optimized TTS models; empty disables the cache
+    std::string getTtsOnnxOptimizedModelDir() const {
+        return resolvePath(getSetting<std::string>({"tts", "onnx", "optimized_model_dir"}, ""));
+    }
+
 private:
     ConfigManager() = default;
     nlohmann::json config;
     std::string configDirectory_;
+
+    // Value at settings.<keys>, or fallback when the key is missing or holds
+    // another type. Walks with find() because const operator[] on a missing
+    // key is undefined behaviour in nlohmann::json.
+    template <typename T>
+    T getSetting(std::initializer_list<const char*> keys, T fallback) const {
+        auto child = [](const nlohmann::json* node, const char* key) -> const nlohmann::json* {
+            if (!node || !node->is_object()) return nullptr;
+            const auto it = node->find(key);
+            return it != node->end() ? &*it : nullptr;
+        };
+        const nlohmann::json* node = child(&config, "settings");
+        for (const char* key : keys) {
+            node = child(node, key);
+        }
+        if (!node) return fallback;
+        try {
+            return node->get<T>();
+        } catch (const std::exception&) {
+            return fallback;
+        }
+    }
+
+    // Resolve a settings path relative to the config file's directory
+    std::string resolvePath(const std::string& path) const {
+        if (!path.empty() && std::filesystem::path(path).is_relative() && !configDirectory_.empty()) {
+            return (std::filesystem::path(configDirectory_) / path).string();
+        }
+        return path;
+    }
 }; 
\ No newline at end of file
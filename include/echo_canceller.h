@@ -0,0 +1,113 @@
+#pragma once
+
+#include "resampler.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+//
+// Acoustic echo cancellation
+//
+
+// Far-end (playback) signal shared between the audio output and the capture
+// side. Playback pushes what it is about to play together with the time it
+// will be heard; capture reads back what was playing while a block was
+// recorded. Audio is kept on a continuous timeline at the capture rate, with
+// silence filled in across playback gaps.
+class EchoReference {
+public:
+    using clock = std::chrono::steady_clock;
+
+    EchoReference() = default;
+
+    // Set up by the capture side; pushes before this are ignored
+    void configure(int sample_rate, float history_seconds = 2.0f);
+    int sample_rate() const;
+
+    // Playback side: n samples at rate, the first heard at play_time
+    void push(const int16_t * data, size_t n, unsigned int rate, clock::time_point play_time);
+
+    // Audio scheduled after t will not be heard (playback was interrupted)
+    void discard_after(clock::time_point t);
+
+    // Capture side: the n reference samples heard up to end_time, zero where
+    // nothing was playing. Returns false if the whole block is silent.
+    bool read(clock::time_point end_time, size_t n, float * out);
+
+private:
+    mutable std::mutex m_mutex;
+    int m_rate = 0;
+    std::vector<float> m_ring;
+    int64_t m_written = 0;            // samples ever appended
+    clock::time_point m_end_time;     // when sample m_written will be heard
+
+    PolyphaseResampler m_resampler;
+    std::vector<float> m_scratch_in;
+    std::vector<float> m_scratch_out;
+
+    void append(const float * data, size_t n);
+};
+
+// Per-block echo canceller for the capture path: an NLMS adaptive filter over
+// the aligned reference removes the linear echo, adaptation freezes during
+// double talk (detected when a converged filter stops cancelling), and a
+// Wiener-style gain suppresses what the filter leaves behind. Blocks with no
+// reference activity are passed through at almost no cost. Not thread-safe;
+// call from the capture thread.
+class EchoCanceller {
+public:
+    struct Options {
+        int sample_rate = 16000;
+        int tail_ms = 100;           // longest echo path modelled by the filter
+        float step_size = 0.3f;      // NLMS step (0..1]
+        float suppression = 4.0f;    // residual suppression strength, 0 = off
+        float gain_floor = 0.05f;    // lowest gain applied while suppressing
+    };
+
+    // CPU cost of process(), for sizing tail_ms on small boards
+    struct Stats {
+        uint64_t blocks = 0;
+        uint64_t active_blocks = 0;  // blocks with echo to cancel
+        double total_us = 0.0;
+        double active_us = 0.0;
+        double max_us = 0.0;
+
+        void print() const {
+            std::cout << "Echo canceller blocks: " << blocks << " (" << active_blocks << " active)"
+                      << ", avg " << (active_blocks ? active_us / active_blocks : 0.0) << "us per active block"
+                      << ", avg " << (blocks ? total_us / blocks : 0.0) << "us overall"
+                      << ", max " << max_us << "us" << std::endl;
+        }
+    };
+
+    EchoCanceller(std::shared_ptr<EchoReference> reference, const Options & options);
+
+    // Cancel echo in place in a capture block whose last sample arrived at captured
+    void process(float * samples, size_t n, std::chrono::steady_clock::time_point captured);
+
+    void reset();
+    const Stats & stats() const { return m_stats; }
+
+private:
+    std::shared_ptr<EchoReference> m_reference;
+    Options m_options;
+    size_t m_taps;
+    size_t m_hangover;               // double-talk hold, in samples
+
+    std::vector<float> m_weights;    // reversed: m_weights[0] applies to the oldest sample
+    std::vector<float> m_x;          // m_taps - 1 samples of history, then the current block
+    std::vector<float> m_y;          // echo estimate for the current block
+    size_t m_quiet = 0;              // reference samples since the last non-silent block
+    size_t m_double_talk = 0;        // samples left in the double-talk hold
+    size_t m_double_talk_run = 0;    // samples the current hold has lasted
+    bool m_converged = false;
+    float m_erle = 1.0f;             // smoothed echo reduction of the filter (power ratio)
+    float m_gain = 1.0f;
+
+    Stats m_stats;
+};
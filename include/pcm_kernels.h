@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+//
+// PCM kernels
+//
+
+// Sample-wise operations on the audio path. Float audio is normalized to
+// [-1, 1]; int16 results saturate and round to nearest. Kernels that round
+// or saturate to int16, and the float ramp, have a SIMD implementation (SSE2
+// on x86-64, NEON on AArch64) chosen at compile time, matching the scalar
+// reference in pcm::scalar to within one LSB (float rounding order may
+// differ). The other float kernels are the scalar loops, which the compiler
+// vectorizes as well as intrinsics do. Buffers may be unaligned; in and out
+// must not overlap unless they are the same buffer.
+namespace pcm {
+
+// Multiply by a constant gain
+void gain(float * data, size_t n, float g);
+void gain(int16_t * data, size_t n, float g);
+
+// Gain moving linearly from `from` towards `to`; sample i is scaled by
+// from + (to - from) * (i + 1) / n, ending at `to` on the last sample
+void ramp(float * data, size_t n, float from, float to);
+void ramp(int16_t * data, size_t n, float from, float to);
+
+void clamp(float * data, size_t n, float lo, float hi);
+
+// out = in * scale, rounded and saturated; the default maps [-1, 1] to int16
+void float_to_int16(const float * in, int16_t * out, size_t n, float scale = 32767.0f);
+
+// out = in * scale; the default maps int16 to [-1, 1)
+void int16_to_float(const int16_t * in, float * out, size_t n, float scale = 1.0f / 32768.0f);
+
+// dst += src * g
+void mix(float * dst, const float * src, size_t n, float g = 1.0f);
+void mix(int16_t * dst, const int16_t * src, size_t n, float g = 1.0f);
+
+namespace scalar {
+
+void gain(float * data, size_t n, float g);
+void gain(int16_t * data, size_t n, float g);
+void ramp(float * data, size_t n, float from, float to);
+void ramp(int16_t * data, size_t n, float from, float to);
+void clamp(float * data, size_t n, float lo, float hi);
+void float_to_int16(const float * in, int16_t * out, size_t n, float scale = 32767.0f);
+void int16_to_float(const int16_t * in, float * out, size_t n, float scale = 1.0f / 32768.0f);
+void mix(float * dst, const float * src, size_t n, float g = 1.0f);
+void mix(int16_t * dst, const int16_t * src, size_t n, float g = 1.0f);
+
+} // namespace scalar
+
+} // namespace pcm
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Word-level phoneme ID cache
+//
+
+// LRU cache of the phoneme IDs eSpeak produced for single words, so words
+// that recur across LLM chunks skip phonemization and only run the neural
+// encoder/decoder. Keys carry the voice, since voices may use different
+// eSpeak voices and ID maps. Thread-safe; one instance is shared by all
+// synthesis workers.
+class PhonemeCache {
+public:
+    struct Stats {
+        uint64_t hits        = 0;
+        uint64_t misses      = 0;
+        size_t   entries     = 0;
+        size_t   memory_used = 0;
+
+        double hit_rate() const {
+            const uint64_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
+        }
+    };
+
+    explicit PhonemeCache(size_t memory_bytes);
+
+    bool lookup(const std::string & key, std::vector<int64_t> & ids);
+
+    void insert(const std::string & key, const std::vector<int64_t> & ids);
+
+    Stats stats() const;
+
+private:
+    struct Node {
+        std::string key;
+        std::vector<int64_t> ids;
+        size_t bytes = 0;
+    };
+
+    const size_t m_memory_bytes;
+
+    mutable std::mutex m_mutex;
+    std::list<Node> m_lru; // most recently used first
+    std::unordered_map<std::string, std::list<Node>::iterator> m_index;
+    size_t m_memory_used = 0;
+
+    uint64_t m_hits   = 0;
+    uint64_t m_misses = 0;
+};
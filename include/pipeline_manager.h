@@ -19,6 +19,7 @@ struct PipelineConfig {
     size_t response_queue_size = 20;
     size_t alt_request_queue_size = 20;
     size_t alt_response_queue_size = 20;
+    size_t tts_text_queue_size = 20;
 
     // Timeouts (milliseconds)
     int audio_timeout_ms = 1000;
@@ -30,6 +31,9 @@ struct PipelineConfig {
     bool enable_llm = true;
     bool enable_tts = true;
     bool enable_alt_text = true;
+    bool enable_text_normalizer = true;
+    bool enable_barge_in = true;
+    bool enable_echo_cancel = true;
     
     // Interrupt mechanism
     std::atomic<bool>* interrupt_flag = nullptr;
@@ -91,7 +95,34 @@ public:
             }
             
             if (config_.enable_tts && tts_backend) {
-                tts_processor_ = std::make_unique<TTSProcessor>(*response_queue_, std::move(tts_backend), config_.interrupt_flag);
+                // Normalizer re-segments LLM chunks and feeds TTS through its own queue
+                SafeQueue<TextMessage>* tts_input = response_queue_.get();
+                if (config_.enable_text_normalizer) {
+                    tts_text_queue_ = std::make_unique<SafeQueue<TextMessage>>(config_.tts_text_queue_size, config_.interrupt_flag);
+                    text_normalizer_ = std::make_unique<TextNormalizerProcessor>(*response_queue_, *tts_text_queue_);
+                    tts_input = tts_text_queue_.get();
+                }
+                tts_processor_ = std::make_unique<TTSProcessor>(*tts_input, std::move(tts_backend), config_.interrupt_flag);
+            }
+            
+            // Playback doubles as the echo reference for the microphone
+            if (config_.enable_echo_cancel && stt_processor_ && tts_processor_) {
+                echo_reference_ = std::make_shared<EchoReference>();
+                stt_processor_->set_echo_reference(echo_reference_);
+                tts_processor_->set_echo_reference(echo_reference_);
+            }
+            
+            if (config_.enable_barge_in && stt_processor_ && tts_processor_) {
+                stt_processor_->set_speech_start_handler(
+                    [this](std::chrono::steady_clock::time_point onset) { barge_in(onset); });
+            }
+            
+            // Endpointing starts the response timer and may cue a filler
+            if (stt_processor_ && tts_processor_) {
+                stt_processor_->set_utterance_handler(
+                    [this](std::chrono::steady_clock::time_point endpoint) {
+                        tts_processor_->on_user_utterance(endpoint);
+                    });
             }
             
             std::cout << "[PipelineManager] Initialized successfully" << std::endl;
@@ -104,6 +135,26 @@ public:
         }
     }
     
+    /**
+     * Route TTS playback to the given sink (e.g. MemoryAudioSink in tests);
+     * call after initialize() and before start()
+     */
+    void set_audio_sink(std::shared_ptr<AudioSink> sink) {
+        if (tts_processor_) {
+            tts_processor_->set_audio_sink(std::move(sink));
+        }
+    }
+    
+    /**
+     * Receive partial transcripts while the user is still speaking;
+     * call after initialize() and before start()
+     */
+    void set_partial_transcript_handler(ISTT::PartialResultCallback handler) {
+        if (stt_processor_) {
+            stt_processor_->set_partial_handler(std::move(handler));
+        }
+    }
+    
     /**
      * Start the pipeline
      */
@@ -125,6 +176,10 @@ public:
                 throw std::runtime_error("Failed to start TTS processor");
             }
             
+            if (text_normalizer_ && !text_normalizer_->start()) {
+                throw std::runtime_error("Failed to start text normalizer");
+            }
+            
             if (llm_processor_ && !llm_processor_->start()) {
                 throw std::runtime_error("Failed to start LLM processor");
             }
@@ -157,6 +212,7 @@ public:
         // Shutdown queues to wake up any blocking processors
         if (request_queue_) request_queue_->shutdown();
         if (response_queue_) response_queue_->shutdown();
+        if (tts_text_queue_) tts_text_queue_->shutdown();
         
         // Stop processors in forward order (STT first, TTS last)
         if (stt_processor_) {
@@ -167,6 +223,10 @@ public:
             llm_processor_->stop();
         }
         
+        if (text_normalizer_) {
+            text_normalizer_->stop();
+        }
+        
         if (tts_processor_) {
             tts_processor_->stop();
         }
@@ -196,6 +256,7 @@ public:
         BaseProcessor::Stats stt_stats;
         BaseProcessor::Stats llm_stats;
         BaseProcessor::Stats tts_stats;
+        AudioOutputProcessor::OutputMetrics output_metrics;
         
         void print() const {
             std::cout << "\n=== Final Statistics ===" << std::endl;
@@ -205,6 +266,8 @@ public:
             llm_stats.print();
             std::cout << "=== TTS Stats ===" << std::endl;
             tts_stats.print();
+            std::cout << "=== Audio Output ===" << std::endl;
+            output_metrics.print();
         }
     };
     
@@ -214,21 +277,47 @@ public:
         if (stt_processor_) stats.stt_stats = stt_processor_->get_stats();
         if (llm_processor_) stats.llm_stats = llm_processor_->get_stats();
         if (tts_processor_) stats.tts_stats = tts_processor_->get_stats();
+        if (tts_processor_) stats.output_metrics = tts_processor_->get_output_metrics();
         
         return stats;
     }
 #endif
     
     /**
-     * Process a single text input (bypasses audio/STT for server mode)
+     * What the listener is hearing right now (chunk, turn, offset), from the
+     * frames written to the output less what it still has queued
      */
-    bool process_text_input(const std::string& text, std::string& response) {
+    PlaybackPosition playback_position() const {
+        return tts_processor_ ? tts_processor_->playback_position() : PlaybackPosition{};
+    }
+    
+    /**
+     * Where the last interruption cut playback, e.g. to trim the conversation
+     * history to what was actually heard
+     */
+    PlaybackPosition last_interrupt_position() const {
+        return tts_processor_ ? tts_processor_->last_interrupt_position() : PlaybackPosition{};
+    }
+    
+    /**
+     * Select the TTS voice for everything that does not name its own
+     */
+    bool set_voice(const std::string& voice) {
+        return tts_processor_ && tts_processor_->set_voice(voice);
+    }
+    
+    /**
+     * Process a single text input (bypasses audio/STT for server mode),
+     * optionally spoken in a specific voice
+     */
+    bool process_text_input(const std::string& text, std::string& response, const std::string& voice = "") {
         if (!running_ || !llm_processor_) {
             return false;
         }
         
         // Create text message and push to LLM queue
         TextMessage text_msg(text);
+        text_msg.voice = voice;
         if (!request_queue_->push(std::move(text_msg), std::chrono::milliseconds(config_.text_timeout_ms))) {
             return false;
         }
@@ -253,6 +342,7 @@ public:
         // Signal all processors directly (no queue delays)
         if (stt_processor_) stt_processor_->signal_control(ControlMessage(ControlMessage::INTERRUPT));
         if (llm_processor_) llm_processor_->signal_control(ControlMessage(ControlMessage::INTERRUPT));
+        if (text_normalizer_) text_normalizer_->signal_control(ControlMessage(ControlMessage::INTERRUPT));
         if (tts_processor_) tts_processor_->signal_control(ControlMessage(ControlMessage::INTERRUPT));
         
         auto end_time = std::chrono::high_resolution_clock::now();
@@ -262,6 +352,33 @@ public:
                   << latency.count() << "ms)" << std::endl;
     }
     
+    /**
+     * Barge-in - the user started talking over playback. Stops playback right
+     * away, then interrupts response generation and speech, but not STT,
+     * which is still transcribing the utterance that caused it. Called from
+     * the STT streaming thread.
+     */
+    void barge_in(std::chrono::steady_clock::time_point onset) {
+        if (!running_ || !tts_processor_ || !tts_processor_->is_speaking()) {
+            return;
+        }
+        
+        // The processors may be blocked waiting for input, so the device is
+        // not left to them; their signals wake them to drop what is queued
+        tts_processor_->interrupt_playback(onset);
+        
+        ControlMessage msg(ControlMessage::INTERRUPT);
+        msg.origin = onset;
+        if (llm_processor_) llm_processor_->signal_control(msg);
+        if (text_normalizer_) text_normalizer_->signal_control(msg);
+        tts_processor_->signal_control(msg);
+        
+        auto detection = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - onset);
+        std::cout << "[PipelineManager] Barge-in: interrupting playback "
+                  << detection.count() << "ms after speech onset" << std::endl;
+    }
+    
     /**
      * Immediate shutdown - signal all processors directly
      */
@@ -269,6 +386,7 @@ public:
         // Signal all processors directly (no queue delays)
         if (stt_processor_) stt_processor_->signal_control(ControlMessage(ControlMessage::SHUTDOWN));
         if (llm_processor_) llm_processor_->signal_control(ControlMessage(ControlMessage::SHUTDOWN));
+        if (text_normalizer_) text_normalizer_->signal_control(ControlMessage(ControlMessage::SHUTDOWN));
         if (tts_processor_) tts_processor_->signal_control(ControlMessage(ControlMessage::SHUTDOWN));
         
         std::cout << "[PipelineManager] Immediate shutdown signaled to all processors" << std::endl;
@@ -281,6 +399,7 @@ public:
         // Signal all processors directly (no queue delays)
         if (stt_processor_) stt_processor_->signal_control(ControlMessage(ControlMessage::FLUSH_QUEUES));
         if (llm_processor_) llm_processor_->signal_control(ControlMessage(ControlMessage::FLUSH_QUEUES));
+        if (text_normalizer_) text_normalizer_->signal_control(ControlMessage(ControlMessage::FLUSH_QUEUES));
         if (tts_processor_) tts_processor_->signal_control(ControlMessage(ControlMessage::FLUSH_QUEUES));
         
         std::cout << "[PipelineManager] Immediate flush signaled to all processors" << std::endl;
@@ -314,6 +433,7 @@ public:
     void clear_queues() {
         if (request_queue_) request_queue_->clear();
         if (response_queue_) response_queue_->clear();
+        if (tts_text_queue_) tts_text_queue_->clear();
     }
 
 private:
@@ -326,20 +446,28 @@ private:
     std::unique_ptr<SafeQueue<TextMessage>> response_queue_;
     std::unique_ptr<SafeQueue<TextMessage>> alt_request_queue_;
     std::unique_ptr<SafeQueue<TextMessage>> alt_response_queue_;
+    std::unique_ptr<SafeQueue<TextMessage>> tts_text_queue_;
 
     // Processors
     std::unique_ptr<STTProcessor> stt_processor_;
     std::unique_ptr<LLMProcessor> llm_processor_;
+    std::unique_ptr<TextNormalizerProcessor> text_normalizer_;
     std::unique_ptr<TTSProcessor> tts_processor_;
     
+    // Playback audio shared with the STT echo canceller
+    std::shared_ptr<EchoReference> echo_reference_;
+    
     
     void cleanup() {
         stt_processor_.reset();
         llm_processor_.reset();
+        text_normalizer_.reset();
         tts_processor_.reset();
+        echo_reference_.reset();
         
         request_queue_.reset();
         response_queue_.reset();
+        tts_text_queue_.reset();
     }
 };
 
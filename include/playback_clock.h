@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+
+//
+// Playback clock
+//
+
+// What the listener is hearing at a point in time
+struct PlaybackPosition {
+    bool playing = false;              // a tracked chunk is audible
+    uint64_t chunk_id = 0;             // audible chunk, 0 if none
+    uint64_t turn_id = 0;              // response the chunk belongs to
+    uint64_t chunk_frames_played = 0;  // frames of that chunk already heard
+    uint64_t chunk_frames = 0;
+    uint64_t frames_played = 0;        // everything heard since the output opened
+    unsigned int sample_rate = 0;
+    std::chrono::steady_clock::time_point time;  // when the position was taken
+
+    double chunk_ms_played() const {
+        return sample_rate ? 1000.0 * static_cast<double>(chunk_frames_played) / sample_rate : 0.0;
+    }
+};
+
+// Maps the output's frame counters to the chunks being played. The played
+// position is frames written minus the frames the sink still has queued
+// (snd_pcm_delay for ALSA), less whatever was written and then dropped.
+// Written to by the playback thread, safe to query from any thread.
+class PlaybackClock {
+public:
+    PlaybackClock() = default;
+
+    // Output (re)opened at sample_rate; written is the sink's frame counter
+    void reset(unsigned int sample_rate, uint64_t written);
+
+    // A chunk of frames is about to be written, starting at written
+    void add_chunk(uint64_t chunk_id, uint64_t turn_id, uint64_t written, uint64_t frames);
+
+    // Position given the sink's frames written and the delay of what it still
+    // has queued
+    PlaybackPosition position(uint64_t written, double delay_ms) const;
+
+    // Playback was cut: written and delay_ms were read just before the sink
+    // dropped its buffer, dropped_at is the frame counter after the drop.
+    // Returns the position at the cut, also kept as last_drop().
+    PlaybackPosition drop(uint64_t written, double delay_ms, uint64_t dropped_at);
+    PlaybackPosition last_drop() const;
+
+private:
+    struct Segment {
+        uint64_t chunk_id;
+        uint64_t turn_id;
+        uint64_t start;   // in played frames
+        uint64_t frames;
+    };
+
+    // Bounds the segment history kept for lookups
+    static constexpr size_t kMaxSegments = 64;
+
+    mutable std::mutex m_mutex;
+    unsigned int m_sample_rate = 0;
+    uint64_t m_lost = 0;   // frames written but never played
+    std::deque<Segment> m_segments;
+    PlaybackPosition m_last_drop;
+
+    PlaybackPosition locate(uint64_t played) const;
+    uint64_t played_frames(uint64_t written, double delay_ms) const;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+//
+// Polyphase resampler
+//
+
+// Streaming rational resampler (in_rate -> out_rate) shared by the capture and
+// playback paths. The rate ratio is reduced to L/M and a Kaiser-windowed sinc
+// prototype is split into L precomputed phase filters, so each output sample
+// is a single dot product with SIMD inner loops (AVX/SSE2/NEON, scalar
+// fallback). State carries over between process() calls, so audio can be fed
+// in arbitrary block sizes without clicks at block boundaries.
+class PolyphaseResampler {
+public:
+    PolyphaseResampler() = default;
+
+    // Build the filter bank for the given rates.
+    // taps_per_phase is the filter length at the input rate for upsampling;
+    // it is scaled by M/L when downsampling to keep the transition band fixed.
+    // Returns false for invalid rates or ratios too large to tabulate.
+    bool init(int in_rate, int out_rate, int taps_per_phase = 64);
+
+    // Clear history so the next block starts from silence
+    void reset();
+
+    // Resample a block, appending output samples to out
+    void process(const float * in, size_t n, std::vector<float> & out);
+
+    // int16 convenience wrapper (converts through float, clamps on output)
+    void process(const int16_t * in, size_t n, std::vector<int16_t> & out);
+
+    bool is_initialized()  const { return m_up > 0; }
+    bool is_passthrough()  const { return m_up == 1 && m_down == 1; }
+    int  in_rate()         const { return m_in_rate; }
+    int  out_rate()        const { return m_out_rate; }
+
+    // Group delay of the filter in input samples
+    size_t latency() const { return m_taps / 2; }
+
+private:
+    int m_in_rate  = 0;
+    int m_out_rate = 0;
+
+    int m_up   = 0;   // L
+    int m_down = 0;   // M
+
+    size_t m_taps = 0;          // taps per phase, padded to the SIMD width
+    std::vector<float> m_bank;  // m_up phases x m_taps, each phase reversed
+
+    // Input history (m_taps - 1 samples) followed by the current block
+    std::vector<float> m_buf;
+    size_t m_pos   = 0;  // index in m_buf of the newest input sample for the next output
+    int    m_phase = 0;  // phase of the next output sample
+
+    std::vector<float> m_scratch_in;
+    std::vector<float> m_scratch_out;
+};
@@ -1,11 +1,18 @@
 #pragma once
 
+#include <chrono>
 #include <functional>
+#include <memory>
 #include <string>
 
+class EchoReference;
+
 class ISTT {
 public:
     using ResultCallback = std::function<void(const std::string&)>;
+    using PartialResultCallback = std::function<void(const std::string&)>;
+    using SpeechStartCallback = std::function<void(std::chrono::steady_clock::time_point onset)>;
+    using UtteranceEndCallback = std::function<void(std::chrono::steady_clock::time_point endpoint)>;
 
     /// Initialize STT. Model path is retrieved internally.
     virtual bool init() = 0;
@@ -17,6 +24,27 @@ public:
     /// Stop a previously started streaming loop.
     virtual void stop_streaming() {}
 
+    /// Called from the streaming loop with the running hypothesis of the
+    /// current utterance each time it changes; the final transcript still
+    /// arrives through the result callback. Set before start_streaming().
+    /// Backends without a streaming first pass never call it.
+    virtual void set_partial_result_callback(PartialResultCallback) {}
+
+    /// Called from the streaming loop once sustained speech is detected, with
+    /// the estimated capture time of its onset. Set before start_streaming().
+    virtual void set_speech_start_callback(SpeechStartCallback) {}
+
+    /// Called from the streaming loop as soon as an utterance is endpointed
+    /// (VAD segment end or endpoint rule), before its final transcript is
+    /// decoded, with the estimated capture time of the endpoint. Set before
+    /// start_streaming(). Backends that do not call it leave the result
+    /// callback as the only endpoint signal.
+    virtual void set_utterance_end_callback(UtteranceEndCallback) {}
+
+    /// Playback signal to cancel out of the captured audio, so the assistant
+    /// can listen while it speaks. Set before start_streaming().
+    virtual void set_echo_reference(std::shared_ptr<EchoReference>) {}
+
     /// Release any resources held by STT.
     virtual void shutdown() = 0;
 };
@@ -2,14 +2,18 @@
 #pragma once
 
 #include "stt.h"
+#include "resampler.h"
+#include "echo_canceller.h"
 #include <string>
 #include <memory>
 #include <thread>
 #include <atomic>
+#include <chrono>
 #include <functional>
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <utility>
 #include <vector>
 
 // Sherpa-ONNX C++ API and PortAudio microphone helper
@@ -17,12 +21,25 @@
 #include "sherpa-onnx/csrc/microphone.h"
 
 /// Sherpa-ONNX based STT adapter with integrated microphone audio capture and VAD.
+///
+/// Recognition runs in two passes: a streaming (online) recognizer decodes each
+/// VAD window while the user is speaking and produces partials, and an optional
+/// offline recognizer (Whisper or Paraformer export) re-decodes the finished VAD
+/// segment when the streaming result's confidence is below the commit threshold.
+///
+/// Several audio sources can be recognized concurrently: the microphone is
+/// source 0 and further sources (socket clients, extra mics) are registered with
+/// add_source(). Each source has its own VAD and stream; all streams with ready
+/// frames are decoded together in one batched recognizer call.
 class SherpaSTT : public ISTT {
 public:
     /// Callback function for transcription results
     /// Called when speech is detected and transcribed
     using TranscriptionCallback = std::function<void(const std::string&)>;
 
+    /// Callback for results of sources registered with add_source()
+    using SourceResultCallback = std::function<void(int source_id, const std::string&)>;
+
     SherpaSTT() = default;
     ~SherpaSTT() = default;
 
@@ -41,22 +58,109 @@ public:
     /// Release any resources held by Sherpa-ONNX.
     void shutdown() override;
 
+    /// Report first-pass hypotheses of sources whose results go to the
+    /// streaming callback.
+    void set_partial_result_callback(PartialResultCallback callback) override {
+        partial_callback_ = std::move(callback);
+    }
+
+    /// Report sustained speech (settings.stt.barge_in.min_speech_ms) on any source.
+    void set_speech_start_callback(SpeechStartCallback callback) override {
+        speech_start_callback_ = std::move(callback);
+    }
+
+    /// Report each VAD segment end and endpoint-rule commit whose result goes
+    /// to the streaming callback.
+    void set_utterance_end_callback(UtteranceEndCallback callback) override {
+        utterance_end_callback_ = std::move(callback);
+    }
+
+    /// Cancel playback echo from the microphone (source 0).
+    void set_echo_reference(std::shared_ptr<EchoReference> reference) override {
+        echo_reference_ = std::move(reference);
+    }
+
+    /// Route results of added sources to this callback, tagged with their
+    /// source id, instead of to the streaming callback. The microphone's
+    /// results always go to the streaming callback. Set before start_streaming().
+    void set_source_result_callback(SourceResultCallback callback) {
+        source_result_callback_ = std::move(callback);
+    }
+
+    /// Capture from the microphone (default). When disabled before
+    /// start_streaming(), only sources added with add_source() are recognized.
+    void set_microphone_enabled(bool enabled) { microphone_enabled_ = enabled; }
+
+    /// Register an additional audio source.
+    /// @return source id, or -1 if all settings.stt.max_streams slots are in use
+    int add_source();
+
+    /// Feed mono float samples at the model sample rate (16 kHz) for a source
+    /// registered with add_source(). Audio is only accepted while streaming.
+    /// @return false if the source id is not active or streaming is stopped
+    bool accept_audio(int source_id, const float *samples, size_t n);
+
+    /// Release a source slot; pending speech from that source is discarded.
+    void remove_source(int source_id);
+
 private:
+    /// Per-source recognition state, owned by the streaming thread once active.
+    struct Source {
+        bool active = false;   // guarded by audio_mutex_
+        std::unique_ptr<sherpa_onnx::cxx::VoiceActivityDetector> vad;
+        std::vector<float> buffer;
+        int32_t offset = 0;
+        bool speech_started = false;
+        int32_t segment_id = 0;
+
+        // Barge-in detection for the current segment
+        std::chrono::steady_clock::time_point speech_onset;
+        int32_t speech_samples = 0;
+        bool speech_reported = false;
+
+        // Capture times of the VAD's end-of-speech edge and of the newest
+        // processed audio, for utterance end reports
+        std::chrono::steady_clock::time_point speech_end;
+        std::chrono::steady_clock::time_point last_captured;
+
+        // First-pass stream, fed window by window while speech is active
+        std::unique_ptr<sherpa_onnx::cxx::OnlineStream> live_stream;
+        std::string partial_text;
+        bool endpointed = false;  // an endpoint rule already committed part of this segment
+
+        void reset();
+    };
+
     // Runtime components
     std::unique_ptr<sherpa_onnx::cxx::OnlineRecognizer> recognizer_;
-    std::unique_ptr<sherpa_onnx::cxx::VoiceActivityDetector> vad_;
+    std::unique_ptr<sherpa_onnx::cxx::OfflineRecognizer> offline_recognizer_;
     std::unique_ptr<sherpa_onnx::Microphone> mic_;
+    std::string vad_model_path_;
+
+    // Source slots; slot 0 is the microphone
+    std::vector<Source> sources_;
+    int max_streams_ = 1;
 
-    // Audio capture state (PortAudio callback → internal queue)
+    // Audio capture state (PortAudio callback / accept_audio → internal queue)
     std::mutex audio_mutex_;
     std::condition_variable audio_cv_;
-    std::queue<std::vector<float>> audio_queue_;
+    struct CapturedAudio {
+        int source_id;
+        std::vector<float> samples;
+        std::chrono::steady_clock::time_point captured;  // arrival of the last sample
+    };
+    std::queue<CapturedAudio> audio_queue_;
 
     // Streaming state
     TranscriptionCallback callback_;
+    SourceResultCallback source_result_callback_;
+    PartialResultCallback partial_callback_;
+    SpeechStartCallback speech_start_callback_;
+    UtteranceEndCallback utterance_end_callback_;
     std::thread streaming_thread_;
     std::atomic<bool> streaming_{false};
     std::atomic<bool> stop_streaming_{false};
+    bool microphone_enabled_ = true;
 
     // Audio sample rates:
     // - mic_sample_rate_: actual PortAudio/device sampling rate
@@ -65,12 +169,65 @@ private:
     int model_sample_rate_ = 16000;
 
     // Optional resampler used when mic_sample_rate_ != model_sample_rate_
-    sherpa_onnx::cxx::LinearResampler resampler_;
+    PolyphaseResampler resampler_;
+    std::vector<float> resampled_;
+
+    // Echo cancellation on the microphone at the model rate, before VAD
+    std::shared_ptr<EchoReference> echo_reference_;
+    std::unique_ptr<EchoCanceller> echo_canceller_;
 
     int window_size_ = 512;
 
+    // Speech a segment must reach before speech_start_callback_ fires, and
+    // the VAD's own onset delay (min_speech_duration), in samples
+    int32_t barge_in_min_samples_ = 0;
+    int32_t vad_onset_delay_samples_ = 0;
+
+    // Zeros appended after each segment to flush the last encoder chunk;
+    // probed from the model at init unless settings.stt.tail_padding_ms is set
+    int32_t tail_padding_samples_ = 0;
+    static constexpr float kFallbackTailPaddingSeconds = 1.28f;
+
+    // First-pass results at or above this confidence skip the offline second pass
+    float commit_confidence_ = 0.85f;
+
+    // Audio kept from before VAD onset and fed to the first-pass stream (seconds)
+    static constexpr float kPreRollSeconds = 0.5f;
+
+#ifdef ENABLE_STATS_LOGGING
+    // Batched decode timings indexed by batch size, for throughput vs N
+    struct BatchStats {
+        uint64_t calls = 0;
+        double total_ms = 0.0;
+    };
+    std::vector<BatchStats> batch_stats_;
+    void print_batch_stats() const;
+#endif
+
     void streaming_loop();
 
+    // Run VAD over newly buffered audio of one source and feed its live stream
+    // (captured: arrival time of the last of those samples)
+    void process_vad(Source &src, const float *samples, size_t n,
+                     std::chrono::steady_clock::time_point captured);
+
+    // Decode all streams with ready frames in batched recognizer calls
+    void decode_ready_streams();
+
+    // Finalize and emit every VAD segment completed by a source
+    void finish_segments(Source &src, const std::vector<float> &tail_paddings);
+
+    // Whether a source's results go to callback_ rather than source_result_callback_
+    bool reports_to_streaming_callback(int source_id) const {
+        return source_id == 0 || !source_result_callback_;
+    }
+
+    // Deliver a final result to the callback that owns the source
+    void emit_result(int source_id, const std::string &text);
+
+    // Re-decode a finished VAD segment with the offline recognizer
+    std::string decode_second_pass(const std::vector<float>& samples);
+
     // PortAudio microphone callback (static member, implemented in .cpp)
     static int PortAudioCallback(const void *input_buffer,
                                  void *output_buffer,
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//
+// TTS text normalization
+//
+
+// Rule-based normalizer for LLM output before synthesis. Strips markdown and
+// HTML, expands numbers (cardinals, decimals, ordinals, thousands separators,
+// negatives), fractions, currency, percentages, clock times, ISO and slash
+// dates, years after temporal prepositions, decades, phone and version
+// numbers, unit abbreviations after numbers, common abbreviations and symbols
+// into words eSpeak reads correctly and quickly.
+class TextNormalizer {
+public:
+    static std::string normalize(const std::string & text);
+
+    // English words for an integer, e.g. 1204 -> "one thousand two hundred four"
+    static std::string number_to_words(unsigned long long n);
+};
+
+// Re-segments a stream of LLM text chunks at safe prosodic boundaries:
+// sentence ends, or clause punctuation once a segment has min_chars, or the
+// last space before max_chars. A boundary needs the following character to
+// be known, so "3." followed later by "5 liters" never splits the number, and
+// abbreviations such as "Dr." or initials do not end a sentence.
+class TextSegmenter {
+public:
+    explicit TextSegmenter(size_t min_chars = 32, size_t max_chars = 200)
+        : m_min_chars(min_chars), m_max_chars(max_chars) {}
+
+    // Append a chunk and return the segments that are now complete
+    std::vector<std::string> push(const std::string & chunk);
+
+    // Return whatever is buffered (end of response or idle) and clear it
+    std::string flush();
+
+    void reset() { m_buffer.clear(); }
+    bool empty() const { return m_buffer.find_first_not_of(" \t\r\n") == std::string::npos; }
+
+private:
+    size_t m_min_chars;
+    size_t m_max_chars;
+    std::string m_buffer;
+
+    // Length of the first complete segment in m_buffer, or 0 if none
+    size_t find_boundary() const;
+};
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -13,6 +16,20 @@ struct PhonemeTimingInfo {
     float duration_seconds;
 };
 
+// One incrementally synthesized piece of a speak_stream() call
+struct TTSStreamChunk {
+    std::vector<int16_t> audio;
+    unsigned int sample_rate = 0;
+    std::vector<PhonemeTimingInfo> phoneme_timings;  // filled when requested
+    bool last = false;                               // final chunk of the text
+};
+
+// Receives each chunk as soon as it is synthesized; return false to stop
+using TTSChunkCallback = std::function<bool(TTSStreamChunk& chunk)>;
+
+// Polled between chunks; return true to abandon the rest of the text
+using TTSCancelCallback = std::function<bool()>;
+
 class ITTS {
 public:
   /// Initialize TTS.
@@ -32,7 +49,35 @@ public:
   /// @return true on success, false on failure.
   virtual bool speakWithPhonemeTimings(const std::string &text, async_pipeline::AudioChunkMessage& audio_chunk, std::vector<PhonemeTimingInfo>& phoneme_timings) = 0;
 
-  // TODO: Add async speak with callback for streaming audio
+  /// Speak the given text incrementally, delivering audio as it is produced.
+  /// @param text UTF-8 text to speak.
+  /// @param on_audio_chunk Called once per synthesized chunk, in order.
+  /// @param cancel Optional; checked before each chunk is synthesized.
+  /// @param with_phoneme_timings Fill TTSStreamChunk::phoneme_timings.
+  /// @return true if all chunks were delivered or synthesis was cancelled,
+  ///         false on a synthesis error.
+  virtual bool speak_stream(const std::string &text, const TTSChunkCallback& on_audio_chunk, const TTSCancelCallback& cancel = nullptr, bool with_phoneme_timings = false) = 0;
+
+  /// Create another, uninitialized instance of this backend with the same
+  /// configuration so synthesis can run on several threads at once.
+  /// @return nullptr if the backend does not support multiple instances.
+  virtual std::unique_ptr<ITTS> clone() const { return nullptr; }
+
+  /// Switch to a voice registered in the backend's configuration; an empty
+  /// name keeps the current voice. Cheap when the voice is already loaded.
+  /// @return false if the voice is unknown or fails to load.
+  virtual bool set_voice(const std::string &voice) { return voice.empty(); }
+
+  /// Start loading a voice in the background so a later set_voice() does not
+  /// load it on the synthesis path. Unknown voices are ignored.
+  virtual void preload_voice(const std::string &voice) { (void)voice; }
+
+  /// Voices set_voice() accepts, valid after init().
+  virtual std::vector<std::string> voices() const { return {}; }
+
+  /// Native output sample rate of the loaded voice, valid after init().
+  /// @return 0 if the backend does not know it in advance.
+  virtual unsigned int sample_rate() const { return 0; }
 
   /// Release any resources held by TTS.
   virtual void shutdown() = 0;
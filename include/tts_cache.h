@@ -0,0 +1,111 @@
+#pragma once
+
+#include "tts.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//
+// Synthesized audio cache
+//
+
+// Cached result of synthesizing one phrase
+struct TTSCacheEntry {
+    std::vector<int16_t> audio;
+    unsigned int sample_rate = 0;
+    std::vector<PhonemeTimingInfo> phoneme_timings;
+};
+
+// LRU cache of synthesized PCM keyed by normalized text and a model
+// fingerprint, with an optional on-disk tier so common phrases survive
+// restarts. The disk tier is also LRU: when a write (or the directory found
+// at startup) exceeds disk_bytes, the least recently used files are deleted.
+// File mtimes carry the access order across restarts. Thread-safe; one
+// instance is shared by all synthesis workers.
+class TTSAudioCache {
+public:
+    struct Options {
+        size_t memory_bytes   = 32u << 20; // in-memory budget
+        size_t max_text_chars = 120;       // longer texts are never cached
+        std::string disk_path;             // empty disables the disk tier
+        size_t disk_bytes     = 256u << 20;
+    };
+
+    struct Stats {
+        uint64_t hits        = 0;
+        uint64_t disk_hits   = 0; // subset of hits served from disk
+        uint64_t misses      = 0;
+        size_t   entries     = 0;
+        size_t   memory_used = 0;
+        size_t   disk_files  = 0;
+        size_t   disk_used   = 0;
+
+        double hit_rate() const {
+            const uint64_t total = hits + misses;
+            return total ? static_cast<double>(hits) / total : 0.0;
+        }
+    };
+
+    // model_fingerprint identifies the voice and model files; entries made
+    // with a different fingerprint are never returned
+    TTSAudioCache(const Options & options, uint64_t model_fingerprint);
+
+    // Collapse whitespace runs and trim, so formatting differences from the
+    // LLM still hit the same entry
+    static std::string normalize(const std::string & text);
+
+    // FNV-1a fingerprint of the model files (path, size, mtime) and the
+    // contents of the voice config
+    static uint64_t fingerprint_files(const std::vector<std::string> & paths);
+
+    bool cacheable(const std::string & normalized) const;
+
+    // Look up normalized text; with_phonemes requires stored phoneme timings
+    bool lookup(const std::string & normalized, bool with_phonemes, TTSCacheEntry & out);
+
+    void insert(const std::string & normalized, const TTSCacheEntry & entry);
+
+    Stats stats() const;
+
+private:
+    struct Node {
+        std::string text;
+        TTSCacheEntry entry;
+        size_t bytes = 0;
+    };
+
+    struct DiskNode {
+        std::string path;
+        size_t bytes = 0;
+    };
+
+    Options  m_options;
+    uint64_t m_fingerprint = 0;
+
+    mutable std::mutex m_mutex;
+    std::list<Node> m_lru; // most recently used first
+    std::unordered_map<std::string, std::list<Node>::iterator> m_index;
+    size_t m_memory_used = 0;
+
+    std::list<DiskNode> m_disk_lru; // most recently used first
+    std::unordered_map<std::string, std::list<DiskNode>::iterator> m_disk_index;
+    size_t m_disk_used = 0;
+
+    uint64_t m_hits      = 0;
+    uint64_t m_disk_hits = 0;
+    uint64_t m_misses    = 0;
+
+    void insert_locked(const std::string & normalized, const TTSCacheEntry & entry);
+    std::string disk_file(const std::string & normalized) const;
+    bool read_disk(const std::string & normalized, TTSCacheEntry & out) const;
+    void write_disk(const std::string & normalized, const TTSCacheEntry & entry);
+    bool touch_disk_locked(const std::string & path);
+    // Drop least recently used files until the disk tier fits disk_bytes;
+    // the caller deletes the returned paths outside the lock
+    void evict_disk_locked(std::vector<std::string> & evicted);
+};
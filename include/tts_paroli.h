@@ -1,11 +1,14 @@
 #pragma once
 
 #include "tts.h"
+#include "tts_cache.h"
+#include "phoneme_cache.h"
 #include <string>
 #include <memory>
 
-// Forward declaration
-class ParoliSynthesizer;
+// Forward declarations
+struct ParoliVoice;
+class ParoliVoicePool;
 
 class TTSParoli : public ITTS {
 public:
@@ -16,7 +19,15 @@ public:
     bool speak(const std::string &text, async_pipeline::AudioChunkMessage& audio_chunk) override;
     bool speakWithPhonemeTimings(const std::string &text, async_pipeline::AudioChunkMessage& audio_chunk, std::vector<PhonemeTimingInfo>& phoneme_timings) override;
 
-    // TODO: Add async speak with callback for streaming audio
+    bool speak_stream(const std::string &text, const TTSChunkCallback& on_audio_chunk, const TTSCancelCallback& cancel = nullptr, bool with_phoneme_timings = false) override;
+
+    std::unique_ptr<ITTS> clone() const override;
+
+    bool set_voice(const std::string &voice) override;
+    void preload_voice(const std::string &voice) override;
+    std::vector<std::string> voices() const override;
+
+    unsigned int sample_rate() const override;
 
     void shutdown() override;
 
@@ -25,5 +36,26 @@ private:
     std::string decoder_path;
     std::string config_path;
     std::string espeak_data_path;
-    std::unique_ptr<ParoliSynthesizer> synthesizer;
+    std::shared_ptr<ParoliVoice> synthesizer;  // pool's voice_name, shared with other workers
+    std::shared_ptr<ParoliVoicePool> pool;     // shared with clones
+    std::string voice_name;
+    std::shared_ptr<TTSAudioCache> cache;          // shared with clones; null when disabled
+    std::shared_ptr<PhonemeCache> phoneme_cache;   // shared with clones; null when disabled
+
+    // Synthesize one utterance, serving repeats from the audio cache
+    bool synthesize(const std::string &text, bool with_phoneme_timings, TTSCacheEntry& out);
+
+#ifdef ENABLE_STATS_LOGGING
+    // Per-call synthesis latency, split by whether the audio cache served the
+    // text and whether it was synthesized from text or from phoneme IDs
+    struct SynthesisStats {
+        uint64_t calls = 0;
+        uint64_t chars = 0;
+        double total_ms = 0.0;
+        double audio_seconds = 0.0;
+    };
+    SynthesisStats synthesized_stats;
+    SynthesisStats phoneme_id_stats;
+    SynthesisStats cached_stats;
+#endif
 };
@@ -1,5 +1,6 @@
 #include "pipeline_manager.h"
 #include "async_pipeline_factory.h"
+#include "config_manager.h"
 
 // Backend includes
 #ifdef USE_WHISPER
@@ -110,6 +111,10 @@ std::unique_ptr<PipelineManager> PipelineFactory::create_pipeline(PipelineMode m
             break;
     }
     
+    config.enable_text_normalizer = ConfigManager::getInstance().getTtsNormalizerEnabled();
+    config.enable_barge_in = ConfigManager::getInstance().getSttBargeInEnabled();
+    config.enable_echo_cancel = ConfigManager::getInstance().getAudioEchoEnabled();
+    
     // Create pipeline with the configured settings
     auto pipeline = std::make_unique<PipelineManager>(config);
     
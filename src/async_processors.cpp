@@ -1,33 +1,17 @@
 #include "async_processors.h"
+#include "config_manager.h"
+#include "pcm_kernels.h"
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <iostream>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
 
 namespace async_pipeline {
 
-// Helper functions
-inline void fade_and_trim_tail_ms(AudioChunkMessage& m, double fade_ms, double fade_strength, int channels = 1) {
-    if (fade_ms <= 0 || m.sample_rate == 0 || channels <= 0) return;
-
-    const size_t per_ch = static_cast<size_t>(std::llround(fade_ms * m.sample_rate / 1000.0));
-    const size_t total  = per_ch * static_cast<size_t>(channels);
-    if (total == 0 || total >= m.audio_data.size()) { 
-        m.audio_data.clear(); 
-        return; 
-    }
-
-    // Map fade_strength [0–100] → curve exponent [1–5]
-    float exponent = 1.0f + (fade_strength / 25.0f); // e.g. 0→1.0, 100→5.0
-    const size_t start = m.audio_data.size() - total;
-
-    for (size_t i = 0; i < total; ++i) {
-        float t = static_cast<float>(i + 1) / static_cast<float>(total);
-        float g = std::pow(1.0f - t, exponent);
-        int32_t v = static_cast<int32_t>(std::lround(m.audio_data[start + i] * g));
-        m.audio_data[start + i] = static_cast<int16_t>(std::clamp(v, -32768, 32767));
-    }
-
-    m.audio_data.resize(start); // trim off faded tail
-}
+// Headroom applied to the real-time factor when choosing the TTS worker count
+constexpr double kTtsWorkerHeadroom = 1.2;
 
 // STTProcessor implementation
 STTProcessor::STTProcessor(SafeQueue<TextMessage>& output_queue, std::unique_ptr<ISTT> stt_backend)
@@ -52,6 +36,12 @@ bool STTProcessor::initialize() {
             return;
         }
 
+        // Fall back to the transcript time when the backend did not report
+        // the endpoint itself
+        if (!endpoint_reported_.exchange(false) && utterance_handler_) {
+            utterance_handler_(std::chrono::steady_clock::now());
+        }
+
         TextMessage text_msg(text);
         if (!output_queue_.push_blocking(std::move(text_msg))) {
             return;
@@ -60,6 +50,22 @@ bool STTProcessor::initialize() {
         std::cout << "[STTProcessor] → " << text << std::endl;
     };
 
+    if (speech_start_handler_) {
+        stt_->set_speech_start_callback(speech_start_handler_);
+    }
+    if (partial_handler_) {
+        stt_->set_partial_result_callback(partial_handler_);
+    }
+    if (utterance_handler_) {
+        stt_->set_utterance_end_callback([this](std::chrono::steady_clock::time_point endpoint) {
+            endpoint_reported_ = true;
+            utterance_handler_(endpoint);
+        });
+    }
+    if (echo_reference_) {
+        stt_->set_echo_reference(echo_reference_);
+    }
+
     if (!stt_->start_streaming(callback)) {
         std::cerr << "[STTProcessor] STT backend failed to start streaming audio" << std::endl;
         return false;
@@ -131,8 +137,10 @@ bool LLMProcessor::initialize() {
 bool LLMProcessor::handle_control_message(const ControlMessage& msg) {
     if (msg.type == ControlMessage::INTERRUPT || 
         msg.type == ControlMessage::FLUSH_QUEUES) {
-        // Flush input and output queues
-        size_t input_flushed = input_queue_.flush();
+        // Flush input and output queues. A barge-in (origin set) keeps the
+        // input: the utterance that caused it may already be waiting there.
+        const bool barge_in = msg.origin != std::chrono::steady_clock::time_point{};
+        size_t input_flushed = barge_in ? 0 : input_queue_.flush();
         size_t output_flushed = output_queue_.flush();
         
         // Flush alt queues if they exist
@@ -177,14 +185,20 @@ void LLMProcessor::process() {
         bool first_message = true;
         
         success = llm_->generate_async(input_msg.text, response, 
-            [this, start_time, &first_message](const std::string& text_chunk) {
+            [this, start_time, &first_message, &input_msg](const std::string& text_chunk) {
                 // Create response message
                 TextMessage response_msg(text_chunk);
+                response_msg.voice = input_msg.voice;
                 
                 // Calculate processing time for this message
                 auto end_time = std::chrono::steady_clock::now();
                 auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
                 
+                // Interrupted: the rest of this response is not wanted
+                if (is_interrupt_requested()) {
+                    return;
+                }
+                
                 if(first_message) {
                     auto n = stats_.messages_processed++;
                     auto current_avg = stats_.avg_processing_time.count();
@@ -206,9 +220,15 @@ void LLMProcessor::process() {
             });
 #else
         success = llm_->generate_async(input_msg.text, response, 
-            [this](const std::string& text_chunk) {
+            [this, &input_msg](const std::string& text_chunk) {
+                // Interrupted: the rest of this response is not wanted
+                if (is_interrupt_requested()) {
+                    return;
+                }
+                
                 // Create response message
                 TextMessage response_msg(text_chunk);
+                response_msg.voice = input_msg.voice;
                 
                 // Push to output queue with blocking push
                 if (!output_queue_.push_blocking(std::move(response_msg))) {
@@ -223,6 +243,12 @@ void LLMProcessor::process() {
         if (!success) {
             std::cerr << "[LLMProcessor] Failed to generate response for: " << input_msg.text << std::endl;
         }
+        
+        // Let downstream stages flush text held back for segmentation
+        TextMessage end_msg;
+        end_msg.end_of_response = true;
+        end_msg.voice = input_msg.voice;
+        output_queue_.push_blocking(std::move(end_msg));
     } else if (result == PopResult::SHUTDOWN) {
         // Queue is shutting down, stop processing
         return;
@@ -239,6 +265,119 @@ void LLMProcessor::cleanup() {
     std::cout << "[LLMProcessor] Cleanup completed" << std::endl;
 }
 
+// TextNormalizerProcessor implementation
+TextNormalizerProcessor::TextNormalizerProcessor(SafeQueue<TextMessage>& input_queue, SafeQueue<TextMessage>& output_queue)
+    : BaseProcessor("TextNormalizerProcessor"), input_queue_(input_queue), output_queue_(output_queue) {
+}
+
+bool TextNormalizerProcessor::initialize() {
+    auto& config = ConfigManager::getInstance();
+    segmenter_ = TextSegmenter(static_cast<size_t>(std::max(0, config.getTtsNormalizerMinChars())),
+                               static_cast<size_t>(std::max(1, config.getTtsNormalizerMaxChars())));
+    idle_flush_ = std::chrono::milliseconds(std::max(1, config.getTtsNormalizerIdleFlushMs()));
+    
+    std::cout << "[TextNormalizerProcessor] Initialized successfully" << std::endl;
+    return true;
+}
+
+bool TextNormalizerProcessor::handle_control_message(const ControlMessage& msg) {
+    if (msg.type == ControlMessage::INTERRUPT || 
+        msg.type == ControlMessage::FLUSH_QUEUES) {
+        size_t flushed = input_queue_.flush();
+        segmenter_.reset();
+        if (flushed > 0) {
+            std::cout << "[TextNormalizerProcessor] Flushed " << flushed << " pending text messages" << std::endl;
+        }
+        return true; // Handled
+    }
+    return false; // Not handled, use default behavior
+}
+
+void TextNormalizerProcessor::process() {
+    // Check if we should stop processing
+    if (!is_running()) {
+        return;
+    }
+    
+    TextMessage text_msg;
+    PopResult result = input_queue_.pop(text_msg, idle_flush_);
+    
+    if (result == PopResult::SUCCESS) {
+        if (text_msg.end_of_response) {
+            // Pass the marker on so TTS can tell responses (turns) apart
+            if (emit_segment(segmenter_.flush())) {
+                output_queue_.push_blocking(std::move(text_msg));
+            }
+            return;
+        }
+        if (text_msg.voice != voice_) {
+            // Segments never mix voices
+            if (!emit_segment(segmenter_.flush())) {
+                return;
+            }
+            voice_ = text_msg.voice;
+        }
+#ifdef ENABLE_STATS_LOGGING
+        chunks_in_++;
+        chars_in_ += text_msg.text.size();
+#endif
+        for (const auto& segment : segmenter_.push(text_msg.text)) {
+            if (!emit_segment(segment)) {
+                return;
+            }
+        }
+    } else if (result == PopResult::TIMEOUT) {
+        // Producer went quiet without an end marker; speak what we have
+        if (!segmenter_.empty()) {
+            emit_segment(segmenter_.flush());
+        }
+    } else if (result == PopResult::SHUTDOWN) {
+        // Queue is shutting down, stop processing
+        return;
+    } else if (result == PopResult::INTERRUPTED) {
+        // External interrupt requested, continue to check control messages
+        return;
+    }
+}
+
+bool TextNormalizerProcessor::emit_segment(const std::string& raw) {
+#ifdef ENABLE_STATS_LOGGING
+    auto start_time = std::chrono::steady_clock::now();
+#endif
+    std::string text;
+    try {
+        text = TextNormalizer::normalize(raw);
+    } catch (const std::exception& e) {
+        // Speak the text as written rather than lose the segment
+        std::cerr << "[TextNormalizerProcessor] Normalization failed (" << e.what() << "): " << raw << std::endl;
+        text = raw;
+    }
+#ifdef ENABLE_STATS_LOGGING
+    normalize_ms_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+#endif
+    
+    // Nothing speakable (markup only, stray punctuation)
+    if (std::none_of(text.begin(), text.end(), [](unsigned char c) { return std::isalnum(c) || c >= 0x80; })) {
+        return true;
+    }
+    
+#ifdef ENABLE_STATS_LOGGING
+    segments_out_++;
+#endif
+    TextMessage text_msg(std::move(text));
+    text_msg.voice = voice_;
+    return output_queue_.push_blocking(std::move(text_msg));
+}
+
+void TextNormalizerProcessor::cleanup() {
+#ifdef ENABLE_STATS_LOGGING
+    std::cout << "[TextNormalizerProcessor] " << chunks_in_ << " LLM chunks -> " << segments_out_
+              << " TTS segments, " << chars_in_ << " chars normalized in " << normalize_ms_ << " ms ("
+              << (normalize_ms_ > 0.0 ? chars_in_ / normalize_ms_ / 1000.0 : 0.0) << " MB/s)" << std::endl;
+#endif
+    std::cout << "[TextNormalizerProcessor] Cleanup completed" << std::endl;
+}
+
 // TTSProcessor implementation
 TTSProcessor::TTSProcessor(SafeQueue<TextMessage>& input_queue, std::unique_ptr<ITTS> tts_backend, std::atomic<bool>* interrupt_flag)
     : BaseProcessor("TTSProcessor"), input_queue_(input_queue),
@@ -266,13 +405,36 @@ bool TTSProcessor::initialize() {
         return false;
     }
             
+    // Open playback at the voice's own rate when possible so chunks need no conversion
+    unsigned int output_rate = static_cast<unsigned int>(std::max(0, ConfigManager::getInstance().getTtsOutputSampleRate()));
+    if (output_rate == 0) {
+        output_rate = tts_->sample_rate() ? tts_->sample_rate() : 22050;
+    }
+    
     // Initialize AudioOutputProcessor with the queue
-    audio_output_processor_ = std::make_unique<AudioOutputProcessor>(*audio_output_queue_);
+    audio_output_processor_ = std::make_unique<AudioOutputProcessor>(*audio_output_queue_, output_rate, audio_sink_);
+    audio_output_processor_->set_echo_reference(echo_reference_);
+    audio_output_processor_->set_playback_callback(
+        [this](uint64_t chunk_id, std::chrono::steady_clock::time_point start_time) {
+            on_chunk_playback(chunk_id, start_time);
+        });
+    audio_output_processor_->set_idle_callback(
+        [this](std::chrono::steady_clock::time_point end_time) {
+            on_playback_idle(end_time);
+        });
     if (!audio_output_processor_->start()) {
         std::cerr << "[TTSProcessor] Failed to start AudioOutputProcessor" << std::endl;
         return false;
     }
 
+    // tts_ is worker 0's backend, so render before the workers start
+    render_fillers();
+
+    if (!start_workers()) {
+        std::cerr << "[TTSProcessor] Failed to start synthesis workers" << std::endl;
+        return false;
+    }
+
     // Setup Unix socket for face control
     if (!setup_unix_socket()) {
         std::cerr << "[TTSProcessor] Failed to setup Unix socket" << std::endl;
@@ -287,6 +449,14 @@ bool TTSProcessor::initialize() {
     
     face_shown_ = false;
     
+    // Start in the configured default voice when the backend has several
+    const std::string default_voice = ConfigManager::getInstance().getTtsDefaultVoice();
+    const auto voices = tts_->voices();
+    if (std::find(voices.begin(), voices.end(), default_voice) != voices.end()) {
+        std::lock_guard<std::mutex> lock(voice_mutex_);
+        voice_ = default_voice;
+    }
+    
     std::cout << "[TTSProcessor] Initialized successfully with audio output processor" << std::endl;
     return true;
 }
@@ -299,8 +469,25 @@ bool TTSProcessor::handle_control_message(const ControlMessage& msg) {
         if (flushed > 0) {
             std::cout << "[TTSProcessor] Interrupted! Flushed " << flushed << " pending TTS messages" << std::endl;
         }
-        // Stop current speech gracefully
-        interrupt_current_speech();
+        // Drop synthesis in flight and anything not yet played
+        cancel_pending_jobs();
+        if (msg.origin == std::chrono::steady_clock::time_point{}) {
+            // Stop current speech gracefully; the rest of the response is
+            // dropped, so new text starts a new turn
+            interrupt_current_speech();
+        } else if (audio_output_queue_) {
+            // Barge-in: interrupt_playback() already stopped the device; only
+            // audio queued since then is left to drop
+            audio_output_queue_->flush();
+        }
+        if (turn_has_speech_) {
+            ++current_turn_;
+            turn_has_speech_ = false;
+        }
+        {
+            std::lock_guard<std::mutex> lock(response_latency_mutex_);
+            pending_endpoint_ = {};
+        }
         std::cout << "[TTSProcessor] Interrupt handled, ready for new speech" << std::endl;
         return true; // Handled
     }
@@ -317,52 +504,49 @@ void TTSProcessor::process() {
     PopResult result = input_queue_.pop_blocking(text_msg);
     
     if (result == PopResult::SUCCESS) {
-#ifdef ENABLE_STATS_LOGGING
-        // Start timer for TTS processing
-        auto start_time = std::chrono::steady_clock::now();
-#endif
-        // Speak the chunk and get audio data
-        std::cout << "[TTSProcessor] Speaking: " << text_msg.text << std::endl;
-        
-        // Create AudioChunkMessage to receive the audio data
-        AudioChunkMessage audio_chunk;
-        bool success = false;
-        if(face_shown_) {
-            std::vector<PhonemeTimingInfo> phoneme_timings;
-            success = tts_->speakWithPhonemeTimings(text_msg.text, audio_chunk, phoneme_timings);
-            
-            // Send phoneme data to shared memory if available
-            if (success && !phoneme_timings.empty()) {
-                send_phoneme_data(phoneme_timings);
+        if (text_msg.text.empty()) {
+            // End-of-response marker: queue it behind the response's jobs so
+            // delivery fades out the held tail once all of them have played.
+            // What follows is the next turn.
+            if (turn_has_speech_) {
+                {
+                    std::lock_guard<std::mutex> lock(jobs_mutex_);
+                    SynthesisJob& marker = jobs_[next_job_seq_++];
+                    marker.generation = job_generation_.load();
+                    marker.turn_id = current_turn_;
+                    marker.done = true;
+                    marker.end_of_response = true;
+                }
+                deliver_cv_.notify_one();
+                ++current_turn_;
+                turn_has_speech_ = false;
             }
-        } else {
-            success = tts_->speak(text_msg.text, audio_chunk);
+            return;
         }
         
-        if (success && !audio_chunk.audio_data.empty()) {
-            fade_and_trim_tail_ms(audio_chunk, 325, 120);
-            // Queue the audio chunk for playback with blocking push
-            if (!audio_output_queue_->push_blocking(std::move(audio_chunk))) {
-                // Queue was shut down, stop processing
+        // Hand the chunk to the synthesis workers, keeping at most
+        // active_workers_ chunks in flight ahead of playback
+        std::unique_lock<std::mutex> lock(jobs_mutex_);
+        while (jobs_.size() >= active_workers_) {
+            if (speech_cancel_requested()) {
                 return;
-            } else {
-#ifdef ENABLE_STATS_LOGGING
-                // Calculate processing time for this message
-                auto end_time = std::chrono::steady_clock::now();
-                auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-                
-                auto n = stats_.messages_processed++;
-                auto current_avg = stats_.avg_processing_time.count();
-                if (elapsed_ms >= 0 && n > 0) {
-                    stats_.avg_processing_time = std::chrono::milliseconds(
-                        (current_avg * (n - 1) + elapsed_ms) / n
-                    );
-                }
-#endif
             }
-        } else {
-            std::cerr << "[TTSProcessor] Failed to speak: " << text_msg.text << std::endl;
+            jobs_cv_.wait_for(lock, std::chrono::milliseconds(50));
         }
+        
+        std::cout << "[TTSProcessor] Speaking: " << text_msg.text << std::endl;
+        
+        const uint64_t seq = next_job_seq_++;
+        SynthesisJob& job = jobs_[seq];
+        job.text = std::move(text_msg.text);
+        job.with_phonemes = face_shown_;
+        job.generation = job_generation_.load();
+        job.turn_id = current_turn_;
+        job.voice = text_msg.voice.empty() ? voice() : std::move(text_msg.voice);
+        turn_has_speech_ = true;
+        pending_jobs_.push_back(seq);
+        lock.unlock();
+        jobs_cv_.notify_all();
     } else if (result == PopResult::SHUTDOWN) {
         // Queue is shutting down, stop processing
         return;
@@ -374,12 +558,6 @@ void TTSProcessor::process() {
 }
 
 void TTSProcessor::cleanup() {
-    // Cleanup Unix socket
-    cleanup_socket();
-    
-    // Cleanup shared memory
-    cleanup_shared_memory();
-    
     // Ensure audio playback is interrupted and the output queue is unblocked
     if (audio_output_processor_) {
         // Stop any ongoing ALSA playback and flush pending chunks
@@ -387,13 +565,17 @@ void TTSProcessor::cleanup() {
     }
 
     if (audio_output_queue_) {
-        // Wake any blocking pop() in AudioOutputProcessor
+        // Wake any blocking pop() in AudioOutputProcessor and any worker
+        // blocked pushing into it
         audio_output_queue_->shutdown();
     }
 
+    stop_workers();
+
     // Now stop the internal audio output processor thread cleanly
     if (audio_output_processor_) {
         audio_output_processor_->stop();
+        final_output_metrics_ = audio_output_processor_->get_output_metrics();
         audio_output_processor_.reset();
     }
     // Release the queue after the processor has been stopped
@@ -401,23 +583,475 @@ void TTSProcessor::cleanup() {
         audio_output_queue_.reset();
     }
     
+    // Cleanup shared memory and the control socket once the playback thread
+    // can no longer publish to them
+    cleanup_shared_memory();
+    cleanup_socket();
+    
     if (tts_) {
         tts_->shutdown();
     }
+#ifdef ENABLE_STATS_LOGGING
+    if (barge_ins_ > 0) {
+        std::cout << "[TTSProcessor] Barge-ins: " << barge_ins_ << ", onset to playback stop avg "
+                  << barge_in_total_ms_ / barge_ins_ << "ms (max " << barge_in_max_ms_ << "ms)"
+                  << std::endl;
+    }
+    if (!fillers_.empty()) {
+        std::cout << "[TTSProcessor] Fillers played: " << fillers_played_ << std::endl;
+    }
+#endif
     std::cout << "[TTSProcessor] Cleanup completed" << std::endl;
 }
 
+void TTSProcessor::interrupt_playback(std::chrono::steady_clock::time_point origin) {
+    if (!is_running()) {
+        return;
+    }
+    cancel_pending_jobs();
+    interrupt_current_speech();
+    
+    // Playback is silent once the device plays out its last period
+    const double latency_ms = std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - origin).count();
+    std::cout << "[TTSProcessor] Speech onset to playback stop: " << latency_ms << "ms" << std::endl;
+#ifdef ENABLE_STATS_LOGGING
+    std::lock_guard<std::mutex> lock(stats_mutex_);
+    ++barge_ins_;
+    barge_in_total_ms_ += latency_ms;
+    barge_in_max_ms_ = std::max(barge_in_max_ms_, latency_ms);
+#endif
+}
+
 void TTSProcessor::interrupt_current_speech() {
     if (audio_output_processor_) {
         std::cout << "[TTSProcessor] Using immediate audio interruption" << std::endl;
         audio_output_processor_->interrupt_audio_immediately();
     }
+    cancel_pending_phonemes();
+    if (is_speaking_.exchange(false)) {
+        push_control_event("speech_interrupted " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count()));
+    }
+}
+
+bool TTSProcessor::start_workers() {
+    auto& config = ConfigManager::getInstance();
+    const int configured = config.getTtsWorkers();
+    const size_t hw_threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t wanted = configured > 0 ? static_cast<size_t>(configured)
+                                   : static_cast<size_t>(std::max(1, config.getTtsMaxWorkers()));
+    wanted = std::min(wanted, hw_threads);
+
+    // Worker 0 uses tts_; the rest get their own backend instance
+    for (size_t i = 1; i < wanted; ++i) {
+        auto backend = tts_->clone();
+        if (!backend) {
+            std::cout << "[TTSProcessor] TTS backend does not support parallel synthesis" << std::endl;
+            break;
+        }
+        if (!backend->init()) {
+            std::cerr << "[TTSProcessor] Failed to initialize TTS worker " << i << std::endl;
+            break;
+        }
+        extra_tts_.push_back(std::move(backend));
+    }
+
+    const size_t workers = 1 + extra_tts_.size();
+    auto_tune_workers_ = configured <= 0;
+    active_workers_ = auto_tune_workers_ ? 1 : workers;
+    rtf_average_ = 0.0;
+
+    workers_running_ = true;
+    delivery_thread_ = std::thread(&TTSProcessor::delivery_loop, this);
+    worker_threads_.emplace_back(&TTSProcessor::synthesis_worker, this, tts_.get());
+    for (auto& backend : extra_tts_) {
+        worker_threads_.emplace_back(&TTSProcessor::synthesis_worker, this, backend.get());
+    }
+
+    std::cout << "[TTSProcessor] Started " << workers << " synthesis worker(s)"
+              << (auto_tune_workers_ ? ", concurrency tuned from real-time factor" : "") << std::endl;
+    return true;
+}
+
+void TTSProcessor::stop_workers() {
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        workers_running_ = false;
+        ++job_generation_;
+    }
+    jobs_cv_.notify_all();
+    deliver_cv_.notify_all();
+
+    for (auto& worker : worker_threads_) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+    }
+    worker_threads_.clear();
+    if (delivery_thread_.joinable()) {
+        delivery_thread_.join();
+    }
+
+    for (auto& backend : extra_tts_) {
+        backend->shutdown();
+    }
+    extra_tts_.clear();
+
+    std::lock_guard<std::mutex> lock(jobs_mutex_);
+    jobs_.clear();
+    pending_jobs_.clear();
+    next_deliver_seq_ = next_job_seq_;
+}
+
+void TTSProcessor::render_fillers() {
+    auto& config = ConfigManager::getInstance();
+    fillers_.clear();
+    if (!config.getTtsFillersEnabled()) {
+        return;
+    }
+    filler_threshold_ms_ = std::max(0, config.getTtsFillersLatencyThresholdMs());
+    
+    const auto start_time = std::chrono::steady_clock::now();
+    for (const auto& phrase : config.getTtsFillerPhrases()) {
+        AudioChunkMessage audio;
+        if (tts_->speak(phrase, audio) && !audio.audio_data.empty()) {
+            fillers_.push_back({std::move(audio.audio_data), audio.sample_rate});
+        } else {
+            std::cerr << "[TTSProcessor] Failed to render filler: " << phrase << std::endl;
+        }
+    }
+    
+    if (fillers_.empty()) {
+        // No phrases (or no voice for them): a soft two-note chime
+        constexpr unsigned int kRate = 22050;
+        constexpr double kPi = 3.14159265358979323846;
+        Filler chime;
+        chime.sample_rate = kRate;
+        for (double freq : {880.0, 1320.0}) {
+            const size_t n = kRate / 8;
+            for (size_t i = 0; i < n; ++i) {
+                const double t = static_cast<double>(i) / kRate;
+                const double envelope = std::sin(kPi * static_cast<double>(i) / n);
+                chime.audio.push_back(static_cast<int16_t>(6000.0 * envelope * std::sin(2.0 * kPi * freq * t)));
+            }
+        }
+        fillers_.push_back(std::move(chime));
+    }
+    
+    std::cout << "[TTSProcessor] Rendered " << fillers_.size() << " filler(s) in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - start_time).count()
+              << "ms, played when responses take over " << filler_threshold_ms_ << "ms" << std::endl;
+}
+
+void TTSProcessor::on_user_utterance(std::chrono::steady_clock::time_point endpoint) {
+    double predicted_ms = 0.0;
+    {
+        std::lock_guard<std::mutex> lock(response_latency_mutex_);
+        pending_endpoint_ = endpoint;
+        predicted_ms = response_latency_ms_;
+    }
+    
+    // Until a response has been timed, assume the first one is slow (cold caches)
+    if (fillers_.empty() || !is_running() || !audio_output_queue_ || is_speaking_ ||
+        (predicted_ms >= 0.0 && predicted_ms < filler_threshold_ms_)) {
+        return;
+    }
+    
+    const Filler& filler = fillers_[next_filler_++ % fillers_.size()];
+    AudioChunkMessage msg(filler.audio, filler.sample_rate);
+    msg.filler = true;
+    if (!audio_output_queue_->push(std::move(msg), std::chrono::milliseconds(0))) {
+        return;
+    }
+#ifdef ENABLE_STATS_LOGGING
+    ++fillers_played_;
+#endif
+    std::cout << "[TTSProcessor] Queued filler, expected response latency "
+              << (predicted_ms >= 0.0 ? std::to_string(static_cast<int>(predicted_ms)) + "ms" : std::string("unknown"))
+              << std::endl;
+}
+
+bool TTSProcessor::set_voice(const std::string& voice) {
+    const auto voices = tts_ ? tts_->voices() : std::vector<std::string>{};
+    if (!voice.empty() && std::find(voices.begin(), voices.end(), voice) == voices.end()) {
+        std::cerr << "[TTSProcessor] Unknown voice: " << voice << std::endl;
+        return false;
+    }
+    // Load it now so the next job's worker does not stall on it
+    if (!voice.empty()) {
+        tts_->preload_voice(voice);
+    }
+    std::lock_guard<std::mutex> lock(voice_mutex_);
+    voice_ = voice;
+    std::cout << "[TTSProcessor] Session voice set to " << (voice.empty() ? "default" : voice) << std::endl;
+    return true;
+}
+
+bool TTSProcessor::speech_cancel_requested() const {
+    return !is_running() || !workers_running_ || is_interrupt_requested() ||
+           (interrupt_flag_ && interrupt_flag_->load(std::memory_order_acquire));
+}
+
+void TTSProcessor::cancel_pending_jobs() {
+    size_t dropped = 0;
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        ++job_generation_;
+        dropped = jobs_.size();
+        jobs_.clear();
+        pending_jobs_.clear();
+        next_deliver_seq_ = next_job_seq_;
+    }
+    jobs_cv_.notify_all();
+    if (dropped > 0) {
+        std::cout << "[TTSProcessor] Cancelled " << dropped << " in-flight synthesis job(s)" << std::endl;
+    }
+}
+
+void TTSProcessor::synthesis_worker(ITTS* tts) {
+    while (true) {
+        uint64_t seq = 0;
+        uint64_t generation = 0;
+        std::string text;
+        std::string voice;
+        bool with_phonemes = false;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_cv_.wait(lock, [this] { return !pending_jobs_.empty() || !workers_running_; });
+            if (!workers_running_) {
+                return;
+            }
+            seq = pending_jobs_.front();
+            pending_jobs_.pop_front();
+            auto it = jobs_.find(seq);
+            if (it == jobs_.end()) {
+                continue;
+            }
+            text = it->second.text;
+            voice = it->second.voice;
+            with_phonemes = it->second.with_phonemes;
+            generation = it->second.generation;
+        }
+
+        // Chunks are only handed to the delivery thread, so playback
+        // backpressure never stalls synthesis or skews the real-time factor
+        auto start_time = std::chrono::steady_clock::now();
+        double audio_seconds = 0.0;
+
+        auto on_audio_chunk = [&](TTSStreamChunk& chunk) {
+            if (chunk.sample_rate > 0) {
+                audio_seconds += static_cast<double>(chunk.audio.size()) / chunk.sample_rate;
+            }
+            {
+                std::lock_guard<std::mutex> lock(jobs_mutex_);
+                auto it = jobs_.find(seq);
+                if (generation != job_generation_.load() || it == jobs_.end()) {
+                    return false;
+                }
+                it->second.completed = chunk.last;
+                it->second.chunks.push_back(std::move(chunk));
+            }
+            deliver_cv_.notify_one();
+            return true;
+        };
+
+        auto cancel = [&]() {
+            return generation != job_generation_.load() || speech_cancel_requested();
+        };
+
+        // Voices are pooled by the backend, so switching costs far less than
+        // synthesis; on failure the worker keeps its current voice
+        if (!tts->set_voice(voice)) {
+            std::cerr << "[TTSProcessor] Voice " << voice << " unavailable, using the current one" << std::endl;
+        }
+
+        bool success = tts->speak_stream(text, on_audio_chunk, cancel, with_phonemes);
+        if (!success) {
+            std::cerr << "[TTSProcessor] Failed to speak: " << text << std::endl;
+        }
+
+        const double synth_seconds = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - start_time).count();
+
+        {
+            std::lock_guard<std::mutex> lock(jobs_mutex_);
+            if (generation == job_generation_.load()) {
+                auto it = jobs_.find(seq);
+                if (it != jobs_.end()) {
+                    it->second.done = true;
+                }
+                if (success) {
+                    update_worker_target(synth_seconds, audio_seconds);
+                }
+            }
+        }
+        jobs_cv_.notify_all();
+        deliver_cv_.notify_one();
+
+#ifdef ENABLE_STATS_LOGGING
+        if (success) {
+            std::lock_guard<std::mutex> stats_lock(stats_mutex_);
+            auto elapsed_ms = static_cast<int64_t>(synth_seconds * 1000.0);
+            auto n = ++stats_.messages_processed;
+            auto current_avg = stats_.avg_processing_time.count();
+            stats_.avg_processing_time = std::chrono::milliseconds(
+                (current_avg * static_cast<int64_t>(n - 1) + elapsed_ms) / static_cast<int64_t>(n)
+            );
+        }
+#endif
+    }
+}
+
+void TTSProcessor::delivery_loop() {
+    // Feeds the audio queue from the oldest job, blocking on playback
+    // backpressure without holding up the workers
+    while (true) {
+        TTSStreamChunk chunk;
+        bool with_phonemes = false;
+        bool finished_job = false;
+        bool fade_out = false;
+        uint64_t generation = 0;
+        uint64_t turn_id = 0;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            deliver_cv_.wait(lock, [this] {
+                if (!workers_running_) {
+                    return true;
+                }
+                auto head = jobs_.find(next_deliver_seq_);
+                return head != jobs_.end() && (!head->second.chunks.empty() || head->second.done);
+            });
+            if (!workers_running_) {
+                return;
+            }
+            auto it = jobs_.find(next_deliver_seq_);
+            if (it->second.chunks.empty()) {
+                fade_out = it->second.end_of_response || !it->second.completed;
+                jobs_.erase(it);
+                ++next_deliver_seq_;
+                jobs_cv_.notify_all();
+                finished_job = true;
+            } else {
+                chunk = std::move(it->second.chunks.front());
+                it->second.chunks.pop_front();
+                with_phonemes = it->second.with_phonemes;
+                generation = it->second.generation;
+                turn_id = it->second.turn_id;
+            }
+        }
+
+        // The tail of a job stays held to crossfade into the next job of the
+        // response. At the end of the response, or when a job ended without
+        // its last chunk (failure), play it out with a fade.
+        if (finished_job) {
+            if (joiner_generation_ != job_generation_.load()) {
+                joiner_.reset();
+            } else if (fade_out && joiner_.has_pending()) {
+                std::vector<int16_t> tail;
+                joiner_.flush(tail);
+                if (!tail.empty() && !push_joined_audio(std::move(tail), joiner_.sample_rate())) {
+                    return;
+                }
+            }
+            continue;
+        }
+
+        if (generation != job_generation_.load()) {
+            continue;
+        }
+
+        // Anything held from before an interruption must not leak into new speech
+        if (generation != joiner_generation_) {
+            joiner_.reset();
+            joiner_generation_ = generation;
+        }
+
+        const unsigned int sample_rate = chunk.sample_rate ? chunk.sample_rate : AudioChunkMessage().sample_rate;
+        std::vector<int16_t> joined;
+        if (static_cast<int>(sample_rate) != joiner_.sample_rate()) {
+            joiner_.flush(joined);
+            if (!joined.empty() && !push_joined_audio(std::move(joined), joiner_.sample_rate())) {
+                return;
+            }
+            joined.clear();
+            joiner_.init(static_cast<int>(sample_rate));
+        }
+
+        // Trim trailing silence and crossfade into the previous chunk, even
+        // across jobs; the joined audio (and any tail flushed later) belongs
+        // to this turn
+        delivered_turn_ = turn_id;
+        joiner_.push(chunk.audio.data(), chunk.audio.size(), false, joined);
+        if (!with_phonemes) {
+            chunk.phoneme_timings.clear();
+        }
+        if (!joined.empty() && !push_joined_audio(std::move(joined), sample_rate, std::move(chunk.phoneme_timings))) {
+            return;
+        }
+    }
+}
+
+bool TTSProcessor::push_joined_audio(std::vector<int16_t>&& audio, unsigned int sample_rate,
+                                     std::vector<PhonemeTimingInfo>&& phonemes) {
+    AudioChunkMessage msg(std::move(audio), sample_rate);
+    msg.chunk_id = next_chunk_id_++;
+    msg.turn_id = delivered_turn_;
+    
+    // Phonemes are published when the chunk starts playing (on_chunk_playback)
+    if (!phonemes.empty() && shared_queue_) {
+        std::lock_guard<std::mutex> lock(phonemes_mutex_);
+        pending_phonemes_[msg.chunk_id] = std::move(phonemes);
+    }
+    
+    // Queue the audio for playback with blocking push; false once shut down.
+    // An interrupt while waiting for space bumps the generation before it
+    // flushes the queue, so the push drops audio that became stale.
+    const uint64_t chunk_id = msg.chunk_id;
+    bool queued = false;
+    const bool open = audio_output_queue_->push_blocking(std::move(msg), [this, &queued] {
+        queued = joiner_generation_ == job_generation_.load();
+        return queued;
+    });
+    if (!queued && shared_queue_) {
+        std::lock_guard<std::mutex> lock(phonemes_mutex_);
+        pending_phonemes_.erase(chunk_id);
+    }
+    return open;
+}
+
+void TTSProcessor::update_worker_target(double synth_seconds, double audio_seconds) {
+    if (audio_seconds <= 0.0 || synth_seconds <= 0.0) {
+        return;
+    }
+
+    // Exponential moving average; measured under the current concurrency, so
+    // CPU contention between workers raises it and is accounted for
+    const double rtf = synth_seconds / audio_seconds;
+    rtf_average_ = (rtf_average_ == 0.0) ? rtf : 0.8 * rtf_average_ + 0.2 * rtf;
+
+    if (!auto_tune_workers_) {
+        return;
+    }
+
+    // Sustained playback needs workers / rtf >= 1
+    const size_t max_workers = 1 + extra_tts_.size();
+    const size_t target = std::clamp(
+        static_cast<size_t>(std::ceil(rtf_average_ * kTtsWorkerHeadroom)), size_t{1}, max_workers);
+    if (target != active_workers_) {
+        std::cout << "[TTSProcessor] Real-time factor " << rtf_average_
+                  << ", using " << target << " synthesis worker(s)" << std::endl;
+        active_workers_ = target;
+        jobs_cv_.notify_all();
+    }
 }
 
 // AudioOutputProcessor implementation
-AudioOutputProcessor::AudioOutputProcessor(SafeQueue<AudioChunkMessage>& input_queue)
+AudioOutputProcessor::AudioOutputProcessor(SafeQueue<AudioChunkMessage>& input_queue, unsigned int sample_rate,
+                                           std::shared_ptr<AudioSink> sink)
     : BaseProcessor("AudioOutputProcessor"), input_queue_(input_queue),
-      alsa_handle_(nullptr), sample_rate_(22050) {
+      sink_(std::move(sink)), sample_rate_(sample_rate) {
 }
 
 void AudioOutputProcessor::interrupt_audio_immediately() {
@@ -427,16 +1061,67 @@ void AudioOutputProcessor::interrupt_audio_immediately() {
         std::cout << "[AudioOutputProcessor] Flushed " << flushed << " queued audio chunks" << std::endl;
     }
     
-    // Stop ALSA playback immediately
-    if (alsa_handle_) {
-        snd_pcm_drop(alsa_handle_);  // Stop immediately, don't drain buffer
-        snd_pcm_prepare(alsa_handle_); // Prepare for next playback
-        std::cout << "[AudioOutputProcessor] Stopped ALSA playback immediately" << std::endl;
+    // Abandon the chunk being written and keep discarded audio from bleeding
+    // into the next utterance through the resampler history
+    interrupt_pending_ = true;
+    
+    // Stop playback immediately, noting how far the listener got
+    if (sink_open_) {
+        const uint64_t written = sink_->frames_written();
+        const double delay_ms = sink_->delay_ms();
+        sink_->drop();
+        const PlaybackPosition cut = clock_.drop(written, delay_ms, sink_->frames_written());
+        std::cout << "[AudioOutputProcessor] Stopped playback immediately";
+        if (cut.playing) {
+            std::cout << " in chunk " << cut.chunk_id << " (turn " << cut.turn_id << ") after "
+                      << cut.chunk_ms_played() << "ms";
+        }
+        std::cout << std::endl;
     }
+    
+    // The dropped audio will never reach the microphone
+    if (echo_reference_) {
+        echo_reference_->discard_after(std::chrono::steady_clock::now());
+    }
+}
+
+PlaybackPosition AudioOutputProcessor::playback_position() const {
+    if (!sink_open_) {
+        return PlaybackPosition{};
+    }
+    return clock_.position(sink_->frames_written(), sink_->delay_ms());
+}
+
+AudioOutputProcessor::OutputMetrics AudioOutputProcessor::get_output_metrics() const {
+    return sink_ ? sink_->metrics() : OutputMetrics{};
 }
 
 bool AudioOutputProcessor::initialize() {
-    std::cout << "[AudioOutputProcessor] Initializing ALSA..." << std::endl;
+    if (!sink_) {
+        auto& config = ConfigManager::getInstance();
+        const std::string type = config.getAudioOutputSink();
+        if (type == "null") {
+            sink_ = std::make_shared<NullAudioSink>(config.getAudioOutputNullPaced(),
+                                                    std::max(0, config.getAudioOutputTargetFillMs()));
+        } else if (type == "wav") {
+            sink_ = std::make_shared<WavFileAudioSink>(config.getAudioOutputWavPath());
+        } else if (type == "memory") {
+            sink_ = std::make_shared<MemoryAudioSink>(config.getAudioOutputNullPaced());
+        } else {
+            if (type != "alsa") {
+                std::cerr << "[AudioOutputProcessor] Unknown audio sink '" << type << "', using ALSA" << std::endl;
+            }
+            AlsaAudioSink::Options options;
+            options.device = config.getAudioDevice();
+            options.period_frames = static_cast<size_t>(std::max(16, config.getAudioOutputPeriodFrames()));
+            options.periods = static_cast<unsigned int>(std::max(2, config.getAudioOutputPeriods()));
+            options.mmap = config.getAudioOutputMmap();
+            options.target_fill_ms = std::max(1, config.getAudioOutputTargetFillMs());
+            sink_ = std::make_shared<AlsaAudioSink>(options);
+        }
+    }
+    
+    std::cout << "[AudioOutputProcessor] Initializing " << sink_->name() << " audio output..." << std::endl;
     return init_audio_device();
 }
 
@@ -450,9 +1135,24 @@ void AudioOutputProcessor::process() {
     PopResult result = input_queue_.pop_blocking(audio_msg);
     
     if (result == PopResult::SUCCESS) {
-        if (!audio_msg.audio_data.empty()) {
-            play_audio_chunk(audio_msg.audio_data);
+        if (audio_msg.audio_data.empty()) {
+            return;
         }
+        if (interrupt_pending_.exchange(false)) {
+            resampler_.reset();
+        }
+        if (audio_msg.filler && !input_queue_.empty()) {
+            // The real response is already waiting; the filler is no longer needed
+            return;
+        }
+        if (audio_msg.sample_rate == 0 || audio_msg.sample_rate == sample_rate_ ||
+            !prepare_resampler(audio_msg.sample_rate)) {
+            play_audio_chunk(audio_msg.audio_data, audio_msg.chunk_id, audio_msg.turn_id, audio_msg.filler);
+            return;
+        }
+        resampled_.clear();
+        resampler_.process(audio_msg.audio_data.data(), audio_msg.audio_data.size(), resampled_);
+        play_audio_chunk(resampled_, audio_msg.chunk_id, audio_msg.turn_id, audio_msg.filler);
     } else if (result == PopResult::SHUTDOWN) {
         // Queue is shutting down, stop processing
         return;
@@ -475,101 +1175,125 @@ bool AudioOutputProcessor::handle_control_message(const ControlMessage& msg) {
 
 void AudioOutputProcessor::cleanup() {
     close_audio_device();
+    std::cout << "[AudioOutputProcessor] ";
+    get_output_metrics().print();
     std::cout << "[AudioOutputProcessor] Cleanup completed" << std::endl;
 }
 
 bool AudioOutputProcessor::init_audio_device() {
-    int err;
-    
-    if ((err = snd_pcm_open(&alsa_handle_, "default", SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot open audio device: " << snd_strerror(err) << std::endl;
-        return false;
-    }
-    
-    // Set hardware parameters
-    snd_pcm_hw_params_t *params;
-    snd_pcm_hw_params_alloca(&params);
-    snd_pcm_hw_params_any(alsa_handle_, params);
-    snd_pcm_hw_params_set_access(alsa_handle_, params, SND_PCM_ACCESS_RW_INTERLEAVED);
-    snd_pcm_hw_params_set_format(alsa_handle_, params, SND_PCM_FORMAT_S16_LE);
-    snd_pcm_hw_params_set_channels(alsa_handle_, params, 1);
-    
-    // Set sample rate
     unsigned int rate = sample_rate_;
-    if ((err = snd_pcm_hw_params_set_rate_near(alsa_handle_, params, &rate, 0)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot set sample rate: " << snd_strerror(err) << std::endl;
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
+    if (!sink_->open(rate)) {
+        std::cerr << "[AudioOutputProcessor] Cannot open " << sink_->name() << " audio output" << std::endl;
         return false;
     }
     
-    // Set period size for low latency
-    snd_pcm_uframes_t period_size = 1024;
-    if ((err = snd_pcm_hw_params_set_period_size_near(alsa_handle_, params, &period_size, 0)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot set period size: " << snd_strerror(err) << std::endl;
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
-        return false;
+    sink_open_ = true;
+    sample_rate_ = rate;
+    clock_.reset(rate, sink_->frames_written());
+    std::cout << "[AudioOutputProcessor] Audio output initialized successfully at " << rate << " Hz" << std::endl;
+    return true;
+}
+
+bool AudioOutputProcessor::prepare_resampler(unsigned int in_rate) {
+    // Filters are rebuilt only when the source rate changes, not per chunk
+    if (resampler_.in_rate() == static_cast<int>(in_rate) &&
+        resampler_.out_rate() == static_cast<int>(sample_rate_)) {
+        return true;
     }
-    
-    // Set buffer size
-    snd_pcm_uframes_t buffer_size = period_size * 4;
-    if ((err = snd_pcm_hw_params_set_buffer_size_near(alsa_handle_, params, &buffer_size)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot set buffer size: " << snd_strerror(err) << std::endl;
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
+    if (in_rate == unconvertible_rate_) {
         return false;
     }
-    
-    if ((err = snd_pcm_hw_params(alsa_handle_, params)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot set parameters: " << snd_strerror(err) << std::endl;
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
-        return false;
+    if (resampler_.init(in_rate, sample_rate_)) {
+        std::cout << "[AudioOutputProcessor] Resampling " << in_rate << " Hz -> " << sample_rate_ << " Hz" << std::endl;
+        return true;
     }
     
-    // Prepare the PCM device
-    if ((err = snd_pcm_prepare(alsa_handle_)) < 0) {
-        std::cerr << "[AudioOutputProcessor] Cannot prepare audio device: " << snd_strerror(err) << std::endl;
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
-        return false;
+    // Ratio too awkward to tabulate: the device has to follow the source
+    std::cerr << "[AudioOutputProcessor] Cannot resample from " << in_rate
+              << " Hz, reopening output at that rate" << std::endl;
+    unconvertible_rate_ = in_rate;
+    if (!reconfigure_audio_device(in_rate)) {
+        std::cerr << "[AudioOutputProcessor] Playing " << in_rate << " Hz audio unconverted" << std::endl;
     }
-    
-    std::cout << "[AudioOutputProcessor] ALSA initialized successfully at " << rate << " Hz" << std::endl;
-    return true;
+    return false;
+}
+
+bool AudioOutputProcessor::reconfigure_audio_device(unsigned int sample_rate) {
+    unsigned int previous_rate = sample_rate_;
+    close_audio_device();
+    sample_rate_ = sample_rate;
+    if (init_audio_device()) {
+        return true;
+    }
+    sample_rate_ = previous_rate;
+    init_audio_device();
+    return false;
 }
 
 void AudioOutputProcessor::close_audio_device() {
-    if (alsa_handle_) {
-        // Drain any remaining audio data
-        snd_pcm_drain(alsa_handle_);
-        snd_pcm_close(alsa_handle_);
-        alsa_handle_ = nullptr;
+    if (sink_open_) {
+        sink_open_ = false;
+        sink_->close();
     }
 }
 
-void AudioOutputProcessor::play_audio_chunk(const std::vector<int16_t>& chunk) {
-    if (chunk.empty() || !alsa_handle_) {
+void AudioOutputProcessor::play_audio_chunk(const std::vector<int16_t>& chunk, uint64_t chunk_id, uint64_t turn_id,
+                                            bool filler) {
+    if (chunk.empty() || !sink_open_) {
         return;
     }
     
-    const int16_t* data_ptr = chunk.data();
-    size_t frames_total = chunk.size();
-    while (frames_total > 0) {
-        snd_pcm_sframes_t written = snd_pcm_writei(alsa_handle_, data_ptr, frames_total);
-        if (written >= 0) {
-            data_ptr += written;
-            frames_total -= static_cast<size_t>(written);
-            continue;
-        }
-        if (written == -EPIPE) {
-            std::cerr << "[AudioOutputProcessor] ALSA underrun, recovering..." << std::endl;
-            snd_pcm_prepare(alsa_handle_);
-            continue;
+    if (!interrupt_pending_.load()) {
+        clock_.add_chunk(chunk_id, turn_id, sink_->frames_written(), chunk.size());
+    }
+    
+    // The first sample is heard once everything already in the sink has played
+    if (chunk_id != 0 && playback_callback_ && !interrupt_pending_.load()) {
+        auto start_time = std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(sink_->delay_ms()));
+        playback_callback_(chunk_id, start_time);
+    }
+    
+    if (echo_reference_ || filler) {
+        for (size_t offset = 0; offset < chunk.size() && !interrupt_pending_.load(); offset += kEchoSliceFrames) {
+            size_t frames = std::min(kEchoSliceFrames, chunk.size() - offset);
+            const int16_t* data = chunk.data() + offset;
+            
+            // Real speech arrived while a filler plays: fade it out over
+            // one short slice instead of cutting it off mid-sound
+            const bool fade_out = filler && !input_queue_.empty();
+            if (fade_out) {
+                frames = std::min<size_t>(frames, sample_rate_ / 100);
+                fade_.assign(data, data + frames);
+                pcm::ramp(fade_.data(), frames, 1.0f, 0.0f);
+                data = fade_.data();
+            }
+            
+            if (echo_reference_) {
+                echo_reference_->push(data, frames, sample_rate_,
+                    std::chrono::steady_clock::now() +
+                    std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                        std::chrono::duration<double, std::milli>(sink_->delay_ms())));
+            }
+            if (!sink_->write(data, frames, interrupt_pending_)) {
+                std::cerr << "[AudioOutputProcessor] " << sink_->name() << " write failed" << std::endl;
+                break;
+            }
+            if (fade_out) {
+                break;
+            }
         }
-        std::cerr << "[AudioOutputProcessor] ALSA write error: " << snd_strerror(written) << std::endl;
-        break;
+    } else if (!sink_->write(chunk.data(), chunk.size(), interrupt_pending_)) {
+        std::cerr << "[AudioOutputProcessor] " << sink_->name() << " write failed" << std::endl;
+    }
+    
+    const bool more_queued = !input_queue_.empty();
+    sink_->end_of_block(more_queued);
+    if (!more_queued && idle_callback_ && !interrupt_pending_.load()) {
+        idle_callback_(std::chrono::steady_clock::now() +
+            std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                std::chrono::duration<double, std::milli>(sink_->delay_ms())));
     }
 }
 
@@ -577,7 +1301,7 @@ void AudioOutputProcessor::play_audio_chunk(const std::vector<int16_t>& chunk) {
 
 bool TTSProcessor::setup_unix_socket() {
     // Create Unix socket
-    socket_fd_ = socket(AF_UNIX, SOCK_STREAM, 0);
+    socket_fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
     if (socket_fd_ < 0) {
         std::cerr << "[TTSProcessor] Failed to create Unix socket: " << strerror(errno) << std::endl;
         return false;
@@ -608,6 +1332,24 @@ bool TTSProcessor::setup_unix_socket() {
         return false;
     }
     
+    // One epoll set watches the listener, every client and the wakeup eventfd,
+    // so the server thread sleeps until something actually happens
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || event_fd_ < 0) {
+        std::cerr << "[TTSProcessor] Failed to create epoll set: " << strerror(errno) << std::endl;
+        cleanup_socket();
+        return false;
+    }
+    
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = socket_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_fd_, &ev);
+    ev.data.fd = event_fd_;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev);
+    
     // Start socket server thread
     socket_running_ = true;
     socket_thread_ = std::thread(&TTSProcessor::socket_server_thread, this);
@@ -617,59 +1359,216 @@ bool TTSProcessor::setup_unix_socket() {
 }
 
 void TTSProcessor::socket_server_thread() {
+    constexpr int kMaxEvents = 16;
+    struct epoll_event events[kMaxEvents];
+    
     while (socket_running_) {
-        struct sockaddr_un client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        
-        // Accept connection with timeout
-        fd_set read_fds;
-        FD_ZERO(&read_fds);
-        FD_SET(socket_fd_, &read_fds);
-        
-        struct timeval timeout;
-        timeout.tv_sec = 1;
-        timeout.tv_usec = 0;
-        
-        int result = select(socket_fd_ + 1, &read_fds, nullptr, nullptr, &timeout);
-        if (result < 0) {
+        int n = epoll_wait(epoll_fd_, events, kMaxEvents, -1);
+        if (n < 0) {
             if (errno == EINTR) continue;
-            std::cerr << "[TTSProcessor] Socket select error: " << strerror(errno) << std::endl;
+            std::cerr << "[TTSProcessor] Socket epoll error: " << strerror(errno) << std::endl;
             break;
         }
         
-        if (result == 0) continue; // Timeout
-        
-        int client_fd = accept(socket_fd_, (struct sockaddr*)&client_addr, &client_len);
+        for (int i = 0; i < n; ++i) {
+            const int fd = events[i].data.fd;
+            if (fd == socket_fd_) {
+                accept_control_clients();
+            } else if (fd == event_fd_) {
+                uint64_t count;
+                while (read(event_fd_, &count, sizeof(count)) > 0) {}
+                
+                std::vector<std::string> pending;
+                {
+                    std::lock_guard<std::mutex> lock(control_events_mutex_);
+                    pending.swap(control_events_);
+                }
+                for (auto& [client_fd, client] : control_clients_) {
+                    if (!client.subscribed) continue;
+                    for (const auto& event : pending) {
+                        client.out += event;
+                    }
+                }
+                std::vector<int> fds;
+                for (const auto& entry : control_clients_) {
+                    if (!entry.second.out.empty()) fds.push_back(entry.first);
+                }
+                for (int client_fd : fds) {
+                    flush_control_client(client_fd);
+                }
+            } else {
+                if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    read_control_client(fd);
+                }
+                if ((events[i].events & EPOLLOUT) && control_clients_.count(fd)) {
+                    flush_control_client(fd);
+                }
+            }
+        }
+    }
+    
+    // Server is stopping: drop every client connection
+    while (!control_clients_.empty()) {
+        close_control_client(control_clients_.begin()->first);
+    }
+}
+
+void TTSProcessor::accept_control_clients() {
+    while (true) {
+        int client_fd = accept4(socket_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
         if (client_fd < 0) {
-            if (errno == EINTR || errno == EAGAIN) continue;
-            std::cerr << "[TTSProcessor] Socket accept error: " << strerror(errno) << std::endl;
-            continue;
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                std::cerr << "[TTSProcessor] Socket accept error: " << strerror(errno) << std::endl;
+            }
+            return;
         }
         
-        // Read command from client
-        char buffer[256];
-        ssize_t bytes_read = read(client_fd, buffer, sizeof(buffer) - 1);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = client_fd;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, client_fd, &ev) < 0) {
+            close(client_fd);
+            continue;
+        }
+        control_clients_[client_fd] = ControlClient{};
+    }
+}
+
+void TTSProcessor::read_control_client(int fd) {
+    auto it = control_clients_.find(fd);
+    if (it == control_clients_.end()) return;
+    ControlClient& client = it->second;
+    
+    constexpr size_t kMaxLine = 256;
+    char buffer[256];
+    bool closed = false;
+    while (true) {
+        ssize_t bytes_read = read(fd, buffer, sizeof(buffer));
         if (bytes_read > 0) {
-            buffer[bytes_read] = '\0';
-            std::string command(buffer);
-            command.erase(command.find_last_not_of(" \n\r\t") + 1); // Trim whitespace
-            handle_socket_command(command);
+            client.in.append(buffer, static_cast<size_t>(bytes_read));
+            continue;
         }
-        
-        close(client_fd);
+        if (bytes_read < 0 && errno == EINTR) continue;
+        closed = bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
     }
+    
+    // Commands are newline-delimited; a client that closes right after
+    // writing one unterminated command (the old protocol) still gets it run
+    size_t start = 0;
+    size_t newline;
+    while ((newline = client.in.find('\n', start)) != std::string::npos) {
+        std::string command = client.in.substr(start, newline - start);
+        command.erase(command.find_last_not_of(" \n\r\t") + 1); // Trim whitespace
+        if (!command.empty()) {
+            handle_socket_command(client, command);
+        }
+        start = newline + 1;
+    }
+    client.in.erase(0, start);
+    if (closed && !client.in.empty()) {
+        std::string command = client.in;
+        command.erase(command.find_last_not_of(" \n\r\t") + 1);
+        if (!command.empty()) {
+            handle_socket_command(client, command);
+        }
+        client.in.clear();
+    }
+    
+    if (closed || client.in.size() > kMaxLine) {
+        close_control_client(fd);
+        return;
+    }
+    if (!client.out.empty()) {
+        flush_control_client(fd);
+    }
+}
+
+void TTSProcessor::flush_control_client(int fd) {
+    auto it = control_clients_.find(fd);
+    if (it == control_clients_.end()) return;
+    ControlClient& client = it->second;
+    
+    while (!client.out.empty()) {
+        ssize_t sent = send(fd, client.out.data(), client.out.size(), MSG_NOSIGNAL);
+        if (sent > 0) {
+            client.out.erase(0, static_cast<size_t>(sent));
+            continue;
+        }
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        close_control_client(fd);
+        return;
+    }
+    
+    // A subscriber that stops reading must not make us buffer forever
+    constexpr size_t kMaxPending = 64 * 1024;
+    if (client.out.size() > kMaxPending) {
+        std::cerr << "[TTSProcessor] Face control client is not reading events, disconnecting" << std::endl;
+        close_control_client(fd);
+        return;
+    }
+    
+    // Only ask for writability while something is waiting to be sent
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (client.out.empty() ? 0u : static_cast<uint32_t>(EPOLLOUT));
+    ev.data.fd = fd;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, fd, &ev);
 }
 
-void TTSProcessor::handle_socket_command(const std::string& command) {
+void TTSProcessor::close_control_client(int fd) {
+    epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    control_clients_.erase(fd);
+}
+
+void TTSProcessor::push_control_event(const std::string& event) {
+    if (event_fd_ < 0) return;
+    {
+        std::lock_guard<std::mutex> lock(control_events_mutex_);
+        control_events_.push_back(event + "\n");
+    }
+    uint64_t one = 1;
+    ssize_t rc = write(event_fd_, &one, sizeof(one));
+    (void) rc;
+}
+
+void TTSProcessor::handle_socket_command(ControlClient& client, const std::string& command) {
     if (command == "face_show") {
         face_shown_ = true;
         std::cout << "[TTSProcessor] Face display enabled via socket command" << std::endl;
+        push_control_event("face_shown 1");
     } else if (command == "face_hide") {
         face_shown_ = false;
         std::cout << "[TTSProcessor] Face display disabled via socket command" << std::endl;
+        push_control_event("face_shown 0");
     } else if (command == "face_toggle") {
         face_shown_ = !face_shown_;
         std::cout << "[TTSProcessor] Face display toggled to: " << (face_shown_ ? "enabled" : "disabled") << std::endl;
+        push_control_event(face_shown_ ? "face_shown 1" : "face_shown 0");
+    } else if (command == "voice") {
+        std::string reply = "voice " + voice() + " available";
+        for (const auto& name : tts_->voices()) {
+            reply += " " + name;
+        }
+        client.out += reply + "\n";
+    } else if (command.rfind("voice ", 0) == 0) {
+        const std::string name = command.substr(6);
+        client.out += set_voice(name) ? "voice " + name + "\n" : "error unknown voice " + name + "\n";
+    } else if (command == "subscribe") {
+        client.subscribed = true;
+    } else if (command == "unsubscribe") {
+        client.subscribed = false;
+    } else if (command == "status") {
+        const PlaybackPosition pos = playback_position();
+        client.out += std::string("face_shown ") + (face_shown_ ? "1" : "0") +
+                      " speaking " + (is_speaking_ ? "1" : "0") +
+                      " chunk " + std::to_string(pos.chunk_id) +
+                      " turn " + std::to_string(pos.turn_id) +
+                      " played_ms " + std::to_string(static_cast<int64_t>(pos.chunk_ms_played())) + "\n";
     } else {
         std::cout << "[TTSProcessor] Unknown socket command: " << command << std::endl;
     }
@@ -678,6 +1577,13 @@ void TTSProcessor::handle_socket_command(const std::string& command) {
 void TTSProcessor::cleanup_socket() {
     socket_running_ = false;
     
+    // Wake the server thread out of epoll_wait
+    if (event_fd_ >= 0) {
+        uint64_t one = 1;
+        ssize_t rc = write(event_fd_, &one, sizeof(one));
+        (void) rc;
+    }
+    
     if (socket_thread_.joinable()) {
         socket_thread_.join();
     }
@@ -686,6 +1592,14 @@ void TTSProcessor::cleanup_socket() {
         close(socket_fd_);
         socket_fd_ = -1;
     }
+    if (epoll_fd_ >= 0) {
+        close(epoll_fd_);
+        epoll_fd_ = -1;
+    }
+    if (event_fd_ >= 0) {
+        close(event_fd_);
+        event_fd_ = -1;
+    }
     
     unlink(socket_path_.c_str());
 }
@@ -720,37 +1634,113 @@ bool TTSProcessor::setup_shared_memory() {
         return false;
     }
     
-    // Initialize shared queue
+    // Initialize shared queue; readers see the magic only once the layout is complete
     new (shared_queue_) PhonemeSharedQueue();
+    shared_queue_->header.entry_size = sizeof(PhonemeData);
+    shared_queue_->header.magic.store(PhonemeQueueHeader::MAGIC, std::memory_order_release);
     
     std::cout << "[TTSProcessor] Shared memory setup successfully" << std::endl;
     return true;
 }
 
-void TTSProcessor::send_phoneme_data(const std::vector<PhonemeTimingInfo>& phonemes) {
+void TTSProcessor::send_phoneme_data(const std::vector<PhonemeTimingInfo>& phonemes,
+                                     std::chrono::steady_clock::time_point start_time) {
     if (!shared_queue_) return;
     
-    auto current_time = std::chrono::duration_cast<std::chrono::microseconds>(
-        std::chrono::steady_clock::now().time_since_epoch()
-    ).count();
+    auto& header = shared_queue_->header;
+    constexpr uint32_t capacity = PhonemeQueueHeader::MAX_PHONEMES;
+    
+    // Only this thread stores write_index; acquire on read_index makes sure the
+    // consumer is done with a slot before it is overwritten
+    uint32_t write_idx = header.write_index.load(std::memory_order_relaxed);
+    uint32_t read_idx = header.read_index.load(std::memory_order_acquire);
+    
+    double start_us = static_cast<double>(std::chrono::duration_cast<std::chrono::microseconds>(
+        start_time.time_since_epoch()).count());
     
     for (const auto& phoneme : phonemes) {
-        uint32_t write_idx = shared_queue_->header.write_index.load();
-        uint32_t next_idx = (write_idx + 1) % PhonemeQueueHeader::MAX_PHONEMES;
-        
-        // Check if queue is full (next write would overwrite read position)
-        if (next_idx == shared_queue_->header.read_index.load()) {
-            std::cerr << "[TTSProcessor] Phoneme queue is full, dropping phoneme" << std::endl;
-            break;
+        if (write_idx - read_idx >= capacity) {
+            read_idx = header.read_index.load(std::memory_order_acquire);
+            if (write_idx - read_idx >= capacity) {
+                std::cerr << "[TTSProcessor] Phoneme queue is full, dropping phonemes" << std::endl;
+                break;
+            }
         }
         
-        // Write phoneme data
-        shared_queue_->phonemes[write_idx].phoneme_id = phoneme.phoneme_id;
-        shared_queue_->phonemes[write_idx].duration_seconds = phoneme.duration_seconds;
-        shared_queue_->phonemes[write_idx].timestamp_us = current_time;
-        
-        // Update write index
-        shared_queue_->header.write_index.store(next_idx);
+        PhonemeData& slot = shared_queue_->phonemes[write_idx & (capacity - 1)];
+        slot.phoneme_id = phoneme.phoneme_id;
+        slot.duration_seconds = phoneme.duration_seconds;
+        slot.start_time_us = static_cast<uint64_t>(start_us);
+        start_us += static_cast<double>(phoneme.duration_seconds) * 1e6;
+        ++write_idx;
+    }
+    
+    // Publish the batch: the slots above are visible before the new index
+    header.write_index.store(write_idx, std::memory_order_release);
+}
+
+void TTSProcessor::on_chunk_playback(uint64_t chunk_id, std::chrono::steady_clock::time_point start_time) {
+    const std::string start_us = std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+        start_time.time_since_epoch()).count());
+    if (!is_speaking_.exchange(true)) {
+        push_control_event("speech_start " + start_us);
+    }
+    push_control_event("chunk " + start_us + " " + std::to_string(chunk_id));
+    
+    // First audible response since the user stopped talking
+    {
+        std::lock_guard<std::mutex> lock(response_latency_mutex_);
+        if (pending_endpoint_ != std::chrono::steady_clock::time_point{}) {
+            const double latency_ms = std::chrono::duration<double, std::milli>(start_time - pending_endpoint_).count();
+            response_latency_ms_ = response_latency_ms_ < 0.0 ? latency_ms
+                                                              : 0.7 * response_latency_ms_ + 0.3 * latency_ms;
+            pending_endpoint_ = {};
+            std::cout << "[TTSProcessor] Endpoint to first audio: " << latency_ms << "ms" << std::endl;
+        }
+    }
+    
+    std::vector<PhonemeTimingInfo> phonemes;
+    {
+        std::lock_guard<std::mutex> lock(phonemes_mutex_);
+        auto it = pending_phonemes_.find(chunk_id);
+        if (it == pending_phonemes_.end()) {
+            return;
+        }
+        phonemes = std::move(it->second);
+        // Older entries belong to chunks that were flushed without playing
+        pending_phonemes_.erase(pending_phonemes_.begin(), std::next(it));
+    }
+    send_phoneme_data(phonemes, start_time);
+}
+
+void TTSProcessor::on_playback_idle(std::chrono::steady_clock::time_point end_time) {
+    // The audio queue also runs dry between chunks when synthesis lags;
+    // speech has only stopped once no text or synthesis work is left
+    {
+        std::lock_guard<std::mutex> lock(jobs_mutex_);
+        if (!jobs_.empty() || !input_queue_.empty()) {
+            return;
+        }
+    }
+    if (is_speaking_.exchange(false)) {
+        push_control_event("speech_stop " + std::to_string(std::chrono::duration_cast<std::chrono::microseconds>(
+            end_time.time_since_epoch()).count()));
+    }
+}
+
+void TTSProcessor::cancel_pending_phonemes() {
+    {
+        std::lock_guard<std::mutex> lock(phonemes_mutex_);
+        pending_phonemes_.clear();
+    }
+    
+    // Phonemes already published for audio that was just dropped will not play
+    if (shared_queue_) {
+        auto now_us = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+        auto& header = shared_queue_->header;
+        header.cancel_time_us.store(static_cast<uint64_t>(now_us), std::memory_order_relaxed);
+        header.cancel_index.store(header.write_index.load(std::memory_order_acquire), std::memory_order_release);
     }
 }
 
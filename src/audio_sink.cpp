@@ -0,0 +1,378 @@
+#include "audio_sink.h"
+
+#include <algorithm>
+#include <thread>
+
+//
+// AudioSink
+//
+
+AudioSinkMetrics AudioSink::metrics() const {
+    AudioSinkMetrics metrics;
+    metrics.xruns          = m_xruns.load();
+    metrics.idle_drains    = m_idle_drains.load();
+    metrics.frames_written = m_frames_written.load();
+    metrics.latency_ms     = m_latency_ms.load();
+    metrics.max_latency_ms = m_max_latency_ms.load();
+    return metrics;
+}
+
+void AudioSink::record_latency(double latency_ms) {
+    m_latency_ms = latency_ms;
+    if (latency_ms > m_max_latency_ms.load()) {
+        m_max_latency_ms = latency_ms;
+    }
+}
+
+//
+// AlsaAudioSink
+//
+
+bool AlsaAudioSink::open(unsigned int & sample_rate) {
+    int err;
+
+    if ((err = snd_pcm_open(&m_handle, m_options.device.c_str(), SND_PCM_STREAM_PLAYBACK, 0)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot open audio device '" << m_options.device << "': " << snd_strerror(err) << std::endl;
+        m_handle = nullptr;
+        return false;
+    }
+
+    // Set hardware parameters
+    snd_pcm_hw_params_t *params;
+    snd_pcm_hw_params_alloca(&params);
+    snd_pcm_hw_params_any(m_handle, params);
+
+    // mmap transfer when requested and supported, interleaved read/write otherwise
+    m_mmap_active = m_options.mmap &&
+        snd_pcm_hw_params_set_access(m_handle, params, SND_PCM_ACCESS_MMAP_INTERLEAVED) >= 0;
+    if (!m_mmap_active) {
+        if (m_options.mmap) {
+            std::cerr << "[AlsaAudioSink] mmap access not supported by '" << m_options.device
+                      << "', using read/write transfers" << std::endl;
+        }
+        snd_pcm_hw_params_set_access(m_handle, params, SND_PCM_ACCESS_RW_INTERLEAVED);
+    }
+    snd_pcm_hw_params_set_format(m_handle, params, SND_PCM_FORMAT_S16_LE);
+    snd_pcm_hw_params_set_channels(m_handle, params, 1);
+
+    // Set sample rate
+    unsigned int rate = sample_rate;
+    if ((err = snd_pcm_hw_params_set_rate_near(m_handle, params, &rate, 0)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot set sample rate: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    // Set period size for low latency
+    snd_pcm_uframes_t period_size = std::max<snd_pcm_uframes_t>(16, m_options.period_frames);
+    if ((err = snd_pcm_hw_params_set_period_size_near(m_handle, params, &period_size, 0)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot set period size: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    // Set buffer size
+    snd_pcm_uframes_t buffer_size = period_size * std::max(2u, m_options.periods);
+    if ((err = snd_pcm_hw_params_set_buffer_size_near(m_handle, params, &buffer_size)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot set buffer size: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    if ((err = snd_pcm_hw_params(m_handle, params)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot set parameters: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    // The device may round sizes; everything below uses what it granted
+    snd_pcm_hw_params_get_period_size(params, &period_size, 0);
+    snd_pcm_hw_params_get_buffer_size(params, &buffer_size);
+
+    const snd_pcm_uframes_t target_fill = std::clamp<snd_pcm_uframes_t>(
+        static_cast<snd_pcm_uframes_t>(rate) * std::max(1, m_options.target_fill_ms) / 1000, period_size, buffer_size);
+
+    // Start as soon as one period is queued. Writers keep the buffer at the
+    // target fill, so wake them once there is room below it (a period of
+    // room when the target leaves one queued) rather than when a period is
+    // free: with a target under the buffer size that would return at once
+    // and spin until the fill dropped.
+    const snd_pcm_uframes_t wake_room = std::max<snd_pcm_uframes_t>(1, std::min(period_size, target_fill - period_size));
+    snd_pcm_sw_params_t *sw_params;
+    snd_pcm_sw_params_alloca(&sw_params);
+    snd_pcm_sw_params_current(m_handle, sw_params);
+    snd_pcm_sw_params_set_start_threshold(m_handle, sw_params, period_size);
+    snd_pcm_sw_params_set_avail_min(m_handle, sw_params, buffer_size - target_fill + wake_room);
+    if ((err = snd_pcm_sw_params(m_handle, sw_params)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot set software parameters: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    // Prepare the PCM device
+    if ((err = snd_pcm_prepare(m_handle)) < 0) {
+        std::cerr << "[AlsaAudioSink] Cannot prepare audio device: " << snd_strerror(err) << std::endl;
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+        return false;
+    }
+
+    m_sample_rate   = rate;
+    m_period_frames = period_size;
+    m_buffer_frames = buffer_size;
+    m_target_fill_frames = target_fill;
+    m_idle_drain_expected = true;
+    sample_rate = rate;
+
+    std::cout << "[AlsaAudioSink] Opened '" << m_options.device << "' at " << rate
+              << " Hz (period " << period_size << ", buffer " << buffer_size << ", target fill "
+              << m_target_fill_frames << " frames" << (m_mmap_active ? ", mmap" : "") << ")" << std::endl;
+    return true;
+}
+
+void AlsaAudioSink::close() {
+    if (m_handle) {
+        // Drain any remaining audio data
+        snd_pcm_drain(m_handle);
+        snd_pcm_close(m_handle);
+        m_handle = nullptr;
+    }
+}
+
+void AlsaAudioSink::drop() {
+    if (m_handle) {
+        snd_pcm_drop(m_handle);    // Stop immediately, don't drain buffer
+        snd_pcm_prepare(m_handle); // Prepare for next playback
+    }
+}
+
+bool AlsaAudioSink::recover(int err) {
+    if (err == -EPIPE) {
+        m_xruns++;
+        std::cerr << "[AlsaAudioSink] ALSA underrun, recovering..." << std::endl;
+    }
+    if ((err = snd_pcm_recover(m_handle, err, 1)) < 0) {
+        std::cerr << "[AlsaAudioSink] ALSA write error: " << snd_strerror(err) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+double AlsaAudioSink::delay_ms() const {
+    snd_pcm_sframes_t delay = 0;
+    if (!m_handle || m_sample_rate == 0 || snd_pcm_delay(m_handle, &delay) < 0 || delay < 0) {
+        return 0.0;
+    }
+    return static_cast<double>(delay) * 1000.0 / m_sample_rate;
+}
+
+void AlsaAudioSink::update_latency() {
+    snd_pcm_sframes_t delay = 0;
+    if (snd_pcm_delay(m_handle, &delay) < 0 || delay < 0) {
+        return;
+    }
+    record_latency(static_cast<double>(delay) * 1000.0 / m_sample_rate);
+}
+
+bool AlsaAudioSink::write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) {
+    if (!m_handle) {
+        return false;
+    }
+
+    // Running dry while nothing was queued is the normal end of speech, not a glitch
+    if (snd_pcm_state(m_handle) == SND_PCM_STATE_XRUN) {
+        if (m_idle_drain_expected) {
+            m_idle_drains++;
+            snd_pcm_prepare(m_handle);
+        } else if (!recover(-EPIPE)) {
+            return false;
+        }
+    }
+
+    const int wait_ms = static_cast<int>(std::max<snd_pcm_uframes_t>(1, m_period_frames * 2000 / m_sample_rate));
+    while (frames > 0 && !abort.load()) {
+        snd_pcm_sframes_t avail = snd_pcm_avail_update(m_handle);
+        if (avail < 0) {
+            if (!recover(static_cast<int>(avail))) {
+                return false;
+            }
+            continue;
+        }
+
+        // Keep the device buffer at the target fill instead of stuffing it full:
+        // queued audio is latency an interruption cannot take back
+        snd_pcm_sframes_t queued = static_cast<snd_pcm_sframes_t>(m_buffer_frames) - avail;
+        snd_pcm_sframes_t room = static_cast<snd_pcm_sframes_t>(m_target_fill_frames) - queued;
+        if (room <= 0) {
+            if (snd_pcm_state(m_handle) == SND_PCM_STATE_PREPARED) {
+                snd_pcm_start(m_handle);
+            }
+            int err = snd_pcm_wait(m_handle, wait_ms);
+            if (err < 0 && !recover(err)) {
+                return false;
+            }
+            continue;
+        }
+
+        snd_pcm_uframes_t n = std::min<snd_pcm_uframes_t>(frames, static_cast<snd_pcm_uframes_t>(room));
+        snd_pcm_sframes_t written = m_mmap_active
+            ? snd_pcm_mmap_writei(m_handle, data, n)
+            : snd_pcm_writei(m_handle, data, n);
+        if (written == -EAGAIN) {
+            continue;
+        }
+        if (written < 0) {
+            if (!recover(static_cast<int>(written))) {
+                return false;
+            }
+            continue;
+        }
+        data += written;
+        frames -= static_cast<size_t>(written);
+        m_frames_written += static_cast<uint64_t>(written);
+    }
+
+    // A tail shorter than the start threshold would otherwise wait for more audio
+    if (snd_pcm_state(m_handle) == SND_PCM_STATE_PREPARED &&
+        snd_pcm_avail_update(m_handle) < static_cast<snd_pcm_sframes_t>(m_buffer_frames)) {
+        snd_pcm_start(m_handle);
+    }
+
+    update_latency();
+    return true;
+}
+
+void AlsaAudioSink::end_of_block(bool more_queued) {
+    m_idle_drain_expected = !more_queued;
+}
+
+//
+// NullAudioSink
+//
+
+bool NullAudioSink::open(unsigned int & sample_rate) {
+    m_sample_rate = sample_rate;
+    std::lock_guard<std::mutex> lock(m_clock_mutex);
+    m_play_end = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool NullAudioSink::write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) {
+    if (abort.load()) {
+        return true;
+    }
+
+    consume(data, frames);
+    m_frames_written += frames;
+    if (!m_paced || m_sample_rate == 0) {
+        return true;
+    }
+
+    // Advance a virtual play head; a head already in the past means the
+    // "device" ran dry before this block arrived
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point wake;
+    {
+        std::lock_guard<std::mutex> lock(m_clock_mutex);
+        if (m_play_end < now) {
+            if (m_frames_written.load() > frames) {
+                m_idle_drains++;
+            }
+            m_play_end = now;
+        }
+        m_play_end += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(static_cast<double>(frames) / m_sample_rate));
+        wake = m_play_end - std::chrono::milliseconds(m_lead_ms);
+    }
+
+    // Sleep in short steps so an interruption is honoured promptly
+    while (!abort.load() && (now = std::chrono::steady_clock::now()) < wake) {
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(wake - now, std::chrono::milliseconds(5)));
+    }
+
+    std::lock_guard<std::mutex> lock(m_clock_mutex);
+    record_latency(std::max(0.0, std::chrono::duration<double, std::milli>(m_play_end - std::chrono::steady_clock::now()).count()));
+    return true;
+}
+
+double NullAudioSink::delay_ms() const {
+    if (!m_paced) {
+        return 0.0;
+    }
+    std::lock_guard<std::mutex> lock(m_clock_mutex);
+    return std::max(0.0, std::chrono::duration<double, std::milli>(m_play_end - std::chrono::steady_clock::now()).count());
+}
+
+void NullAudioSink::drop() {
+    std::lock_guard<std::mutex> lock(m_clock_mutex);
+    m_play_end = std::chrono::steady_clock::now();
+}
+
+//
+// WavFileAudioSink
+//
+
+bool WavFileAudioSink::open(unsigned int & sample_rate) {
+    if (!m_writer.open(m_path, sample_rate, 16, 1)) {
+        std::cerr << "[WavFileAudioSink] Cannot open '" << m_path << "' for writing" << std::endl;
+        return false;
+    }
+    m_open = true;
+    std::cout << "[WavFileAudioSink] Writing playback audio to '" << m_path << "' at " << sample_rate << " Hz" << std::endl;
+    return true;
+}
+
+void WavFileAudioSink::close() {
+    if (m_open) {
+        m_writer.close();
+        m_open = false;
+    }
+}
+
+bool WavFileAudioSink::write(const int16_t * data, size_t frames, const std::atomic<bool> & abort) {
+    if (!m_open) {
+        return false;
+    }
+    if (abort.load()) {
+        return true;
+    }
+    m_frames_written += frames;
+    return m_writer.write(data, frames);
+}
+
+//
+// MemoryAudioSink
+//
+
+bool MemoryAudioSink::open(unsigned int & sample_rate) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_rate = sample_rate;
+    }
+    return NullAudioSink::open(sample_rate);
+}
+
+void MemoryAudioSink::consume(const int16_t * data, size_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_audio.insert(m_audio.end(), data, data + frames);
+}
+
+std::vector<int16_t> MemoryAudioSink::captured() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_audio;
+}
+
+unsigned int MemoryAudioSink::sample_rate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rate;
+}
+
+void MemoryAudioSink::clear() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_audio.clear();
+}
@@ -0,0 +1,115 @@
+#define _USE_MATH_DEFINES // for M_PI
+
+#include "chunk_joiner.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+inline int16_t to_int16(float v) {
+    return static_cast<int16_t>(std::clamp(std::round(v), -32768.0f, 32767.0f));
+}
+
+} // namespace
+
+void ChunkJoiner::init(int sample_rate, int crossfade_ms, int keep_silence_ms, float silence_threshold) {
+    m_sample_rate  = sample_rate;
+    m_frame        = static_cast<size_t>(std::max(1, sample_rate / 100));
+    m_keep_silence = static_cast<size_t>(std::max(0, sample_rate * keep_silence_ms / 1000));
+    m_threshold    = silence_threshold;
+
+    // Equal-power ramp: fade_in^2 + fade_out^2 == 1 across the overlap
+    const size_t n = static_cast<size_t>(std::max(1, sample_rate * crossfade_ms / 1000));
+    m_fade_in.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_fade_in[i] = static_cast<float>(std::sin(0.5 * M_PI * (static_cast<double>(i) + 0.5) / n));
+    }
+
+    m_tail.clear();
+}
+
+void ChunkJoiner::reset() {
+    m_tail.clear();
+}
+
+size_t ChunkJoiner::voiced_length(const int16_t * in, size_t n) const {
+    // Walk the energy envelope backwards to the last voiced frame
+    const float threshold = m_threshold * 32768.0f;
+    const float threshold_energy = threshold * threshold;
+
+    size_t end = n;
+    while (end > 0) {
+        const size_t begin = end > m_frame ? end - m_frame : 0;
+        float energy = 0.0f;
+        for (size_t i = begin; i < end; ++i) {
+            const float s = static_cast<float>(in[i]);
+            energy += s * s;
+        }
+        if (energy > threshold_energy * static_cast<float>(end - begin)) {
+            break;
+        }
+        end = begin;
+    }
+
+    return std::min(n, end + m_keep_silence);
+}
+
+void ChunkJoiner::push(const int16_t * in, size_t n, bool last, std::vector<int16_t> & out) {
+    const size_t fade_len = m_fade_in.size();
+    const size_t len = (in && n > 0) ? voiced_length(in, n) : 0;
+
+    size_t pos = 0;
+    out.reserve(out.size() + m_tail.size() + len);
+
+    if (!m_tail.empty()) {
+        if (len == 0) {
+            // Nothing to join with: the held tail becomes the end of the utterance
+            pos = 0;
+        } else {
+            // Crossfade the held tail into the head of this chunk. A short
+            // chunk uses a proportionally shorter overlap through the same table.
+            const size_t overlap = std::min(m_tail.size(), len);
+            const size_t tail_start = m_tail.size() - overlap;
+            out.insert(out.end(), m_tail.begin(), m_tail.begin() + tail_start);
+            for (size_t i = 0; i < overlap; ++i) {
+                const size_t g = i * fade_len / overlap;
+                const float fade_in  = m_fade_in[g];
+                const float fade_out = m_fade_in[fade_len - 1 - g];
+                out.push_back(to_int16(m_tail[tail_start + i] * fade_out + in[i] * fade_in));
+            }
+            pos = overlap;
+            m_tail.clear();
+        }
+    }
+
+    if (last) {
+        const size_t start = out.size();
+        if (!m_tail.empty()) {
+            out.insert(out.end(), m_tail.begin(), m_tail.end());
+            m_tail.clear();
+        }
+        if (len > pos) {
+            out.insert(out.end(), in + pos, in + len);
+        }
+
+        // Fade the end so a trim point inside low-level noise cannot click.
+        // A short ending uses a proportionally shorter ramp through the same
+        // table, so it still starts at unity gain.
+        const size_t avail = out.size() - start;
+        const size_t fade = std::min(fade_len, avail);
+        for (size_t i = 0; i < fade; ++i) {
+            const size_t idx = out.size() - fade + i;
+            const size_t g = i * fade_len / fade;
+            out[idx] = to_int16(out[idx] * m_fade_in[fade_len - 1 - g]);
+        }
+        return;
+    }
+
+    // Hold back the end of this chunk for the crossfade with the next one
+    if (len > pos) {
+        const size_t hold = std::min(fade_len, len - pos);
+        out.insert(out.end(), in + pos, in + (len - hold));
+        m_tail.assign(in + (len - hold), in + len);
+    }
+}
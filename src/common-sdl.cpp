@@ -54,8 +54,6 @@ bool audio_async::init(int capture_id, int sample_rate) {
             continue;
         }
 
-        SDL_SetHintWithPriority(SDL_HINT_AUDIO_RESAMPLING_MODE, "medium", SDL_HINT_OVERRIDE);
-
         int nDevices = SDL_GetNumAudioDevices(SDL_TRUE);
         if (nDevices < 0) {
             last_error = SDL_GetError();
@@ -87,10 +85,10 @@ bool audio_async::init(int capture_id, int sample_rate) {
 
         if (capture_id >= 0) {
             fprintf(stderr, "%s: attempt to open capture device %d : '%s' ...\n", __func__, capture_id, SDL_GetAudioDeviceName(capture_id, SDL_TRUE));
-            m_dev_id_in = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(capture_id, SDL_TRUE), SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, 0);
+            m_dev_id_in = SDL_OpenAudioDevice(SDL_GetAudioDeviceName(capture_id, SDL_TRUE), SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
         } else {
             fprintf(stderr, "%s: attempt to open default capture device ...\n", __func__);
-            m_dev_id_in = SDL_OpenAudioDevice(nullptr, SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, 0);
+            m_dev_id_in = SDL_OpenAudioDevice(nullptr, SDL_TRUE, &capture_spec_requested, &capture_spec_obtained, SDL_AUDIO_ALLOW_FREQUENCY_CHANGE);
         }
 
         if (!m_dev_id_in) {
@@ -109,7 +107,21 @@ bool audio_async::init(int capture_id, int sample_rate) {
             fprintf(stderr, "%s:     - samples per frame: %d\n",                   __func__, capture_spec_obtained.samples);
         }
 
-        m_sample_rate = capture_spec_obtained.freq;
+        // Let the device run at its native rate and convert with the shared
+        // polyphase resampler instead of SDL's internal one
+        m_sample_rate = sample_rate;
+        if (!m_resampler.init(capture_spec_obtained.freq, m_sample_rate)) {
+            SDL_CloseAudioDevice(m_dev_id_in);
+            m_dev_id_in = 0;
+            last_error = "unsupported capture rate conversion";
+            continue;
+        }
+        if (!m_resampler.is_passthrough()) {
+            fprintf(stderr, "%s: resampling capture from %d Hz to %d Hz\n", __func__, capture_spec_obtained.freq, m_sample_rate);
+        }
+        // Reserve for a full device period so the SDL callback does not allocate
+        m_resampled.reserve((static_cast<size_t>(capture_spec_obtained.samples) * m_sample_rate) / capture_spec_obtained.freq + 16);
+
         m_audio.resize((m_sample_rate*m_len_ms)/1000);
         return true;
     }
@@ -181,12 +193,20 @@ void audio_async::callback(uint8_t * stream, int len) {
         return;
     }
 
+    const float * samples = reinterpret_cast<const float *>(stream);
     size_t n_samples = len / sizeof(float);
 
+    // Convert from the device rate to the requested rate
+    if (!m_resampler.is_passthrough()) {
+        m_resampled.clear();
+        m_resampler.process(samples, n_samples, m_resampled);
+        samples   = m_resampled.data();
+        n_samples = m_resampled.size();
+    }
+
     if (n_samples > m_audio.size()) {
+        samples += n_samples - m_audio.size();
         n_samples = m_audio.size();
-
-        stream += (len - (n_samples * sizeof(float)));
     }
 
     //fprintf(stderr, "%s: %zu samples, pos %zu, len %zu\n", __func__, n_samples, m_audio_pos, m_audio_len);
@@ -197,10 +217,10 @@ void audio_async::callback(uint8_t * stream, int len) {
         if (m_audio_pos + n_samples > m_audio.size()) {
             const size_t n0 = m_audio.size() - m_audio_pos;
 
-            memcpy(&m_audio[m_audio_pos], stream, n0 * sizeof(float));
-            memcpy(&m_audio[0], stream + n0 * sizeof(float), (n_samples - n0) * sizeof(float));
+            memcpy(&m_audio[m_audio_pos], samples, n0 * sizeof(float));
+            memcpy(&m_audio[0], samples + n0, (n_samples - n0) * sizeof(float));
         } else {
-            memcpy(&m_audio[m_audio_pos], stream, n_samples * sizeof(float));
+            memcpy(&m_audio[m_audio_pos], samples, n_samples * sizeof(float));
         }
         m_audio_pos = (m_audio_pos + n_samples) % m_audio.size();
         m_audio_len = std::min(m_audio_len + n_samples, m_audio.size());
@@ -2,14 +2,21 @@
 
 #include "common.h"
 
+#include <chrono>
 #include <cmath>
 #include <codecvt>
 #include <cstring>
+#include <filesystem>
 #include <fstream>
 #include <locale>
 #include <regex>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 // Function to check if the next argument exists
 static std::string get_next_arg(int& i, int argc, char** argv, const std::string& flag, gpt_params& params) {
     if (i + 1 < argc && argv[i + 1][0] != '-') {
@@ -243,74 +250,595 @@ std::map<std::string, int32_t> json_parse(const std::string & fname) {
     return result;
 }
 
-void gpt_split_words(std::string str, std::vector<std::string>& words) {
-    const std::string pattern = R"('s|'t|'re|'ve|'m|'ll|'d| ?[[:alpha:]]+| ?[[:digit:]]+| ?[^\s[:alpha:][:digit:]]+|\s+(?!\S)|\s+)";
-    const std::regex re(pattern);
-    std::smatch m;
+void gpt_token_trie::build(const std::map<std::string, int32_t> & token_to_id) {
+    // std::map already orders keys bytewise
+    std::vector<std::pair<std::string_view, int32_t>> keys;
+    keys.reserve(token_to_id.size());
+    for (const auto & kv : token_to_id) {
+        keys.emplace_back(kv.first, kv.second);
+    }
+    build(keys);
+}
 
-    while (std::regex_search(str, m, re)) {
-        for (auto x : m) {
-            words.push_back(x);
+void gpt_token_trie::build(const std::vector<std::pair<std::string_view, int32_t>> & keys) {
+    nodes.assign(1, node());
+    edge_bytes.clear();
+    edge_nodes.clear();
+    std::fill(std::begin(root_next), std::end(root_next), 0u);
+    n_tokens = keys.size();
+
+    // with the keys sorted, every node's tokens form a contiguous range;
+    // nodes are expanded breadth first so each one's edges are appended in
+    // one run
+    struct range { uint32_t node; size_t lo, hi, depth; };
+    std::deque<range> queue;
+    queue.push_back({0, 0, keys.size(), 0});
+
+    while (!queue.empty()) {
+        range r = queue.front();
+        queue.pop_front();
+
+        if (r.lo < r.hi && keys[r.lo].first.size() == r.depth) {
+            nodes[r.node].id = keys[r.lo].second;
+            r.lo++;
         }
-        str = m.suffix();
+
+        nodes[r.node].first_edge = (uint32_t) edge_bytes.size();
+        for (size_t i = r.lo; i < r.hi; ) {
+            const uint8_t c = (uint8_t) keys[i].first[r.depth];
+            size_t j = i + 1;
+            while (j < r.hi && (uint8_t) keys[j].first[r.depth] == c) {
+                j++;
+            }
+
+            const uint32_t child = (uint32_t) nodes.size();
+            nodes.emplace_back();
+            edge_bytes.push_back(c);
+            edge_nodes.push_back(child);
+            if (r.node == 0) {
+                root_next[c] = child;
+            }
+            queue.push_back({child, i, j, r.depth + 1});
+            i = j;
+        }
+        nodes[r.node].n_edges = (uint16_t) (edge_bytes.size() - nodes[r.node].first_edge);
     }
 }
 
-std::vector<gpt_vocab::id> gpt_tokenize(const gpt_vocab & vocab, const std::string & text) {
-    std::vector<std::string> words;
+size_t gpt_token_trie::longest_match(const char * s, size_t n, int32_t & id) const {
+    if (n == 0) {
+        return 0;
+    }
+    uint32_t cur = root_next[(uint8_t) s[0]];
+    if (cur == 0) {
+        return 0;
+    }
 
-    // first split the text into words
-    {
-        std::string str = text;
-
-        // Generate the subpattern from the special_tokens vector if it's not empty
-        if (!vocab.special_tokens.empty()) {
-            const std::regex escape(R"([\[\\\^\$\.\|\?\*\+\(\)\{\}])");
-            std::string special_tokens_subpattern;
-            for (const auto & token : vocab.special_tokens) {
-                if (!special_tokens_subpattern.empty()) {
-                    special_tokens_subpattern += "|";
+    size_t best = 0;
+    for (size_t i = 1; ; ++i) {
+        const node & nd = nodes[cur];
+        if (nd.id >= 0) {
+            best = i;
+            id   = nd.id;
+        }
+        if (i == n || nd.n_edges == 0) {
+            break;
+        }
+        const uint8_t * first = edge_bytes.data() + nd.first_edge;
+        const uint8_t * last  = first + nd.n_edges;
+        const uint8_t * it    = std::lower_bound(first, last, (uint8_t) s[i]);
+        if (it == last || *it != (uint8_t) s[i]) {
+            break;
+        }
+        cur = edge_nodes[it - edge_bytes.data()];
+    }
+    return best;
+}
+
+namespace {
+
+void gpt_build_trie(const gpt_vocab & vocab, gpt_token_trie & trie) {
+    if (vocab.file) {
+        trie = vocab.file->trie();
+    } else {
+        trie.build(vocab.token_to_id);
+    }
+}
+
+} // namespace
+
+void gpt_vocab::build_trie() {
+    gpt_build_trie(*this, trie);
+}
+
+size_t gpt_vocab::size() const {
+    return file ? file->size() : id_to_token.size();
+}
+
+gpt_vocab::id gpt_vocab::find(const std::string & text) const {
+    if (file) {
+        return file->find(text.data(), text.size());
+    }
+    const auto it = token_to_id.find(text);
+    return it == token_to_id.end() ? -1 : it->second;
+}
+
+std::string_view gpt_vocab::token_text(id i) const {
+    if (file) {
+        return file->token(i);
+    }
+    const auto it = id_to_token.find(i);
+    return it == id_to_token.end() ? std::string_view() : std::string_view(it->second);
+}
+
+//
+// Binary vocab
+//
+
+namespace {
+
+constexpr uint32_t kVocabMagic   = 0x62766f67; // "govb" read little-endian
+constexpr uint32_t kVocabVersion = 1;
+constexpr uint32_t kVocabEmpty   = UINT32_MAX;
+
+struct gpt_vocab_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t n_tokens;
+    uint32_t n_ids;     // id_index covers ids [0, n_ids)
+    uint32_t n_buckets;
+    uint32_t n_slots;
+    uint64_t seed;
+    uint64_t blob_size;
+    uint64_t reserved;
+};
+static_assert(sizeof(gpt_vocab_header) == 48, "binary vocab header layout");
+
+struct gpt_vocab_entry {
+    uint32_t offset;
+    uint32_t length;
+    int32_t  id;
+};
+static_assert(sizeof(gpt_vocab_entry) == 12, "binary vocab entry layout");
+
+inline uint64_t gpt_vocab_mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+inline uint64_t gpt_vocab_hash(const char * s, size_t n, uint64_t seed) {
+    uint64_t h = 0xcbf29ce484222325ULL ^ seed;
+    for (size_t i = 0; i < n; ++i) {
+        h = (h ^ (uint8_t) s[i]) * 0x100000001b3ULL;
+    }
+    return gpt_vocab_mix(h);
+}
+
+// maps 32 hash bits onto [0, n) without a division
+inline uint32_t gpt_vocab_reduce(uint64_t h, uint32_t n) {
+    return (uint32_t) (((h & 0xffffffffULL) * n) >> 32);
+}
+
+inline uint32_t gpt_vocab_bucket(uint64_t h, uint32_t n_buckets) {
+    return gpt_vocab_reduce(h >> 32, n_buckets);
+}
+
+inline uint32_t gpt_vocab_slot(uint64_t h, uint32_t disp, uint32_t n_slots) {
+    return gpt_vocab_reduce(gpt_vocab_mix(h ^ (disp * 0x9e3779b97f4a7c15ULL)), n_slots);
+}
+
+// Hash-and-displace: keys are grouped into buckets, and each bucket, largest
+// first, gets the first displacement that puts all its keys in free slots.
+// Returns false if some bucket finds none, to be retried with another seed.
+bool gpt_vocab_place(const std::vector<uint64_t> & hashes, uint32_t n_buckets,
+                     std::vector<uint32_t> & disps, std::vector<uint32_t> & slots) {
+    const uint32_t n_slots = (uint32_t) slots.size();
+
+    std::vector<std::vector<uint32_t>> buckets(n_buckets);
+    for (uint32_t i = 0; i < hashes.size(); ++i) {
+        buckets[gpt_vocab_bucket(hashes[i], n_buckets)].push_back(i);
+    }
+    std::vector<uint32_t> order(n_buckets);
+    for (uint32_t b = 0; b < n_buckets; ++b) {
+        order[b] = b;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        return buckets[a].size() > buckets[b].size();
+    });
+
+    std::fill(disps.begin(), disps.end(), 0u);
+    std::fill(slots.begin(), slots.end(), kVocabEmpty);
+
+    std::vector<uint32_t> placed;
+    for (uint32_t b : order) {
+        const auto & keys = buckets[b];
+        if (keys.empty()) {
+            break;
+        }
+        bool ok = false;
+        for (uint32_t d = 0; d < (1u << 20) && !ok; ++d) {
+            placed.clear();
+            ok = true;
+            for (uint32_t k : keys) {
+                const uint32_t s = gpt_vocab_slot(hashes[k], d, n_slots);
+                if (slots[s] != kVocabEmpty || std::find(placed.begin(), placed.end(), s) != placed.end()) {
+                    ok = false;
+                    break;
                 }
-                special_tokens_subpattern += std::regex_replace(token, escape, R"(\$&)");
+                placed.push_back(s);
             }
-
-            std::regex re(special_tokens_subpattern);
-            std::smatch m;
-            // Split the text by special tokens.
-            while (std::regex_search(str, m, re)) {
-                // Split the substrings in-between special tokens into words.
-                gpt_split_words(m.prefix(), words);
-                // Add matched special tokens as words.
-                for (auto x : m) {
-                    words.push_back(x);
+            if (ok) {
+                disps[b] = d;
+                for (size_t i = 0; i < keys.size(); ++i) {
+                    slots[placed[i]] = keys[i];
                 }
-                str = m.suffix();
             }
-            // Remaining text without special tokens will be handled below.
         }
+        if (!ok) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+gpt_vocab_file::~gpt_vocab_file() {
+    close();
+}
+
+bool gpt_vocab_file::is_binary(const std::string & fname) {
+    std::ifstream fin(fname, std::ios::binary);
+    uint32_t magic = 0;
+    return fin.read((char *) &magic, sizeof(magic)) && magic == kVocabMagic;
+}
+
+bool gpt_vocab_file::open(const std::string & fname) {
+    close();
+
+    const int fd = ::open(fname.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: failed to open '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(gpt_vocab_header)) {
+        fprintf(stderr, "%s: '%s' is too small for a binary vocab\n", __func__, fname.c_str());
+        ::close(fd);
+        return false;
+    }
+    void * addr = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (addr == MAP_FAILED) {
+        fprintf(stderr, "%s: failed to map '%s'\n", __func__, fname.c_str());
+        return false;
+    }
+    mapped      = addr;
+    mapped_size = (size_t) st.st_size;
+
+    gpt_vocab_header hdr;
+    memcpy(&hdr, mapped, sizeof(hdr));
+
+    const uint64_t expected = sizeof(gpt_vocab_header)
+                            + (uint64_t) hdr.n_tokens * sizeof(gpt_vocab_entry)
+                            + ((uint64_t) hdr.n_ids + hdr.n_buckets + hdr.n_slots) * sizeof(uint32_t)
+                            + hdr.blob_size;
+    const bool valid = hdr.magic == kVocabMagic && hdr.version == kVocabVersion &&
+                       expected == mapped_size && hdr.n_slots >= hdr.n_tokens &&
+                       (hdr.n_tokens == 0 || hdr.n_buckets > 0);
+    if (!valid) {
+        fprintf(stderr, "%s: '%s' is not a valid binary vocab\n", __func__, fname.c_str());
+        close();
+        return false;
+    }
+
+    const char * p = (const char *) mapped + sizeof(gpt_vocab_header);
+    entries  = (const entry *) p;    p += (size_t) hdr.n_tokens * sizeof(entry);
+    id_index = (const uint32_t *) p; p += (size_t) hdr.n_ids * sizeof(uint32_t);
+    disps    = (const uint32_t *) p; p += (size_t) hdr.n_buckets * sizeof(uint32_t);
+    slots    = (const uint32_t *) p; p += (size_t) hdr.n_slots * sizeof(uint32_t);
+    blob     = p;
+
+    n_tokens  = hdr.n_tokens;
+    n_ids     = hdr.n_ids;
+    n_buckets = hdr.n_buckets;
+    n_slots   = hdr.n_slots;
+    seed      = hdr.seed;
+
+    // lookups trust the offsets from here on
+    for (uint32_t i = 0; i < n_tokens; ++i) {
+        if ((uint64_t) entries[i].offset + entries[i].length > hdr.blob_size) {
+            fprintf(stderr, "%s: '%s' has a token outside its string table\n", __func__, fname.c_str());
+            close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void gpt_vocab_file::close() {
+    if (mapped) {
+        munmap(mapped, mapped_size);
+    }
+    mapped      = nullptr;
+    mapped_size = 0;
+    n_tokens = n_ids = n_buckets = n_slots = 0;
+    entries  = nullptr;
+    id_index = disps = slots = nullptr;
+    blob     = nullptr;
+
+    std::lock_guard<std::mutex> lock(trie_mutex);
+    trie_cache = gpt_token_trie();
+}
+
+int32_t gpt_vocab_file::find(const char * s, size_t n) const {
+    if (n_tokens == 0) {
+        return -1;
+    }
+    const uint64_t h = gpt_vocab_hash(s, n, seed);
+    const uint32_t i = slots[gpt_vocab_slot(h, disps[gpt_vocab_bucket(h, n_buckets)], n_slots)];
+    if (i >= n_tokens) {
+        return -1;
+    }
+    const entry & e = entries[i];
+    return e.length == n && memcmp(blob + e.offset, s, n) == 0 ? e.id : -1;
+}
+
+std::string_view gpt_vocab_file::token(int32_t id) const {
+    if (id < 0 || (uint32_t) id >= n_ids || id_index[id] >= n_tokens) {
+        return std::string_view();
+    }
+    const entry & e = entries[id_index[id]];
+    return std::string_view(blob + e.offset, e.length);
+}
+
+std::string_view gpt_vocab_file::token_at(size_t i, int32_t & id) const {
+    const entry & e = entries[i];
+    id = e.id;
+    return std::string_view(blob + e.offset, e.length);
+}
+
+const gpt_token_trie & gpt_vocab_file::trie() const {
+    std::lock_guard<std::mutex> lock(trie_mutex);
+    if (trie_cache.nodes.empty() || trie_cache.n_tokens != n_tokens) {
+        std::vector<std::pair<std::string_view, int32_t>> keys(n_tokens);
+        for (size_t i = 0; i < keys.size(); ++i) {
+            keys[i].first = token_at(i, keys[i].second);
+        }
+        trie_cache.build(keys);
+    }
+    return trie_cache;
+}
+
+bool gpt_vocab_save_binary(const gpt_vocab & vocab, const std::string & fname) {
+    // tokens in bytewise order, as the map already keeps them
+    std::vector<gpt_vocab_entry> entries;
+    std::vector<uint64_t> hashes;
+    std::string blob;
+    uint32_t n_ids = 0;
+
+    entries.reserve(vocab.token_to_id.size());
+    for (const auto & kv : vocab.token_to_id) {
+        if (kv.second < 0 || blob.size() + kv.first.size() > UINT32_MAX) {
+            fprintf(stderr, "%s: cannot store token %d\n", __func__, kv.second);
+            return false;
+        }
+        entries.push_back({(uint32_t) blob.size(), (uint32_t) kv.first.size(), kv.second});
+        blob += kv.first;
+        n_ids = std::max(n_ids, (uint32_t) kv.second + 1);
+    }
+
+    std::vector<uint32_t> id_index(n_ids, kVocabEmpty);
+    for (uint32_t i = 0; i < entries.size(); ++i) {
+        if (id_index[entries[i].id] == kVocabEmpty) {
+            id_index[entries[i].id] = i;
+        }
+    }
+
+    // ~4 keys per bucket and a 90% slot load keep construction to a few
+    // tries per bucket
+    const uint32_t n_tokens  = (uint32_t) entries.size();
+    const uint32_t n_buckets = std::max(1u, n_tokens / 4);
+    const uint32_t n_slots   = std::max(1u, n_tokens + n_tokens / 9);
+
+    std::vector<uint32_t> disps(n_buckets);
+    std::vector<uint32_t> slots(n_slots);
+    uint64_t seed = 0;
+    for (bool placed = false; !placed; ) {
+        if (seed == 16) {
+            fprintf(stderr, "%s: failed to build the token hash\n", __func__);
+            return false;
+        }
+        hashes.clear();
+        for (const auto & e : entries) {
+            hashes.push_back(gpt_vocab_hash(blob.data() + e.offset, e.length, seed));
+        }
+        placed = gpt_vocab_place(hashes, n_buckets, disps, slots);
+        if (!placed) {
+            ++seed;
+        }
+    }
+
+    gpt_vocab_header hdr = {};
+    hdr.magic     = kVocabMagic;
+    hdr.version   = kVocabVersion;
+    hdr.n_tokens  = n_tokens;
+    hdr.n_ids     = n_ids;
+    hdr.n_buckets = n_buckets;
+    hdr.n_slots   = n_slots;
+    hdr.seed      = seed;
+    hdr.blob_size = blob.size();
+
+    // written aside and renamed, so a reader never maps a partial file
+    const std::string tmp = fname + ".tmp";
+    {
+        std::ofstream fout(tmp, std::ios::binary | std::ios::trunc);
+        fout.write((const char *) &hdr, sizeof(hdr));
+        fout.write((const char *) entries.data(), entries.size() * sizeof(gpt_vocab_entry));
+        fout.write((const char *) id_index.data(), id_index.size() * sizeof(uint32_t));
+        fout.write((const char *) disps.data(), disps.size() * sizeof(uint32_t));
+        fout.write((const char *) slots.data(), slots.size() * sizeof(uint32_t));
+        fout.write(blob.data(), blob.size());
+        fout.close();
+        if (!fout) {
+            fprintf(stderr, "%s: failed to write '%s'\n", __func__, tmp.c_str());
+            std::remove(tmp.c_str());
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), fname.c_str()) != 0) {
+        fprintf(stderr, "%s: failed to rename '%s' to '%s'\n", __func__, tmp.c_str(), fname.c_str());
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+namespace {
+
+// Classes used by the split pattern, as std::regex sees them in the "C"
+// locale: bytes outside ASCII are neither letters, digits nor whitespace
+enum class gpt_char_class { alpha, digit, space, other };
+
+inline gpt_char_class gpt_classify(char ch) {
+    const unsigned char c = (unsigned char) ch;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) return gpt_char_class::alpha;
+    if (c >= '0' && c <= '9') return gpt_char_class::digit;
+    if (c == ' ' || (c >= '\t' && c <= '\r')) return gpt_char_class::space;
+    return gpt_char_class::other;
+}
+
+inline size_t gpt_class_run(const char * s, size_t n, size_t p, gpt_char_class cls) {
+    size_t end = p;
+    while (end < n && gpt_classify(s[end]) == cls) {
+        end++;
+    }
+    return end - p;
+}
+
+// Length of the word starting at s[p], taking the alternatives of the split
+// pattern in order, as std::regex_search does
+size_t gpt_word_length(const char * s, size_t n, size_t p) {
+    // 's|'t|'re|'ve|'m|'ll|'d
+    if (s[p] == '\'' && p + 1 < n) {
+        const char a = s[p + 1];
+        if (a == 's' || a == 't' || a == 'm' || a == 'd') {
+            return 2;
+        }
+        if (p + 2 < n) {
+            const char b = s[p + 2];
+            if ((a == 'r' && b == 'e') || (a == 'v' && b == 'e') || (a == 'l' && b == 'l')) {
+                return 3;
+            }
+        }
+    }
 
-        gpt_split_words(str, words);
+    //  ?[[:alpha:]]+| ?[[:digit:]]+| ?[^\s[:alpha:][:digit:]]+
+    // (a space is in none of these classes, so at most one can match)
+    if (s[p] == ' ' && p + 1 < n && gpt_classify(s[p + 1]) != gpt_char_class::space) {
+        return 1 + gpt_class_run(s, n, p + 1, gpt_classify(s[p + 1]));
+    }
+    const gpt_char_class cls = gpt_classify(s[p]);
+    if (cls != gpt_char_class::space) {
+        return gpt_class_run(s, n, p, cls);
+    }
+
+    // \s+(?!\S) leaves the last space of a run before a word to that word;
+    // otherwise \s+
+    const size_t run = gpt_class_run(s, n, p, gpt_char_class::space);
+    if (p + run < n && run > 1) {
+        return run - 1;
+    }
+    return run;
+}
+
+template <typename F>
+void gpt_for_each_word(const char * s, size_t n, F && f) {
+    for (size_t p = 0; p < n; ) {
+        const size_t len = gpt_word_length(s, n, p);
+        f(s + p, len);
+        p += len;
+    }
+}
+
+} // namespace
+
+void gpt_split_words(std::string str, std::vector<std::string>& words) {
+    gpt_for_each_word(str.data(), str.size(), [&](const char * word, size_t len) {
+        words.emplace_back(word, len);
+    });
+}
+
+std::vector<gpt_vocab::id> gpt_tokenize(const gpt_vocab & vocab, const std::string & text) {
+    // a vocab filled without build_trie() gets a temporary trie
+    const gpt_token_trie * trie = &vocab.trie;
+    gpt_token_trie local_trie;
+    const size_t n_tokens = vocab.file ? vocab.file->size() : vocab.token_to_id.size();
+    if (vocab.trie.n_tokens != n_tokens || vocab.trie.nodes.empty()) {
+        if (vocab.file) {
+            trie = &vocab.file->trie();
+        } else {
+            gpt_build_trie(vocab, local_trie);
+            trie = &local_trie;
+        }
     }
 
-    // find the longest token that forms each word in words:
     std::vector<gpt_vocab::id> tokens;
-    for (const auto & word : words) {
-        for (int i = 0; i < (int) word.size(); ){
-            for (int j = word.size() - 1; j >= i; j--){
-                auto cand = word.substr(i, j-i+1);
-                auto it = vocab.token_to_id.find(cand);
-                if (it != vocab.token_to_id.end()){ // word.substr(i, j-i+1) in vocab
-                    tokens.push_back(it->second);
-                    i = j + 1;
-                    break;
-                }
-                else if (j == i){ // word.substr(i, 1) has no matching
-                    fprintf(stderr, "%s: unknown token '%s'\n", __func__, word.substr(i, 1).data());
-                    i++;
-                }
+
+    // find the longest token that forms each word
+    auto add_word = [&](const char * word, size_t len) {
+        for (size_t i = 0; i < len; ) {
+            gpt_vocab::id id = -1;
+            const size_t match = trie->longest_match(word + i, len - i, id);
+            if (match > 0) {
+                tokens.push_back(id);
+                i += match;
+            } else { // word[i] has no matching
+                fprintf(stderr, "%s: unknown token '%s'\n", __func__, std::string(1, word[i]).data());
+                i++;
             }
         }
+    };
+
+    const char * s = text.data();
+    const size_t n = text.size();
+
+    // split the text by special tokens: the leftmost match wins, and among
+    // tokens matching at the same place the first one listed
+    std::vector<size_t> next_match;
+    for (const auto & token : vocab.special_tokens) {
+        next_match.push_back(token.empty() ? std::string::npos : text.find(token));
     }
+    size_t start = 0;
+    while (!vocab.special_tokens.empty()) {
+        size_t best_pos = std::string::npos;
+        size_t best_len = 0;
+        for (size_t k = 0; k < vocab.special_tokens.size(); ++k) {
+            const std::string & token = vocab.special_tokens[k];
+            if (next_match[k] < start) {
+                next_match[k] = text.find(token, start);
+            }
+            if (next_match[k] < best_pos) {
+                best_pos = next_match[k];
+                best_len = token.size();
+            }
+        }
+        if (best_pos == std::string::npos) {
+            break;
+        }
+        // split the text in-between special tokens into words, then add the
+        // matched special token as a word
+        gpt_for_each_word(s + start, best_pos - start, add_word);
+        add_word(s + best_pos, best_len);
+        start = best_pos + best_len;
+    }
+
+    gpt_for_each_word(s + start, n - start, add_word);
 
     return tokens;
 }
@@ -365,12 +893,14 @@ void test_gpt_tokenizer(gpt_vocab & vocab, const std::string & fpath_test){
             fprintf(stderr, "%s : failed test: '%s'\n", __func__, test.first.c_str());
             fprintf(stderr, "%s : tokens in hf:   ", __func__);
             for (const auto & t : test.second) {
-                fprintf(stderr, "%s(%d), ", vocab.id_to_token[t].c_str(), t);
+                const std::string_view text = vocab.token_text(t);
+                fprintf(stderr, "%.*s(%d), ", (int) text.size(), text.data(), t);
             }
             fprintf(stderr, "\n");
             fprintf(stderr, "%s : tokens in ggml: ", __func__);
             for (const auto & t : tokens) {
-                fprintf(stderr, "%s(%d), ", vocab.id_to_token[t].c_str(), t);
+                const std::string_view text = vocab.token_text(t);
+                fprintf(stderr, "%.*s(%d), ", (int) text.size(), text.data(), t);
             }
             fprintf(stderr, "\n");
         }
@@ -379,16 +909,73 @@ void test_gpt_tokenizer(gpt_vocab & vocab, const std::string & fpath_test){
     fprintf(stderr, "%s : %zu tests failed out of %zu tests.\n", __func__, n_fails, tests.size());
 }
 
-bool gpt_vocab_init(const std::string & fname, gpt_vocab & vocab) {
+bool gpt_vocab_init(const std::string & fname, gpt_vocab & vocab, const std::string & cache_dir) {
     printf("%s: loading vocab from '%s'\n", __func__, fname.c_str());
 
-    vocab.token_to_id = ::json_parse(fname);
+    const auto t_start = std::chrono::steady_clock::now();
+
+    // the cached copy is named after fname and a hash of its full path, so
+    // vocabularies with the same file name do not collide
+    std::string cache_fname;
+    if (!cache_dir.empty()) {
+        std::error_code ec;
+        const auto path = std::filesystem::absolute(fname, ec);
+        char hash[17];
+        snprintf(hash, sizeof(hash), "%016llx", (unsigned long long) std::hash<std::string>{}(path.string()));
+        cache_fname = (std::filesystem::path(cache_dir) /
+                       (std::filesystem::path(fname).filename().string() + "." + hash + ".bin")).string();
+    }
 
-    for (const auto & kv : vocab.token_to_id) {
-        vocab.id_to_token[kv.second] = kv.first;
+    // prefer the binary form: fname itself, or a cache that is newer than it
+    std::string bin_fname;
+    if (gpt_vocab_file::is_binary(fname)) {
+        bin_fname = fname;
+    } else if (!cache_fname.empty()) {
+        std::error_code ec_json, ec_bin;
+        const auto t_json = std::filesystem::last_write_time(fname, ec_json);
+        const auto t_bin  = std::filesystem::last_write_time(cache_fname, ec_bin);
+        if (!ec_bin && (ec_json || t_bin >= t_json) && gpt_vocab_file::is_binary(cache_fname)) {
+            bin_fname = cache_fname;
+        }
+    }
+
+    vocab.file.reset();
+    vocab.token_to_id.clear();
+    vocab.id_to_token.clear();
+    vocab.trie = gpt_token_trie();
+
+    if (!bin_fname.empty()) {
+        auto file = std::make_shared<gpt_vocab_file>();
+        if (file->open(bin_fname)) {
+            vocab.file = std::move(file);
+        } else {
+            fprintf(stderr, "%s: ignoring binary vocab '%s'\n", __func__, bin_fname.c_str());
+        }
+    }
+
+    if (!vocab.file) {
+        vocab.token_to_id = ::json_parse(fname);
+
+        for (const auto & kv : vocab.token_to_id) {
+            vocab.id_to_token[kv.second] = kv.first;
+        }
+
+        if (!cache_fname.empty() && !vocab.token_to_id.empty()) {
+            std::error_code ec;
+            std::filesystem::create_directories(cache_dir, ec);
+            if (gpt_vocab_save_binary(vocab, cache_fname)) {
+                printf("%s: cached binary vocab in '%s'\n", __func__, cache_fname.c_str());
+            } else {
+                fprintf(stderr, "%s: warning: could not cache the vocab in '%s'\n", __func__, cache_fname.c_str());
+            }
+        }
+
+        vocab.build_trie();
     }
 
-    printf("%s: vocab size = %d\n", __func__, (int) vocab.token_to_id.size());
+    const double t_load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+    printf("%s: vocab size = %d (%s, %.2f ms)\n", __func__, (int) vocab.size(),
+           vocab.file ? "binary" : "json", t_load_ms);
 
     // print the vocabulary
     //for (auto kv : vocab.token_to_id) {
@@ -405,7 +992,7 @@ gpt_vocab::id gpt_sample_top_k_top_p(
         double top_p,
         double temp,
         std::mt19937 & rng) {
-    int n_logits = vocab.id_to_token.size();
+    int n_logits = vocab.size();
 
     std::vector<std::pair<double, gpt_vocab::id>> logits_id;
     logits_id.reserve(n_logits);
@@ -490,7 +1077,7 @@ gpt_vocab::id gpt_sample_top_k_top_p_repeat(
         float repeat_penalty,
         std::mt19937 & rng) {
 
-    int n_logits = vocab.id_to_token.size();
+    int n_logits = vocab.size();
 
     const auto * plogits = logits;
 
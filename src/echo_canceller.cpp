@@ -0,0 +1,274 @@
+#include "echo_canceller.h"
+#include "pcm_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// Playback times within this of the running timeline are treated as contiguous
+constexpr auto kContiguityTolerance = std::chrono::milliseconds(20);
+
+// The reference is read this much ahead of the capture time so that jitter in
+// the playback-time estimate cannot put the echo before its reference
+constexpr auto kAlignmentMargin = std::chrono::milliseconds(10);
+
+// A double-talk hold that lasts this long is taken as a misdetection
+constexpr int kDoubleTalkReleaseMs = 1000;
+
+// Echo return loss enhancement (as a power ratio) that marks the filter as
+// converged (10 dB), and below which a converged filter sees double talk (3 dB)
+constexpr float kConvergedErle = 10.0f;
+constexpr float kDoubleTalkErle = 2.0f;
+
+Clock::duration samples_to_duration(int64_t n, int rate) {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(n) / rate));
+}
+
+int64_t duration_to_samples(Clock::duration d, int rate) {
+    return std::llround(std::chrono::duration<double>(d).count() * rate);
+}
+
+} // namespace
+
+void EchoReference::configure(int sample_rate, float history_seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_rate = sample_rate;
+    m_ring.assign(static_cast<size_t>(std::max(1.0f, sample_rate * history_seconds)), 0.0f);
+    m_written = 0;
+    m_end_time = clock::time_point{};
+    m_resampler.reset();
+}
+
+int EchoReference::sample_rate() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_rate;
+}
+
+void EchoReference::append(const float * data, size_t n) {
+    const size_t size = m_ring.size();
+    for (size_t i = 0; i < n; ++i) {
+        m_ring[static_cast<size_t>(m_written + static_cast<int64_t>(i)) % size] = data[i];
+    }
+    m_written += static_cast<int64_t>(n);
+}
+
+void EchoReference::push(const int16_t * data, size_t n, unsigned int rate, clock::time_point play_time) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_rate <= 0 || !data || n == 0 || rate == 0) {
+        return;
+    }
+
+    // Re-anchor the timeline across playback gaps, filling them with silence
+    const bool discontinuous = m_written == 0 ||
+                               play_time > m_end_time + kContiguityTolerance ||
+                               play_time + kContiguityTolerance < m_end_time;
+    if (discontinuous) {
+        if (m_written > 0 && play_time > m_end_time) {
+            const int64_t gap = std::min<int64_t>(duration_to_samples(play_time - m_end_time, m_rate),
+                                                  static_cast<int64_t>(m_ring.size()));
+            m_scratch_out.assign(static_cast<size_t>(gap), 0.0f);
+            append(m_scratch_out.data(), m_scratch_out.size());
+        }
+        m_end_time = play_time;
+        m_resampler.reset();
+    }
+
+    m_scratch_in.resize(n);
+    pcm::int16_to_float(data, m_scratch_in.data(), n);
+
+    const float * out = m_scratch_in.data();
+    size_t out_n = n;
+    if (static_cast<int>(rate) != m_rate) {
+        if (m_resampler.in_rate() != static_cast<int>(rate) || m_resampler.out_rate() != m_rate) {
+            if (!m_resampler.init(static_cast<int>(rate), m_rate)) {
+                return;
+            }
+        }
+        m_scratch_out.clear();
+        m_resampler.process(m_scratch_in.data(), n, m_scratch_out);
+        out = m_scratch_out.data();
+        out_n = m_scratch_out.size();
+    }
+
+    append(out, out_n);
+    m_end_time += samples_to_duration(static_cast<int64_t>(out_n), m_rate);
+}
+
+void EchoReference::discard_after(clock::time_point t) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_rate <= 0 || m_written == 0 || m_end_time <= t) {
+        return;
+    }
+    m_written -= std::min(m_written, duration_to_samples(m_end_time - t, m_rate));
+    m_end_time = t;
+    m_resampler.reset();
+}
+
+bool EchoReference::read(clock::time_point end_time, size_t n, float * out) {
+    std::fill(out, out + n, 0.0f);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_rate <= 0 || m_written == 0) {
+        return false;
+    }
+
+    const int64_t end = m_written - duration_to_samples(m_end_time - end_time, m_rate);
+    const int64_t start = end - static_cast<int64_t>(n);
+    const int64_t first = std::max<int64_t>({start, m_written - static_cast<int64_t>(m_ring.size()), 0});
+    const int64_t last = std::min(end, m_written);
+
+    bool active = false;
+    for (int64_t k = first; k < last; ++k) {
+        const float v = m_ring[static_cast<size_t>(k) % m_ring.size()];
+        out[k - start] = v;
+        active = active || v != 0.0f;
+    }
+    return active;
+}
+
+EchoCanceller::EchoCanceller(std::shared_ptr<EchoReference> reference, const Options & options)
+    : m_reference(std::move(reference)), m_options(options) {
+    m_taps = static_cast<size_t>(std::max(1, options.sample_rate * options.tail_ms / 1000));
+    m_hangover = static_cast<size_t>(std::max(1, options.sample_rate * 30 / 1000));
+    m_weights.assign(m_taps, 0.0f);
+    m_x.assign(m_taps - 1, 0.0f);
+}
+
+void EchoCanceller::reset() {
+    std::fill(m_weights.begin(), m_weights.end(), 0.0f);
+    m_x.assign(m_taps - 1, 0.0f);
+    m_quiet = 0;
+    m_double_talk = 0;
+    m_double_talk_run = 0;
+    m_converged = false;
+    m_erle = 1.0f;
+    m_gain = 1.0f;
+}
+
+void EchoCanceller::process(float * samples, size_t n, Clock::time_point captured) {
+    if (!samples || n == 0) {
+        return;
+    }
+    const auto start_time = Clock::now();
+
+    const size_t history = m_taps - 1;
+    m_x.resize(history + n);
+    if (m_reference->read(captured - kAlignmentMargin, n, m_x.data() + history)) {
+        m_quiet = 0;
+    } else {
+        m_quiet += n;
+    }
+
+    // Echo of the last reference audio can still arrive for one filter length
+    const bool active = m_quiet < m_taps;
+    float target_gain = 1.0f;
+
+    if (active) {
+        // First pass with the current filter, to judge the block before
+        // learning from it
+        float d_energy = 0.0f;
+        float e_energy = 0.0f;
+        float y_energy = 0.0f;
+        m_y.resize(n);
+        for (size_t i = 0; i < n; ++i) {
+            const float * x = m_x.data() + i;
+            float y = 0.0f;
+            for (size_t j = 0; j < m_taps; ++j) {
+                y += m_weights[j] * x[j];
+            }
+            const float e = samples[i] - y;
+            m_y[i] = y;
+            d_energy += samples[i] * samples[i];
+            e_energy += e * e;
+            y_energy += y * y;
+        }
+
+        // Double talk: a filter that has already cancelled well suddenly
+        // removes little, so something other than echo is in the block.
+        // Adapting then would tune the filter to the near-end speaker.
+        const bool echo_cancelled = e_energy * kConvergedErle < d_energy;
+        if (echo_cancelled) {
+            m_converged = true;
+        }
+        if (m_converged && e_energy * kDoubleTalkErle > d_energy) {
+            m_double_talk = m_hangover;
+        } else {
+            m_double_talk -= std::min(m_double_talk, n);
+        }
+        m_double_talk_run = m_double_talk > 0 ? m_double_talk_run + n : 0;
+
+        // A hold that never ends is an echo path change, not a conversation
+        const size_t release = static_cast<size_t>(m_options.sample_rate) * kDoubleTalkReleaseMs / 1000;
+        const bool adapt = m_double_talk == 0 || m_double_talk_run > release;
+
+        if (!adapt) {
+            pcm::mix(samples, m_y.data(), n, -1.0f);
+        } else {
+            // Regularized NLMS: far end at -40 dBFS is quiet enough to stop learning
+            const float regularization = static_cast<float>(m_taps) * 1e-4f;
+            float norm = 0.0f;
+            for (size_t j = 0; j < m_taps; ++j) {
+                norm += m_x[j] * m_x[j];
+            }
+
+            e_energy = 0.0f;
+            y_energy = 0.0f;
+            for (size_t i = 0; i < n; ++i) {
+                const float * x = m_x.data() + i;
+
+                float y = 0.0f;
+                for (size_t j = 0; j < m_taps; ++j) {
+                    y += m_weights[j] * x[j];
+                }
+                const float e = samples[i] - y;
+
+                const float k = m_options.step_size * e / (norm + regularization);
+                for (size_t j = 0; j < m_taps; ++j) {
+                    m_weights[j] += k * x[j];
+                }
+
+                samples[i] = e;
+                e_energy += e * e;
+                y_energy += y * y;
+
+                if (i + 1 < n) {
+                    norm = std::max(0.0f, norm + x[m_taps] * x[m_taps] - x[0] * x[0]);
+                }
+            }
+        }
+
+        // Residual echo is the echo estimate scaled down by what the filter
+        // achieves on echo alone; near-end speech well above it passes
+        if (m_double_talk == 0 && d_energy > 0.0f) {
+            const float erle = std::max(1.0f, d_energy / (e_energy + 1e-12f));
+            m_erle = 0.9f * m_erle + 0.1f * erle;
+        }
+        if (m_options.suppression > 0.0f) {
+            const float residual = m_options.suppression * y_energy / m_erle;
+            target_gain = e_energy / (e_energy + residual + 1e-12f);
+            target_gain = std::clamp(target_gain, m_options.gain_floor, 1.0f);
+        }
+    }
+
+    // Ramp across the block so gain changes do not click
+    if (target_gain != 1.0f || m_gain != 1.0f) {
+        pcm::ramp(samples, n, m_gain, target_gain);
+        m_gain = target_gain;
+    }
+
+    std::copy(m_x.end() - static_cast<std::ptrdiff_t>(history), m_x.end(), m_x.begin());
+    m_x.resize(history);
+
+    const double elapsed_us = std::chrono::duration<double, std::micro>(Clock::now() - start_time).count();
+    ++m_stats.blocks;
+    m_stats.total_us += elapsed_us;
+    m_stats.max_us = std::max(m_stats.max_us, elapsed_us);
+    if (active) {
+        ++m_stats.active_blocks;
+        m_stats.active_us += elapsed_us;
+    }
+}
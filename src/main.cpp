@@ -92,6 +92,11 @@ int run_cli_mode(std::atomic<bool>& keep_running) {
         // Set interrupt flag for queue operations
         pipeline->set_interrupt_flag(&keep_running);
         
+        // Show what is being heard before the utterance ends
+        pipeline->set_partial_transcript_handler([](const std::string& text) {
+            std::cout << "[Hearing] " << text << std::endl;
+        });
+        
         // Start the pipeline
         if (!pipeline->start()) {
             std::cerr << "Failed to start pipeline\n";
@@ -0,0 +1,238 @@
+#include "pcm_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_SIMD 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define PCM_SIMD 1
+#else
+#define PCM_SIMD 0
+#endif
+
+namespace {
+
+constexpr float kInt16Min = -32768.0f;
+constexpr float kInt16Max = 32767.0f;
+
+inline int16_t to_int16(float v) {
+    // lrint rounds to nearest even, like the SIMD conversions
+    return static_cast<int16_t>(std::lrint(std::clamp(v, kInt16Min, kInt16Max)));
+}
+
+#if PCM_SIMD
+// Four float lanes, plus loading and storing eight int16 samples as two of them
+
+#if defined(__SSE2__)
+using f32x4 = __m128;
+
+inline f32x4 load(const float * p) { return _mm_loadu_ps(p); }
+inline void store(float * p, f32x4 v) { _mm_storeu_ps(p, v); }
+inline f32x4 splat(float v) { return _mm_set1_ps(v); }
+inline f32x4 add(f32x4 a, f32x4 b) { return _mm_add_ps(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return _mm_mul_ps(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return _mm_min_ps(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return _mm_max_ps(a, b); }
+inline f32x4 lane_numbers() { return _mm_setr_ps(1.0f, 2.0f, 3.0f, 4.0f); }
+
+inline void load_s16(const int16_t * p, f32x4 & lo, f32x4 & hi) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+    // Interleave with itself and shift back down to sign-extend
+    lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+    hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+}
+
+inline void store_s16(int16_t * p, f32x4 lo, f32x4 hi) {
+    // Clamp first: out-of-range conversions yield INT32_MIN, not saturation
+    const f32x4 lower = splat(kInt16Min);
+    const f32x4 upper = splat(kInt16Max);
+    const __m128i a = _mm_cvtps_epi32(min(max(lo, lower), upper));
+    const __m128i b = _mm_cvtps_epi32(min(max(hi, lower), upper));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(p), _mm_packs_epi32(a, b));
+}
+#else
+using f32x4 = float32x4_t;
+
+inline f32x4 load(const float * p) { return vld1q_f32(p); }
+inline void store(float * p, f32x4 v) { vst1q_f32(p, v); }
+inline f32x4 splat(float v) { return vdupq_n_f32(v); }
+inline f32x4 add(f32x4 a, f32x4 b) { return vaddq_f32(a, b); }
+inline f32x4 mul(f32x4 a, f32x4 b) { return vmulq_f32(a, b); }
+inline f32x4 min(f32x4 a, f32x4 b) { return vminq_f32(a, b); }
+inline f32x4 max(f32x4 a, f32x4 b) { return vmaxq_f32(a, b); }
+inline f32x4 lane_numbers() {
+    static const float lanes[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+    return vld1q_f32(lanes);
+}
+
+inline void load_s16(const int16_t * p, f32x4 & lo, f32x4 & hi) {
+    const int16x8_t x = vld1q_s16(p);
+    lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(x)));
+    hi = vcvtq_f32_s32(vmovl_high_s16(x));
+}
+
+inline void store_s16(int16_t * p, f32x4 lo, f32x4 hi) {
+    // Round to nearest even, then narrow with saturation
+    vst1q_s16(p, vcombine_s16(vqmovn_s32(vcvtnq_s32_f32(lo)), vqmovn_s32(vcvtnq_s32_f32(hi))));
+}
+#endif
+
+#endif // PCM_SIMD
+
+} // namespace
+
+namespace pcm {
+
+namespace scalar {
+
+void gain(float * data, size_t n, float g) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= g;
+    }
+}
+
+void gain(int16_t * data, size_t n, float g) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = to_int16(static_cast<float>(data[i]) * g);
+    }
+}
+
+void ramp(float * data, size_t n, float from, float to) {
+    const float step = n ? (to - from) / static_cast<float>(n) : 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        data[i] *= from + step * static_cast<float>(i + 1);
+    }
+}
+
+void ramp(int16_t * data, size_t n, float from, float to) {
+    const float step = n ? (to - from) / static_cast<float>(n) : 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = to_int16(static_cast<float>(data[i]) * (from + step * static_cast<float>(i + 1)));
+    }
+}
+
+void clamp(float * data, size_t n, float lo, float hi) {
+    for (size_t i = 0; i < n; ++i) {
+        data[i] = std::min(std::max(data[i], lo), hi);
+    }
+}
+
+void float_to_int16(const float * in, int16_t * out, size_t n, float scale) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = to_int16(in[i] * scale);
+    }
+}
+
+void int16_to_float(const int16_t * in, float * out, size_t n, float scale) {
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+void mix(float * dst, const float * src, size_t n, float g) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] += src[i] * g;
+    }
+}
+
+void mix(int16_t * dst, const int16_t * src, size_t n, float g) {
+    for (size_t i = 0; i < n; ++i) {
+        dst[i] = to_int16(static_cast<float>(dst[i]) + static_cast<float>(src[i]) * g);
+    }
+}
+
+} // namespace scalar
+
+// Plain float loops with no int16 conversion (gain, clamp, mix and the
+// int16 -> float widening) are left to the compiler: at -O3 its vectorized
+// loops matched or beat hand-written SSE2 in bench_pcm_kernels.
+void gain(float * data, size_t n, float g) { scalar::gain(data, n, g); }
+void clamp(float * data, size_t n, float lo, float hi) { scalar::clamp(data, n, lo, hi); }
+void int16_to_float(const int16_t * in, float * out, size_t n, float scale) { scalar::int16_to_float(in, out, n, scale); }
+void mix(float * dst, const float * src, size_t n, float g) { scalar::mix(dst, src, n, g); }
+
+#if PCM_SIMD
+
+void gain(int16_t * data, size_t n, float g) {
+    const f32x4 vg = splat(g);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        f32x4 lo, hi;
+        load_s16(data + i, lo, hi);
+        store_s16(data + i, mul(lo, vg), mul(hi, vg));
+    }
+    scalar::gain(data + i, n - i, g);
+}
+
+void ramp(float * data, size_t n, float from, float to) {
+    const float step = n ? (to - from) / static_cast<float>(n) : 0.0f;
+    const f32x4 vstep = splat(step);
+    const f32x4 vfrom = splat(from);
+    f32x4 index = lane_numbers();
+    const f32x4 four = splat(4.0f);
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        store(data + i, mul(load(data + i), add(vfrom, mul(vstep, index))));
+        index = add(index, four);
+    }
+    for (; i < n; ++i) {
+        data[i] *= from + step * static_cast<float>(i + 1);
+    }
+}
+
+void ramp(int16_t * data, size_t n, float from, float to) {
+    const float step = n ? (to - from) / static_cast<float>(n) : 0.0f;
+    const f32x4 vstep = splat(step);
+    const f32x4 vfrom = splat(from);
+    f32x4 index = lane_numbers();
+    const f32x4 four = splat(4.0f);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        f32x4 lo, hi;
+        load_s16(data + i, lo, hi);
+        const f32x4 g_lo = add(vfrom, mul(vstep, index));
+        index = add(index, four);
+        const f32x4 g_hi = add(vfrom, mul(vstep, index));
+        index = add(index, four);
+        store_s16(data + i, mul(lo, g_lo), mul(hi, g_hi));
+    }
+    for (; i < n; ++i) {
+        data[i] = to_int16(static_cast<float>(data[i]) * (from + step * static_cast<float>(i + 1)));
+    }
+}
+
+void float_to_int16(const float * in, int16_t * out, size_t n, float scale) {
+    const f32x4 vscale = splat(scale);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        store_s16(out + i, mul(load(in + i), vscale), mul(load(in + i + 4), vscale));
+    }
+    scalar::float_to_int16(in + i, out + i, n - i, scale);
+}
+
+void mix(int16_t * dst, const int16_t * src, size_t n, float g) {
+    const f32x4 vg = splat(g);
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        f32x4 d_lo, d_hi, s_lo, s_hi;
+        load_s16(dst + i, d_lo, d_hi);
+        load_s16(src + i, s_lo, s_hi);
+        store_s16(dst + i, add(d_lo, mul(s_lo, vg)), add(d_hi, mul(s_hi, vg)));
+    }
+    scalar::mix(dst + i, src + i, n - i, g);
+}
+
+#else
+
+void gain(int16_t * data, size_t n, float g) { scalar::gain(data, n, g); }
+void ramp(float * data, size_t n, float from, float to) { scalar::ramp(data, n, from, to); }
+void ramp(int16_t * data, size_t n, float from, float to) { scalar::ramp(data, n, from, to); }
+void float_to_int16(const float * in, int16_t * out, size_t n, float scale) { scalar::float_to_int16(in, out, n, scale); }
+void mix(int16_t * dst, const int16_t * src, size_t n, float g) { scalar::mix(dst, src, n, g); }
+
+#endif // PCM_SIMD
+
+} // namespace pcm
@@ -0,0 +1,60 @@
+#include "phoneme_cache.h"
+
+namespace {
+
+// Key and IDs plus the list node and index entry around them
+size_t node_bytes(const std::string & key, const std::vector<int64_t> & ids) {
+    return 2 * key.size() + ids.size() * sizeof(int64_t) + 64;
+}
+
+} // namespace
+
+PhonemeCache::PhonemeCache(size_t memory_bytes) : m_memory_bytes(memory_bytes) {}
+
+bool PhonemeCache::lookup(const std::string & key, std::vector<int64_t> & ids) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it == m_index.end()) {
+        ++m_misses;
+        return false;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    ids = it->second->ids;
+    ++m_hits;
+    return true;
+}
+
+void PhonemeCache::insert(const std::string & key, const std::vector<int64_t> & ids) {
+    const size_t bytes = node_bytes(key, ids);
+    if (key.empty() || bytes > m_memory_bytes) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+        m_memory_used -= it->second->bytes;
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    while (!m_lru.empty() && m_memory_used + bytes > m_memory_bytes) {
+        m_memory_used -= m_lru.back().bytes;
+        m_index.erase(m_lru.back().key);
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(Node{key, ids, bytes});
+    m_index[key] = m_lru.begin();
+    m_memory_used += bytes;
+}
+
+PhonemeCache::Stats PhonemeCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s;
+    s.hits        = m_hits;
+    s.misses      = m_misses;
+    s.entries     = m_lru.size();
+    s.memory_used = m_memory_used;
+    return s;
+}
@@ -0,0 +1,76 @@
+#include "playback_clock.h"
+
+#include <algorithm>
+#include <cmath>
+
+void PlaybackClock::reset(unsigned int sample_rate, uint64_t written) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sample_rate = sample_rate;
+    m_lost = written;
+    m_segments.clear();
+}
+
+void PlaybackClock::add_chunk(uint64_t chunk_id, uint64_t turn_id, uint64_t written, uint64_t frames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t start = written - std::min(written, m_lost);
+    m_segments.push_back({chunk_id, turn_id, start, frames});
+    while (m_segments.size() > kMaxSegments) {
+        m_segments.pop_front();
+    }
+}
+
+PlaybackPosition PlaybackClock::locate(uint64_t played) const {
+    PlaybackPosition pos;
+    pos.frames_played = played;
+    pos.sample_rate = m_sample_rate;
+    pos.time = std::chrono::steady_clock::now();
+
+    // Latest segment that started at or before the play head
+    auto it = std::upper_bound(m_segments.begin(), m_segments.end(), played,
+                               [](uint64_t p, const Segment & s) { return p < s.start; });
+    if (it == m_segments.begin()) {
+        return pos;
+    }
+    --it;
+    if (played < it->start + it->frames) {
+        pos.playing = true;
+        pos.chunk_id = it->chunk_id;
+        pos.turn_id = it->turn_id;
+        pos.chunk_frames_played = played - it->start;
+        pos.chunk_frames = it->frames;
+    }
+    return pos;
+}
+
+uint64_t PlaybackClock::played_frames(uint64_t written, double delay_ms) const {
+    const uint64_t end = written - std::min(written, m_lost);
+    const uint64_t queued = static_cast<uint64_t>(std::llround(std::max(0.0, delay_ms) * m_sample_rate / 1000.0));
+    return end - std::min(end, queued);
+}
+
+PlaybackPosition PlaybackClock::position(uint64_t written, double delay_ms) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return locate(played_frames(written, delay_ms));
+}
+
+PlaybackPosition PlaybackClock::drop(uint64_t written, double delay_ms, uint64_t dropped_at) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const uint64_t played = played_frames(written, delay_ms);
+    m_last_drop = locate(played);
+
+    // Everything not yet heard is gone; later chunks start at the play head
+    m_lost = dropped_at - std::min(dropped_at, played);
+    while (!m_segments.empty() && m_segments.back().start >= played) {
+        m_segments.pop_back();
+    }
+    if (!m_segments.empty()) {
+        Segment & last = m_segments.back();
+        last.frames = std::min(last.frames, played - last.start);
+    }
+    return m_last_drop;
+}
+
+PlaybackPosition PlaybackClock::last_drop() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_last_drop;
+}
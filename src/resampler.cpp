@@ -0,0 +1,244 @@
+#define _USE_MATH_DEFINES // for M_PI
+
+#include "resampler.h"
+#include "pcm_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+
+#if defined(__AVX__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Phase filters are padded to a multiple of this so the SIMD loops need no tail
+constexpr size_t k_simd_width = 8;
+
+// Upper bound on the filter bank size (floats) for unusual rate pairs
+constexpr size_t k_max_bank_size = 1 << 20;
+
+// Kaiser window shape; ~80 dB stopband attenuation
+constexpr double k_kaiser_beta = 8.0;
+
+// Passband edge as a fraction of the lower Nyquist frequency
+constexpr double k_rolloff = 0.94;
+
+// Zeroth-order modified Bessel function of the first kind (power series)
+double bessel_i0(double x) {
+    double sum  = 1.0;
+    double term = 1.0;
+    const double q = x * x / 4.0;
+    for (int k = 1; k < 64; ++k) {
+        term *= q / (static_cast<double>(k) * k);
+        sum  += term;
+        if (term < sum * 1e-12) {
+            break;
+        }
+    }
+    return sum;
+}
+
+// n must be a multiple of k_simd_width
+inline float dot_product(const float * a, const float * b, size_t n) {
+#if defined(__AVX__)
+    __m256 acc = _mm256_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+#if defined(__FMA__)
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i), acc);
+#else
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+#endif
+    }
+    __m128 lo = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+    lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+    lo = _mm_add_ss(lo, _mm_shuffle_ps(lo, lo, 0x55));
+    return _mm_cvtss_f32(lo);
+#elif defined(__SSE2__)
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i),     _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    __m128 acc = _mm_add_ps(acc0, acc1);
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 0x55));
+    return _mm_cvtss_f32(acc);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = vfmaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vfmaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    return vaddvq_f32(vaddq_f32(acc0, acc1));
+#elif defined(__ARM_NEON)
+    float32x4_t acc0 = vdupq_n_f32(0.0f);
+    float32x4_t acc1 = vdupq_n_f32(0.0f);
+    for (size_t i = 0; i < n; i += 8) {
+        acc0 = vmlaq_f32(acc0, vld1q_f32(a + i),     vld1q_f32(b + i));
+        acc1 = vmlaq_f32(acc1, vld1q_f32(a + i + 4), vld1q_f32(b + i + 4));
+    }
+    float32x4_t acc = vaddq_f32(acc0, acc1);
+    float32x2_t s = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(s, s), 0);
+#else
+    float acc[k_simd_width] = {0};
+    for (size_t i = 0; i < n; i += k_simd_width) {
+        for (size_t j = 0; j < k_simd_width; ++j) {
+            acc[j] += a[i + j] * b[i + j];
+        }
+    }
+    float sum = 0.0f;
+    for (size_t j = 0; j < k_simd_width; ++j) {
+        sum += acc[j];
+    }
+    return sum;
+#endif
+}
+
+} // namespace
+
+bool PolyphaseResampler::init(int in_rate, int out_rate, int taps_per_phase) {
+    m_up = 0;
+    m_down = 0;
+    m_bank.clear();
+
+    if (in_rate <= 0 || out_rate <= 0 || taps_per_phase <= 0) {
+        fprintf(stderr, "%s: invalid rates %d -> %d\n", __func__, in_rate, out_rate);
+        return false;
+    }
+
+    m_in_rate  = in_rate;
+    m_out_rate = out_rate;
+
+    const int g = std::gcd(in_rate, out_rate);
+    const int up   = out_rate / g;
+    const int down = in_rate / g;
+
+    if (up == 1 && down == 1) {
+        m_up = 1;
+        m_down = 1;
+        m_taps = 0;
+        reset();
+        return true;
+    }
+
+    // Keep the transition band constant relative to the output when decimating
+    const size_t taps = static_cast<size_t>(taps_per_phase) *
+                        static_cast<size_t>(std::max(1, (down + up - 1) / up));
+    const size_t taps_padded = (taps + k_simd_width - 1) / k_simd_width * k_simd_width;
+
+    if (static_cast<size_t>(up) * taps_padded > k_max_bank_size) {
+        fprintf(stderr, "%s: rate ratio %d/%d is too large for a polyphase bank\n", __func__, up, down);
+        return false;
+    }
+
+    // Kaiser-windowed sinc prototype at the upsampled rate (up * in_rate)
+    const size_t n_proto = static_cast<size_t>(up) * taps;
+    const double center  = 0.5 * static_cast<double>(n_proto - 1);
+    const double fc      = 0.5 * k_rolloff / static_cast<double>(std::max(up, down));
+    const double i0_beta = bessel_i0(k_kaiser_beta);
+
+    std::vector<double> proto(n_proto);
+    for (size_t i = 0; i < n_proto; ++i) {
+        const double t = static_cast<double>(i) - center;
+        const double x = 2.0 * fc * t;
+        const double sinc = (std::fabs(x) < 1e-12) ? 1.0 : std::sin(M_PI * x) / (M_PI * x);
+        const double r = (n_proto > 1) ? t / center : 0.0;
+        const double w = bessel_i0(k_kaiser_beta * std::sqrt(std::max(0.0, 1.0 - r * r))) / i0_beta;
+        proto[i] = 2.0 * fc * sinc * w;
+    }
+
+    // Split into phases, reversed so each output is a forward dot product over
+    // the newest taps input samples. Each phase is normalized to unity DC gain,
+    // which removes the phase-dependent ripple of the truncated prototype.
+    m_up   = up;
+    m_down = down;
+    m_taps = taps_padded;
+    m_bank.assign(static_cast<size_t>(up) * taps_padded, 0.0f);
+    for (int p = 0; p < up; ++p) {
+        double sum = 0.0;
+        for (size_t j = 0; j < taps; ++j) {
+            sum += proto[p + j * up];
+        }
+        const double norm = (std::fabs(sum) > 1e-12) ? 1.0 / sum : 1.0;
+
+        float * phase = &m_bank[static_cast<size_t>(p) * taps_padded];
+        for (size_t j = 0; j < taps; ++j) {
+            phase[taps_padded - 1 - j] = static_cast<float>(proto[p + j * up] * norm);
+        }
+    }
+
+    reset();
+    return true;
+}
+
+void PolyphaseResampler::reset() {
+    m_phase = 0;
+    if (m_taps == 0) {
+        m_buf.clear();
+        m_pos = 0;
+        return;
+    }
+    m_buf.assign(m_taps - 1, 0.0f);
+    m_pos = m_taps - 1;
+}
+
+void PolyphaseResampler::process(const float * in, size_t n, std::vector<float> & out) {
+    if (!in || n == 0 || !is_initialized()) {
+        return;
+    }
+
+    if (is_passthrough()) {
+        out.insert(out.end(), in, in + n);
+        return;
+    }
+
+    m_buf.insert(m_buf.end(), in, in + n);
+    out.reserve(out.size() + (n * m_up) / m_down + 2);
+
+    const size_t history = m_taps - 1;
+    const size_t size    = m_buf.size();
+    const float * buf    = m_buf.data();
+    const float * bank   = m_bank.data();
+
+    while (m_pos < size) {
+        out.push_back(dot_product(buf + (m_pos - history), bank + static_cast<size_t>(m_phase) * m_taps, m_taps));
+        m_phase += m_down;
+        m_pos   += static_cast<size_t>(m_phase / m_up);
+        m_phase %= m_up;
+    }
+
+    // Keep only the history needed by the next block
+    const size_t drop = size - history;
+    m_buf.erase(m_buf.begin(), m_buf.begin() + drop);
+    m_pos -= drop;
+}
+
+void PolyphaseResampler::process(const int16_t * in, size_t n, std::vector<int16_t> & out) {
+    if (!in || n == 0 || !is_initialized()) {
+        return;
+    }
+
+    if (is_passthrough()) {
+        out.insert(out.end(), in, in + n);
+        return;
+    }
+
+    // Filtered in int16 scale, so converted without normalizing
+    m_scratch_in.resize(n);
+    pcm::int16_to_float(in, m_scratch_in.data(), n, 1.0f);
+
+    m_scratch_out.clear();
+    process(m_scratch_in.data(), n, m_scratch_out);
+
+    const size_t base = out.size();
+    out.resize(base + m_scratch_out.size());
+    pcm::float_to_int16(m_scratch_out.data(), out.data() + base, m_scratch_out.size(), 1.0f);
+}
@@ -3,13 +3,20 @@
 #include "config_manager.h"
 
 #include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <iostream>
 #include <thread>
 
+#include <nlohmann/json.hpp>
+
+using sherpa_onnx::cxx::OfflineRecognizer;
+using sherpa_onnx::cxx::OfflineRecognizerConfig;
+using sherpa_onnx::cxx::OfflineStream;
 using sherpa_onnx::cxx::OnlineRecognizer;
+using sherpa_onnx::cxx::OnlineRecognizerResult;
 using sherpa_onnx::cxx::OnlineRecognizerConfig;
 using sherpa_onnx::cxx::OnlineStream;
-using sherpa_onnx::cxx::LinearResampler;
 using sherpa_onnx::cxx::VadModelConfig;
 using sherpa_onnx::cxx::VoiceActivityDetector;
 
@@ -28,10 +35,15 @@ int SherpaSTT::PortAudioCallback(const void *input_buffer,
 
     const float *in = static_cast<const float *>(input_buffer);
     std::vector<float> chunk(in, in + frames_per_buffer);
+    const auto captured = std::chrono::steady_clock::now();
 
     {
+        // The device stays open between streaming sessions; drop audio then
         std::lock_guard<std::mutex> lock(self->audio_mutex_);
-        self->audio_queue_.emplace(std::move(chunk));
+        if (!self->streaming_ || self->stop_streaming_) {
+            return paContinue;
+        }
+        self->audio_queue_.push({0, std::move(chunk), captured});
     }
     self->audio_cv_.notify_one();
 
@@ -41,14 +53,17 @@ int SherpaSTT::PortAudioCallback(const void *input_buffer,
 namespace {
 
 // Helper to create a sherpa VAD instance from a single model path.
+// Detection parameters come from settings.stt.vad.
 VoiceActivityDetector CreateVad(const std::string &modelPath, int32_t sample_rate) {
+    auto &settings = ConfigManager::getInstance();
+
     VadModelConfig config;
     config.silero_vad.model = modelPath;
-    config.silero_vad.threshold = 0.3f;
-    config.silero_vad.min_silence_duration = 0.25f;
-    config.silero_vad.min_speech_duration = 0.01f;
+    config.silero_vad.threshold = settings.getSttVadThreshold();
+    config.silero_vad.min_silence_duration = settings.getSttVadMinSilenceDuration();
+    config.silero_vad.min_speech_duration = settings.getSttVadMinSpeechDuration();
     config.silero_vad.window_size = 512;
-    config.silero_vad.max_speech_duration = 8.0f;
+    config.silero_vad.max_speech_duration = settings.getSttVadMaxSpeechDuration();
 
     config.sample_rate = sample_rate;
     config.num_threads = 1;
@@ -87,6 +102,14 @@ OnlineRecognizer CreateOnlineRecognizer(
 
     config.decoding_method = "greedy_search";
 
+    // Endpoint rules let the streaming pass commit long utterances before
+    // the VAD closes the segment.
+    auto &settings = ConfigManager::getInstance();
+    config.enable_endpoint = settings.getSttEndpointEnabled();
+    config.rule1_min_trailing_silence = settings.getSttEndpointRule1MinTrailingSilence();
+    config.rule2_min_trailing_silence = settings.getSttEndpointRule2MinTrailingSilence();
+    config.rule3_min_utterance_length = settings.getSttEndpointRule3MinUtteranceLength();
+
     std::cout << "[SherpaSTT] Loading sherpa-onnx model..." << std::endl;
     OnlineRecognizer recognizer = OnlineRecognizer::Create(config);
     if (!recognizer.Get()) {
@@ -98,6 +121,91 @@ OnlineRecognizer CreateOnlineRecognizer(
     return recognizer;
 }
 
+// Helper to create the optional offline recognizer used for the second pass.
+// A Whisper export is used when encoder/decoder are configured, otherwise a
+// single-file Paraformer model.
+OfflineRecognizer CreateOfflineRecognizer(
+    const std::string &whisperEncoderPath,
+    const std::string &whisperDecoderPath,
+    const std::string &paraformerPath,
+    const std::string &tokensPath,
+    int32_t numThreads,
+    int32_t sampleRate) {
+    OfflineRecognizerConfig config;
+
+    if (!whisperEncoderPath.empty() && !whisperDecoderPath.empty()) {
+        config.model_config.whisper.encoder = whisperEncoderPath;
+        config.model_config.whisper.decoder = whisperDecoderPath;
+        config.model_config.whisper.language = "en";
+        config.model_config.whisper.task = "transcribe";
+    } else {
+        config.model_config.paraformer.model = paraformerPath;
+    }
+    config.model_config.tokens = tokensPath;
+
+    config.model_config.num_threads = numThreads;
+    config.model_config.provider = "cpu";
+    config.model_config.debug = false;
+
+    config.feat_config.sample_rate = sampleRate;
+    config.feat_config.feature_dim = 80;
+
+    config.decoding_method = "greedy_search";
+
+    std::cout << "[SherpaSTT] Loading sherpa-onnx offline (second pass) model..." << std::endl;
+    OfflineRecognizer recognizer = OfflineRecognizer::Create(config);
+    if (!recognizer.Get()) {
+        std::cerr << "[SherpaSTT] Failed to create OfflineRecognizer" << std::endl;
+    } else {
+        std::cout << "[SherpaSTT] Offline model loaded." << std::endl;
+    }
+
+    return recognizer;
+}
+
+// Number of samples the streaming model needs before it can decode its first
+// chunk (chunk size plus right context plus the feature window). Determined by
+// feeding silence in 10 ms steps into a probe stream until it becomes ready.
+// Returns 0 if the model did not become ready within 4 seconds.
+int32_t ProbeChunkSamples(const OnlineRecognizer &recognizer, int32_t sampleRate) {
+    OnlineStream probe = recognizer.CreateStream();
+    const int32_t step = sampleRate / 100;
+    std::vector<float> silence(step, 0.0f);
+    for (int32_t fed = step; fed <= 4 * sampleRate; fed += step) {
+        probe.AcceptWaveform(sampleRate, silence.data(), step);
+        if (recognizer.IsReady(&probe)) {
+            return fed;
+        }
+    }
+    return 0;
+}
+
+// Confidence of a streaming result: geometric mean of the per-token
+// probabilities reported by the decoder (ys_probs are log-probabilities).
+// Returns 0 when the recognizer does not report token probabilities, so the
+// second pass is never skipped on missing information.
+float ResultConfidence(const OnlineRecognizerResult &result) {
+    if (result.text.empty() || result.json.empty()) {
+        return 0.0f;
+    }
+
+    try {
+        auto parsed = nlohmann::json::parse(result.json);
+        auto it = parsed.find("ys_probs");
+        if (it == parsed.end() || !it->is_array() || it->empty()) {
+            return 0.0f;
+        }
+
+        double sum = 0.0;
+        for (const auto &p : *it) {
+            sum += p.get<double>();
+        }
+        return static_cast<float>(std::exp(sum / static_cast<double>(it->size())));
+    } catch (const std::exception &) {
+        return 0.0f;
+    }
+}
+
 } // namespace
 
 bool SherpaSTT::init() {
@@ -148,12 +256,62 @@ bool SherpaSTT::init() {
 
     recognizer_ = std::make_unique<OnlineRecognizer>(std::move(recognizer));
 
-    auto vad = CreateVad(vadPath, model_sample_rate_);
-    if (!vad.Get()) {
-        return false;
+    // Tail padding only needs to push the last partial chunk through the
+    // encoder, so size it from the model unless configured explicitly.
+    const int tailPaddingMs = config.getSttTailPaddingMs();
+    if (tailPaddingMs > 0) {
+        tail_padding_samples_ = model_sample_rate_ * tailPaddingMs / 1000;
+    } else {
+        const int32_t chunkSamples = ProbeChunkSamples(*recognizer_, model_sample_rate_);
+        tail_padding_samples_ = chunkSamples > 0
+            ? chunkSamples
+            : static_cast<int32_t>(kFallbackTailPaddingSeconds * model_sample_rate_);
+    }
+    std::cout << "[SherpaSTT] Tail padding: " << tail_padding_samples_ << " samples ("
+              << 1000 * tail_padding_samples_ / model_sample_rate_ << " ms)" << std::endl;
+
+    // One VAD per source slot; slot 0 is the microphone. All slots are
+    // created up front so add_source() never loads models on the caller's thread.
+    vad_model_path_ = vadPath;
+    max_streams_ = std::max(1, config.getSttMaxStreams());
+    sources_.clear();
+    sources_.resize(max_streams_);
+    for (auto &src : sources_) {
+        auto vad = CreateVad(vad_model_path_, model_sample_rate_);
+        if (!vad.Get()) {
+            return false;
+        }
+        src.vad = std::make_unique<VoiceActivityDetector>(std::move(vad));
+    }
+    sources_[0].active = true;
+#ifdef ENABLE_STATS_LOGGING
+    batch_stats_.assign(max_streams_ + 1, BatchStats{});
+#endif
+
+    // Optional offline second pass. Configured through the "offline_tokens"
+    // component plus either "offline_whisper_encoder"/"offline_whisper_decoder"
+    // or "offline_paraformer".
+    const bool hasWhisper =
+        config.hasNestedModelPath("stt", "sherpa", "offline_whisper_encoder") &&
+        config.hasNestedModelPath("stt", "sherpa", "offline_whisper_decoder");
+    const bool hasParaformer =
+        config.hasNestedModelPath("stt", "sherpa", "offline_paraformer");
+    if ((hasWhisper || hasParaformer) &&
+        config.hasNestedModelPath("stt", "sherpa", "offline_tokens")) {
+        auto offline = CreateOfflineRecognizer(
+            hasWhisper ? config.getNestedModelPath("stt", "sherpa", "offline_whisper_encoder") : "",
+            hasWhisper ? config.getNestedModelPath("stt", "sherpa", "offline_whisper_decoder") : "",
+            hasWhisper ? "" : config.getNestedModelPath("stt", "sherpa", "offline_paraformer"),
+            config.getNestedModelPath("stt", "sherpa", "offline_tokens"),
+            numThreads, model_sample_rate_);
+        if (!offline.Get()) {
+            return false;
+        }
+        offline_recognizer_ = std::make_unique<OfflineRecognizer>(std::move(offline));
+        commit_confidence_ = config.getSttCommitConfidence();
+        std::cout << "[SherpaSTT] Two-pass recognition enabled (commit confidence "
+                  << commit_confidence_ << ")" << std::endl;
     }
-
-    vad_ = std::make_unique<VoiceActivityDetector>(std::move(vad));
 
     // Initialize PortAudio microphone helper; actual device is opened in
     // start_streaming() so that we don't capture audio until needed.
@@ -161,17 +319,14 @@ bool SherpaSTT::init() {
 
     // Configure optional resampler if microphone rate differs from model rate.
     if (mic_sample_rate_ != model_sample_rate_) {
-        float min_freq =
-            std::min(static_cast<float>(mic_sample_rate_),
-                     static_cast<float>(model_sample_rate_));
-        float lowpass_cutoff = 0.99f * 0.5f * min_freq;
-
-        int32_t lowpass_filter_width = 6;
-        resampler_ = LinearResampler::Create(
-            mic_sample_rate_, model_sample_rate_,
-            lowpass_cutoff, lowpass_filter_width);
+        if (!resampler_.init(mic_sample_rate_, model_sample_rate_)) {
+            std::cerr << "[SherpaSTT] Failed to create resampler from "
+                      << mic_sample_rate_ << " Hz to " << model_sample_rate_
+                      << " Hz" << std::endl;
+            return false;
+        }
 
-        std::cout << "[SherpaSTT] Using LinearResampler from "
+        std::cout << "[SherpaSTT] Using polyphase resampler from "
                   << mic_sample_rate_ << " Hz to "
                   << model_sample_rate_ << " Hz" << std::endl;
     } else {
@@ -182,6 +337,10 @@ bool SherpaSTT::init() {
 
     window_size_ = 512;
 
+    barge_in_min_samples_ = std::max(0, config.getSttBargeInMinSpeechMs()) * model_sample_rate_ / 1000;
+    vad_onset_delay_samples_ = static_cast<int32_t>(
+        std::max(0.0f, config.getSttVadMinSpeechDuration()) * model_sample_rate_);
+
     std::cout << "[SherpaSTT] Initialized successfully" << std::endl;
     return true;
 }
@@ -192,7 +351,7 @@ bool SherpaSTT::start_streaming(TranscriptionCallback callback) {
         return false;
     }
 
-    if (!recognizer_ || !vad_ || !mic_) {
+    if (!recognizer_ || sources_.empty() || !mic_) {
         std::cerr << "[SherpaSTT] Cannot start streaming: not initialized" << std::endl;
         return false;
     }
@@ -206,22 +365,44 @@ bool SherpaSTT::start_streaming(TranscriptionCallback callback) {
 
     // Open default microphone device with PortAudio. Device selection can be
     // customized later via environment variables (similar to sherpa-onnx).
-    int32_t device_index = mic_->GetDefaultInputDevice();
-    if (device_index < 0) {
-        std::cerr << "[SherpaSTT] No default input device found (PortAudio)" << std::endl;
-        return false;
-    }
+    if (microphone_enabled_) {
+        int32_t device_index = mic_->GetDefaultInputDevice();
+        if (device_index < 0) {
+            std::cerr << "[SherpaSTT] No default input device found (PortAudio)" << std::endl;
+            return false;
+        }
 
-    mic_->PrintDevices(device_index);
+        mic_->PrintDevices(device_index);
 
-    if (!mic_->OpenDevice(device_index, mic_sample_rate_, 1, PortAudioCallback, this)) {
-        std::cerr << "[SherpaSTT] Failed to open PortAudio microphone device index "
-                  << device_index << std::endl;
-        return false;
+        if (!mic_->OpenDevice(device_index, mic_sample_rate_, 1, PortAudioCallback, this)) {
+            std::cerr << "[SherpaSTT] Failed to open PortAudio microphone device index "
+                      << device_index << std::endl;
+            return false;
+        }
+    } else {
+        std::cout << "[SherpaSTT] Microphone disabled; recognizing added sources only" << std::endl;
+    }
+    // The reference is kept at the model rate, where the canceller runs
+    if (echo_reference_ && microphone_enabled_) {
+        auto &config = ConfigManager::getInstance();
+        echo_reference_->configure(model_sample_rate_);
+
+        EchoCanceller::Options options;
+        options.sample_rate = model_sample_rate_;
+        options.tail_ms = std::max(1, config.getAudioEchoTailMs());
+        options.step_size = config.getAudioEchoStepSize();
+        options.suppression = config.getAudioEchoSuppression();
+        echo_canceller_ = std::make_unique<EchoCanceller>(echo_reference_, options);
+        std::cout << "[SherpaSTT] Echo cancellation on the microphone ("
+                  << options.tail_ms << " ms tail)" << std::endl;
     }
+
     stop_streaming_ = false;
     streaming_thread_ = std::thread(&SherpaSTT::streaming_loop, this);
-    streaming_ = true;
+    {
+        std::lock_guard<std::mutex> lock(audio_mutex_);
+        streaming_ = true;
+    }
 
     return true;
 }
@@ -236,9 +417,29 @@ void SherpaSTT::stop_streaming() {
         streaming_thread_.join();
     }
 
-    streaming_ = false;
-    stop_streaming_ = false;
+    {
+        // Audio that arrived after the loop exited is never decoded
+        std::lock_guard<std::mutex> lock(audio_mutex_);
+        streaming_ = false;
+        stop_streaming_ = false;
+        audio_queue_ = {};
+        // Slots removed after the loop stopped missed their reset marker
+        for (size_t i = 1; i < sources_.size(); ++i) {
+            if (!sources_[i].active) {
+                sources_[i].reset();
+            }
+        }
+    }
     callback_ = nullptr;
+
+    if (echo_canceller_) {
+        std::cout << "[SherpaSTT] ";
+        echo_canceller_->stats().print();
+    }
+
+#ifdef ENABLE_STATS_LOGGING
+    print_batch_stats();
+#endif
 }
 
 void SherpaSTT::shutdown() {
@@ -248,24 +449,334 @@ void SherpaSTT::shutdown() {
         mic_->CloseDevice();
         mic_.reset();
     }
-    // recognizer_ and vad_ are RAII wrappers and will clean up in their destructors.
+    // recognizer_ and the per-source VADs are RAII wrappers and will clean up
+    // in their destructors.
 }
 
-void SherpaSTT::streaming_loop() {
-    bool speech_started = false;
-    int32_t segment_id = 0;
-    int32_t offset = 0;
-    std::vector<float> buffer;
+void SherpaSTT::Source::reset() {
+    if (vad) {
+        vad->Reset();
+    }
+    buffer.clear();
+    offset = 0;
+    speech_started = false;
+    speech_samples = 0;
+    speech_reported = false;
+    endpointed = false;
+    live_stream.reset();
+    partial_text.clear();
+}
+
+int SherpaSTT::add_source() {
+    std::lock_guard<std::mutex> lock(audio_mutex_);
+    for (size_t i = 1; i < sources_.size(); ++i) {
+        if (!sources_[i].active) {
+            sources_[i].active = true;
+            std::cout << "[SherpaSTT] Registered audio source " << i << std::endl;
+            return static_cast<int>(i);
+        }
+    }
+    std::cerr << "[SherpaSTT] No free audio source slot (max_streams = "
+              << max_streams_ << ")" << std::endl;
+    return -1;
+}
+
+bool SherpaSTT::accept_audio(int source_id, const float *samples, size_t n) {
+    if (!samples || n == 0) {
+        return true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(audio_mutex_);
+        if (source_id <= 0 || source_id >= static_cast<int>(sources_.size()) ||
+            !sources_[source_id].active) {
+            return false;
+        }
+        if (!streaming_ || stop_streaming_) {
+            return false;
+        }
+        audio_queue_.push({source_id, std::vector<float>(samples, samples + n),
+                           std::chrono::steady_clock::now()});
+    }
+    audio_cv_.notify_one();
+    return true;
+}
+
+void SherpaSTT::remove_source(int source_id) {
+    {
+        std::lock_guard<std::mutex> lock(audio_mutex_);
+        if (source_id <= 0 || source_id >= static_cast<int>(sources_.size()) ||
+            !sources_[source_id].active) {
+            return;
+        }
+        sources_[source_id].active = false;
+        if (streaming_) {
+            // An empty chunk tells the streaming thread to reset the slot state,
+            // ordered after any audio already queued for it.
+            audio_queue_.push({source_id, std::vector<float>(), std::chrono::steady_clock::now()});
+        } else {
+            // No streaming thread owns the slot state
+            sources_[source_id].reset();
+        }
+    }
+    audio_cv_.notify_one();
+    std::cout << "[SherpaSTT] Removed audio source " << source_id << std::endl;
+}
+
+void SherpaSTT::emit_result(int source_id, const std::string &text) {
+    if (reports_to_streaming_callback(source_id)) {
+        if (callback_) {
+            callback_(text);
+        }
+    } else {
+        source_result_callback_(source_id, text);
+    }
+}
+
+std::string SherpaSTT::decode_second_pass(const std::vector<float>& samples) {
+    OfflineStream stream = offline_recognizer_->CreateStream();
+    stream.AcceptWaveform(model_sample_rate_, samples.data(),
+                          static_cast<int32_t>(samples.size()));
+    offline_recognizer_->Decode(&stream);
+    return offline_recognizer_->GetResult(&stream).text;
+}
+
+#ifdef ENABLE_STATS_LOGGING
+void SherpaSTT::print_batch_stats() const {
+    std::cout << "=== SherpaSTT batched decode ===" << std::endl;
+    for (size_t n = 1; n < batch_stats_.size(); ++n) {
+        const auto &st = batch_stats_[n];
+        if (st.calls == 0) {
+            continue;
+        }
+        const double avg_ms = st.total_ms / static_cast<double>(st.calls);
+        std::cout << "  N=" << n << ": " << st.calls << " calls, avg "
+                  << avg_ms << " ms/batch, " << avg_ms / static_cast<double>(n)
+                  << " ms/stream" << std::endl;
+    }
+}
+#endif
+
+void SherpaSTT::decode_ready_streams() {
+    // OnlineRecognizer::Decode(ss, n) takes a contiguous array of streams, so
+    // ready streams are moved into a batch and moved back after decoding.
+    std::vector<OnlineStream> batch;
+    std::vector<Source *> owners;
+    batch.reserve(sources_.size());
+    owners.reserve(sources_.size());
+
+    while (true) {
+        batch.clear();
+        owners.clear();
+        for (auto &src : sources_) {
+            if (src.live_stream && recognizer_->IsReady(src.live_stream.get())) {
+                batch.emplace_back(std::move(*src.live_stream));
+                owners.push_back(&src);
+            }
+        }
+        if (batch.empty()) {
+            break;
+        }
+
+#ifdef ENABLE_STATS_LOGGING
+        auto start_time = std::chrono::steady_clock::now();
+#endif
+        if (batch.size() == 1) {
+            recognizer_->Decode(&batch[0]);
+        } else {
+            recognizer_->Decode(batch.data(), static_cast<int32_t>(batch.size()));
+        }
+#ifdef ENABLE_STATS_LOGGING
+        auto elapsed = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time).count();
+        auto &st = batch_stats_[std::min(batch.size(), batch_stats_.size() - 1)];
+        ++st.calls;
+        st.total_ms += elapsed;
+#endif
+
+        for (size_t i = 0; i < batch.size(); ++i) {
+            *owners[i]->live_stream = std::move(batch[i]);
+        }
+    }
+}
+
+void SherpaSTT::process_vad(Source &src, const float *samples, size_t n,
+                            std::chrono::steady_clock::time_point captured) {
+    const int32_t pre_roll = static_cast<int32_t>(kPreRollSeconds * model_sample_rate_);
+    const int source_id = static_cast<int>(&src - sources_.data());
+
+    src.buffer.insert(src.buffer.end(), samples, samples + n);
+    src.last_captured = captured;
+
+    // Capture time of a buffer position, counting back from the newest sample
+    const auto capture_time = [&](int64_t pos) {
+        const int64_t behind = static_cast<int64_t>(src.buffer.size()) - pos;
+        return captured - std::chrono::microseconds(behind * 1000000 / model_sample_rate_);
+    };
+
+    for (; src.offset + window_size_ < static_cast<int32_t>(src.buffer.size());
+         src.offset += window_size_) {
+        src.vad->AcceptWaveform(src.buffer.data() + src.offset, window_size_);
+        if (src.vad->IsDetected() && !src.speech_started) {
+            src.speech_started = true;
+            ++src.segment_id;
+
+            // The VAD fires min_speech_duration into the speech
+            src.speech_samples = vad_onset_delay_samples_;
+            src.speech_onset = capture_time(static_cast<int64_t>(src.offset) - vad_onset_delay_samples_);
+            src.speech_reported = false;
+            std::cerr << "[SherpaSTT] VAD detected speech, source " << source_id
+                      << " segment " << src.segment_id << std::endl;
+
+            // Start the first pass with a short pre-roll, since the VAD
+            // only fires after min_speech_duration of speech.
+            src.live_stream = std::make_unique<OnlineStream>(recognizer_->CreateStream());
+            const int32_t start = std::max<int32_t>(0, src.offset - pre_roll);
+            if (src.offset > start) {
+                src.live_stream->AcceptWaveform(model_sample_rate_,
+                                                src.buffer.data() + start,
+                                                src.offset - start);
+            }
+            src.partial_text.clear();
+        } else if (!src.vad->IsDetected() && src.speech_started) {
+            src.speech_started = false;
+            src.speech_samples = 0;
+            src.speech_end = capture_time(static_cast<int64_t>(src.offset) + window_size_);
+            std::cerr << "[SherpaSTT] VAD lost speech, source " << source_id
+                      << " segment " << src.segment_id << " ended (pending flush)"
+                      << std::endl;
+        }
 
+        if (src.live_stream) {
+            src.live_stream->AcceptWaveform(model_sample_rate_,
+                                            src.buffer.data() + src.offset,
+                                            window_size_);
+        }
+
+        // Report the segment once it has lasted long enough to be a person
+        // talking rather than a click or a short burst of echo
+        if (src.speech_started && !src.speech_reported) {
+            src.speech_samples += window_size_;
+            if (src.speech_samples >= barge_in_min_samples_ && speech_start_callback_) {
+                src.speech_reported = true;
+                std::cerr << "[SherpaSTT] Sustained speech, source " << source_id
+                          << " segment " << src.segment_id << " ("
+                          << src.speech_samples * 1000 / model_sample_rate_ << " ms)"
+                          << std::endl;
+                speech_start_callback_(src.speech_onset);
+            }
+        }
+    }
+}
+
+void SherpaSTT::finish_segments(Source &src, const std::vector<float> &tail_paddings) {
+    const int source_id = static_cast<int>(&src - sources_.data());
+
+    while (!src.vad->IsEmpty()) {
+        auto segment = src.vad->Front();
+        auto speech = segment.samples;
+
+        if (speech.empty()) {
+            src.vad->Pop();
+            continue;
+        }
+
+        std::cerr << "[SherpaSTT] Processing VAD segment(" << source_id << ":"
+                  << src.segment_id << ") with " << speech.size() << " samples"
+                  << std::endl;
+
+        // The utterance is over now; finalizing and the second pass follow
+        if (utterance_end_callback_ && reports_to_streaming_callback(source_id)) {
+            utterance_end_callback_(src.speech_end != std::chrono::steady_clock::time_point{}
+                                        ? src.speech_end : src.last_captured);
+        }
+        src.speech_end = {};
+
+#ifdef ENABLE_STATS_LOGGING
+        auto finalize_start = std::chrono::steady_clock::now();
+#endif
+
+        // Finish the first pass. If no live stream was started (segment
+        // emitted without an onset edge), decode the whole segment now.
+        if (!src.live_stream) {
+            src.live_stream = std::make_unique<OnlineStream>(recognizer_->CreateStream());
+            src.live_stream->AcceptWaveform(
+                model_sample_rate_, speech.data(),
+                static_cast<int32_t>(speech.size()));
+        }
+        src.live_stream->AcceptWaveform(
+            model_sample_rate_, tail_paddings.data(),
+            static_cast<int32_t>(tail_paddings.size()));
+        src.live_stream->InputFinished();
+
+        // Other sources' ready frames ride along in the same batches
+        decode_ready_streams();
+
+        auto result = recognizer_->GetResult(src.live_stream.get());
+        src.live_stream.reset();
+        src.partial_text.clear();
+
+#ifdef ENABLE_STATS_LOGGING
+        std::cerr << "[SherpaSTT] segment(" << source_id << ":" << src.segment_id
+                  << ") finalize latency "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - finalize_start).count()
+                  << " ms (tail padding " << tail_paddings.size() << " samples)"
+                  << std::endl;
+#endif
+
+        // After an endpoint commit the segment audio overlaps text already
+        // emitted, so only the streaming remainder is used.
+        const bool endpointed = src.endpointed;
+        src.endpointed = false;
+
+        std::string text = result.text;
+        if (offline_recognizer_ && !endpointed) {
+            const float confidence = ResultConfidence(result);
+            if (!text.empty() && confidence >= commit_confidence_) {
+                std::cerr << "[SherpaSTT] segment(" << source_id << ":" << src.segment_id
+                          << ") committed from first pass (confidence "
+                          << confidence << ")" << std::endl;
+            } else {
+                std::string second = decode_second_pass(speech);
+                std::cerr << "[SherpaSTT] segment(" << source_id << ":" << src.segment_id
+                          << ") re-decoded by second pass (first-pass confidence "
+                          << confidence << "): '" << second << "'" << std::endl;
+                // An empty re-decode does not overrule words the first pass heard
+                if (!second.empty()) {
+                    text = std::move(second);
+                }
+            }
+        }
+
+        std::cerr << "[SherpaSTT] Recognizer result for segment(" << source_id << ":"
+                  << src.segment_id << "): '" << text << "'" << std::endl;
+
+        if (!text.empty()) {
+            emit_result(source_id, text);
+            std::cout << "[SherpaSTT] vad segment(" << source_id << ":"
+                      << src.segment_id << ") → " << text << std::endl;
+        }
+
+        src.vad->Pop();
+
+        src.buffer.clear();
+        src.offset = 0;
+        src.speech_started = false;
+    }
+}
+
+void SherpaSTT::streaming_loop() {
     // Tail paddings appended after each VAD speech segment before finalizing
     // the recognizer stream. This helps the model flush its internal state.
-    const float tail_padding_len = 1.28f;  // seconds; tuned to model chunk size
-    std::vector<float> tail_paddings(
-        static_cast<int32_t>(tail_padding_len * model_sample_rate_), 0.0f);
+    std::vector<float> tail_paddings(tail_padding_samples_, 0.0f);
+
+    std::vector<CapturedAudio> pending;
+    std::vector<bool> touched(sources_.size(), false);
 
     while (!stop_streaming_) {
-        // Wait for audio from the PortAudio callback
-        std::vector<float> chunk;
+        // Wait for audio, then drain everything queued so that sources with
+        // ready frames are decoded together.
+        pending.clear();
         {
             std::unique_lock<std::mutex> lock(audio_mutex_);
             audio_cv_.wait(lock, [this] {
@@ -276,91 +787,80 @@ void SherpaSTT::streaming_loop() {
                 break;
             }
 
-            if (!audio_queue_.empty()) {
-                chunk = std::move(audio_queue_.front());
+            while (!audio_queue_.empty()) {
+                pending.push_back(std::move(audio_queue_.front()));
                 audio_queue_.pop();
             }
         }
 
-        if (chunk.empty()) {
-            continue;
-        }
-
-        // Resample microphone audio to the model/VAD sample rate if needed.
-        if (!resampler_.Get()) {
-            buffer.insert(buffer.end(), chunk.begin(), chunk.end());
-        } else {
-            auto resampled =
-                resampler_.Resample(chunk.data(),
-                                    static_cast<int32_t>(chunk.size()),
-                                    /*flush=*/false);
-            buffer.insert(buffer.end(), resampled.begin(), resampled.end());
-        }
-
-        // VAD processing
-        for (; offset + window_size_ < static_cast<int32_t>(buffer.size());
-             offset += window_size_) {
-            vad_->AcceptWaveform(buffer.data() + offset, window_size_);
-            if (vad_->IsDetected() && !speech_started) {
-                speech_started = true;
-                ++segment_id;
-                std::cerr << "[SherpaSTT] VAD detected speech, segment "
-                          << segment_id << std::endl;
-            } else if (!vad_->IsDetected() && speech_started) {
-                speech_started = false;
-                std::cerr << "[SherpaSTT] VAD lost speech, segment "
-                          << segment_id << " ended (pending flush)" << std::endl;
-            }
-        }
-
-        // if (!speech_started) {
-        //     if (buffer.size() > static_cast<size_t>(10 * window_size_)) {
-        //         offset -= static_cast<int32_t>(buffer.size()) - 10 * window_size_;
-        //         buffer = {buffer.end() - 10 * window_size_, buffer.end()};
-        //     }
-        // }
-
-        while (!vad_->IsEmpty()) {
-            auto segment = vad_->Front();
-            auto speech = segment.samples;
+        std::fill(touched.begin(), touched.end(), false);
+        for (auto &item : pending) {
+            Source &src = sources_[item.source_id];
+            auto &chunk = item.samples;
 
-            if (speech.empty()) {
-                vad_->Pop();
+            if (chunk.empty()) {
+                // remove_source() marker
+                src.reset();
+                touched[item.source_id] = false;
                 continue;
             }
 
-            std::cerr << "[SherpaSTT] Processing VAD segment(" << segment_id
-                      << ") with " << speech.size() << " samples" << std::endl;
-
-            OnlineStream stream = recognizer_->CreateStream();
-            stream.AcceptWaveform(
-                model_sample_rate_, speech.data(),
-                static_cast<int32_t>(speech.size()));
-            stream.AcceptWaveform(
-                model_sample_rate_, tail_paddings.data(),
-                static_cast<int32_t>(tail_paddings.size()));
-            stream.InputFinished();
-
-            while (recognizer_->IsReady(&stream)) {
-                recognizer_->Decode(&stream);
+            // Resample microphone audio to the model/VAD sample rate if needed.
+            if (item.source_id == 0 && resampler_.is_initialized()) {
+                resampled_.clear();
+                resampler_.process(chunk.data(), chunk.size(), resampled_);
+                if (echo_canceller_) {
+                    echo_canceller_->process(resampled_.data(), resampled_.size(), item.captured);
+                }
+                process_vad(src, resampled_.data(), resampled_.size(), item.captured);
+            } else {
+                if (item.source_id == 0 && echo_canceller_) {
+                    echo_canceller_->process(chunk.data(), chunk.size(), item.captured);
+                }
+                process_vad(src, chunk.data(), chunk.size(), item.captured);
             }
+            touched[item.source_id] = true;
+        }
 
-            auto result = recognizer_->GetResult(&stream);
-            std::cerr << "[SherpaSTT] Recognizer result for segment(" << segment_id
-                      << "): '" << result.text << "'" << std::endl;
+        // First pass for every source that received audio, batched
+        decode_ready_streams();
 
-            if (!result.text.empty() && callback_) {
-                callback_(result.text);
-                std::cout << "[SherpaSTT] vad segment(" << segment_id << ") → "
-                          << result.text << std::endl;
+        for (size_t i = 0; i < sources_.size(); ++i) {
+            if (!touched[i]) {
+                continue;
             }
-
-            vad_->Pop();
-
-            buffer.clear();
-            offset = 0;
-            speech_started = false;
+            Source &src = sources_[i];
+            if (src.live_stream) {
+                auto partial = recognizer_->GetResult(src.live_stream.get());
+                if (partial.text != src.partial_text) {
+                    src.partial_text = partial.text;
+                    std::cerr << "[SherpaSTT] partial(" << i << ":" << src.segment_id
+                              << "): '" << src.partial_text << "'" << std::endl;
+                    if (!partial.text.empty() && partial_callback_ &&
+                        reports_to_streaming_callback(static_cast<int>(i))) {
+                        partial_callback_(partial.text);
+                    }
+                }
+
+                // Endpoint rule fired inside a long VAD segment: commit what
+                // we have and keep decoding the rest of the segment.
+                if (recognizer_->IsEndpoint(src.live_stream.get())) {
+                    const int source_id = static_cast<int>(i);
+                    if (!partial.text.empty() && utterance_end_callback_ &&
+                        reports_to_streaming_callback(source_id)) {
+                        utterance_end_callback_(src.last_captured);
+                    }
+                    if (!partial.text.empty()) {
+                        emit_result(source_id, partial.text);
+                        std::cout << "[SherpaSTT] endpoint(" << i << ":" << src.segment_id
+                                  << ") → " << partial.text << std::endl;
+                    }
+                    recognizer_->Reset(src.live_stream.get());
+                    src.partial_text.clear();
+                    src.endpointed = true;
+                }
+            }
+            finish_segments(src, tail_paddings);
         }
     }
 }
-
@@ -0,0 +1,908 @@
+#include "text_normalizer.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace {
+
+const char * const k_ones[] = {
+    "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+    "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen",
+    "seventeen", "eighteen", "nineteen",
+};
+
+const char * const k_tens[] = {
+    "", "", "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety",
+};
+
+const char * const k_months[] = {
+    "January", "February", "March", "April", "May", "June",
+    "July", "August", "September", "October", "November", "December",
+};
+
+struct Replacement {
+    const char * from;
+    const char * to;
+};
+
+// Matched case-sensitively at word boundaries, longest entries first
+const Replacement k_abbreviations[] = {
+    {"approx.", "approximately"},
+    {"Prof.",   "Professor"},
+    {"Mrs.",    "Missus"},
+    {"e.g.",    "for example"},
+    {"i.e.",    "that is"},
+    {"a.m.",    "A M"},
+    {"p.m.",    "P M"},
+    {"etc.",    "et cetera."},
+    {"Dr.",     "Doctor"},
+    {"Mr.",     "Mister"},
+    {"Ms.",     "Miz"},
+    {"Jr.",     "Junior"},
+    {"Sr.",     "Senior"},
+    {"vs.",     "versus"},
+    {"vs",      "versus"},
+};
+
+struct Unit {
+    const char * abbr;
+    const char * singular;
+    const char * plural;
+};
+
+// Only recognized directly after a number; longest entries first. Lowercase
+// one-letter units need a space after the number ("5 m", "10 s"), so "1990s"
+// or "3g" are not read as units.
+const Unit k_units[] = {
+    {"km/h", "kilometer per hour",   "kilometers per hour"},
+    {"\xC2\xB0" "C", "degree Celsius",    "degrees Celsius"},
+    {"\xC2\xB0" "F", "degree Fahrenheit", "degrees Fahrenheit"},
+    {"\xC2\xB0", "degree",           "degrees"},
+    {"GHz",  "gigahertz",  "gigahertz"},
+    {"MHz",  "megahertz",  "megahertz"},
+    {"kHz",  "kilohertz",  "kilohertz"},
+    {"mph",  "mile per hour", "miles per hour"},
+    {"kph",  "kilometer per hour", "kilometers per hour"},
+    {"lbs",  "pound",      "pounds"},
+    {"hrs",  "hour",       "hours"},
+    {"sec",  "second",     "seconds"},
+    {"min",  "minute",     "minutes"},
+    {"Hz",   "hertz",      "hertz"},
+    {"km",   "kilometer",  "kilometers"},
+    {"cm",   "centimeter", "centimeters"},
+    {"mm",   "millimeter", "millimeters"},
+    {"kg",   "kilogram",   "kilograms"},
+    {"mg",   "milligram",  "milligrams"},
+    {"ml",   "milliliter", "milliliters"},
+    {"mL",   "milliliter", "milliliters"},
+    {"lb",   "pound",      "pounds"},
+    {"oz",   "ounce",      "ounces"},
+    {"ft",   "foot",       "feet"},
+    {"mi",   "mile",       "miles"},
+    {"TB",   "terabyte",   "terabytes"},
+    {"GB",   "gigabyte",   "gigabytes"},
+    {"MB",   "megabyte",   "megabytes"},
+    {"KB",   "kilobyte",   "kilobytes"},
+    {"kB",   "kilobyte",   "kilobytes"},
+    {"kW",   "kilowatt",   "kilowatts"},
+    {"ms",   "millisecond", "milliseconds"},
+    {"hr",   "hour",       "hours"},
+    {"m",    "meter",      "meters"},
+    {"g",    "gram",       "grams"},
+    {"l",    "liter",      "liters"},
+    {"L",    "liter",      "liters"},
+    {"W",    "watt",       "watts"},
+    {"V",    "volt",       "volts"},
+    {"s",    "second",     "seconds"},
+    {"h",    "hour",       "hours"},
+};
+
+struct Currency {
+    const char * symbol;
+    const char * singular;
+    const char * plural;
+    const char * minor;
+};
+
+const Currency k_currencies[] = {
+    {"$",            "dollar", "dollars", "cents"},
+    {"\xE2\x82\xAC", "euro",   "euros",   "cents"},
+    {"\xC2\xA3",     "pound",  "pounds",  "pence"},
+};
+
+// Words after which a four-digit number is read as a year
+const char * const k_year_cues[] = {
+    "in", "since", "by", "from", "until", "till", "year", "during", "around",
+    "before", "after", "circa",
+};
+
+// Abbreviations that end in a period without ending the sentence
+const char * const k_no_break[] = {
+    "dr", "mr", "mrs", "ms", "prof", "jr", "sr", "st", "vs", "etc", "e.g", "i.e",
+    "approx", "fig", "mt", "a.m", "p.m",
+};
+
+inline bool is_digit(char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }
+inline bool is_alpha(char c) { return std::isalpha(static_cast<unsigned char>(c)) != 0; }
+inline bool is_alnum(char c) { return std::isalnum(static_cast<unsigned char>(c)) != 0; }
+inline bool is_space(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+bool starts_with(const std::string & s, size_t pos, const char * prefix) {
+    const size_t len = std::strlen(prefix);
+    return s.compare(pos, len, prefix) == 0;
+}
+
+std::string lower(std::string s) {
+    for (auto & c : s) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return s;
+}
+
+std::string below_thousand(unsigned n) {
+    std::string out;
+    if (n >= 100) {
+        out = std::string(k_ones[n / 100]) + " hundred";
+        n %= 100;
+        if (n == 0) {
+            return out;
+        }
+        out += ' ';
+    }
+    if (n < 20) {
+        out += k_ones[n];
+    } else {
+        out += k_tens[n / 10];
+        if (n % 10) {
+            out += '-';
+            out += k_ones[n % 10];
+        }
+    }
+    return out;
+}
+
+// "twenty-one" -> "twenty-first", "twelve" -> "twelfth"
+std::string to_ordinal(const std::string & words) {
+    static const Replacement irregular[] = {
+        {"one", "first"}, {"two", "second"}, {"three", "third"}, {"five", "fifth"},
+        {"eight", "eighth"}, {"nine", "ninth"}, {"twelve", "twelfth"},
+    };
+
+    const size_t start = words.find_last_of(" -") == std::string::npos ? 0 : words.find_last_of(" -") + 1;
+    const std::string head = words.substr(0, start);
+    const std::string last = words.substr(start);
+
+    for (const auto & r : irregular) {
+        if (last == r.from) {
+            return head + r.to;
+        }
+    }
+    if (!last.empty() && last.back() == 'y') {
+        return head + last.substr(0, last.size() - 1) + "ieth";
+    }
+    return head + last + "th";
+}
+
+std::string year_to_words(unsigned year) {
+    if ((year >= 2000 && year < 2010) || year < 1000) {
+        return TextNormalizer::number_to_words(year);
+    }
+    const unsigned hi = year / 100;
+    const unsigned lo = year % 100;
+    if (lo == 0) {
+        return below_thousand(hi) + " hundred";
+    }
+    return below_thousand(hi) + (lo < 10 ? " oh " : " ") + below_thousand(lo);
+}
+
+// "ninety" -> "nineties", "thousand" -> "thousands", "six" -> "sixes"
+std::string pluralize(const std::string & words) {
+    if (!words.empty() && words.back() == 'y') {
+        return words.substr(0, words.size() - 1) + "ies";
+    }
+    if (!words.empty() && words.back() == 'x') {
+        return words + "es";
+    }
+    return words + "s";
+}
+
+// Denominators read as fractions; other a/b pairs ("24/7", "9/11") keep
+// their numbers
+const unsigned k_fraction_denominators[] = {2, 3, 4, 5, 6, 8, 10, 12, 16, 32, 64, 100};
+
+size_t digit_run(const std::string & s, size_t i) {
+    size_t j = i;
+    while (j < s.size() && is_digit(s[j])) ++j;
+    return j - i;
+}
+
+// Proper fraction at s[i]: 1/2 -> "one half", 3/4 -> "three quarters",
+// 5/8 -> "five eighths". Returns the position after it, or i (with out
+// untouched) if s[i] does not start one.
+size_t expand_fraction(const std::string & s, size_t i, std::string & out) {
+    const size_t n = s.size();
+    const size_t a = digit_run(s, i);
+    if (a == 0 || a > 2 || (i > 0 && s[i - 1] == '/') || i + a + 1 >= n || s[i + a] != '/') {
+        return i;
+    }
+    const size_t b = digit_run(s, i + a + 1);
+    const size_t end = i + a + 1 + b;
+    if (b == 0 || b > 3 || (end < n && s[end] == '/')) {
+        return i;
+    }
+    const unsigned num = static_cast<unsigned>(std::stoul(s.substr(i, a)));
+    const unsigned den = static_cast<unsigned>(std::stoul(s.substr(i + a + 1, b)));
+    if (num == 0 || num >= den ||
+        std::find(std::begin(k_fraction_denominators), std::end(k_fraction_denominators), den) ==
+            std::end(k_fraction_denominators)) {
+        return i;
+    }
+
+    std::string unit = den == 2 ? "half" : den == 4 ? "quarter" : to_ordinal(below_thousand(den));
+    if (unit.compare(0, 4, "one ") == 0) {
+        unit.erase(0, 4);  // "one hundredth" -> "hundredth"
+    }
+    if (num > 1) {
+        unit = den == 2 ? "halves" : pluralize(unit);
+    }
+    out += below_thousand(num) + " " + unit;
+    return end;
+}
+
+// Slash date with a four-digit year: 10/15/2024 (month first, as in US
+// usage), or 15/10/2024 when the first field cannot be a month. Returns the
+// position after it, or i if s[i] does not start one.
+size_t expand_slash_date(const std::string & s, size_t i, std::string & out) {
+    const size_t n = s.size();
+    const size_t a = digit_run(s, i);
+    if (a == 0 || a > 2 || i + a + 1 >= n || s[i + a] != '/') {
+        return i;
+    }
+    const size_t b = digit_run(s, i + a + 1);
+    const size_t c_pos = i + a + 1 + b + 1;
+    if (b == 0 || b > 2 || c_pos >= n || s[c_pos - 1] != '/' || digit_run(s, c_pos) != 4 ||
+        (c_pos + 4 < n && s[c_pos + 4] == '/')) {
+        return i;
+    }
+    const unsigned first  = static_cast<unsigned>(std::stoul(s.substr(i, a)));
+    const unsigned second = static_cast<unsigned>(std::stoul(s.substr(i + a + 1, b)));
+    const unsigned year   = static_cast<unsigned>(std::stoul(s.substr(c_pos, 4)));
+    const unsigned month  = first <= 12 ? first : second;
+    const unsigned day    = first <= 12 ? second : first;
+    if (month < 1 || month > 12 || day < 1 || day > 31) {
+        return i;
+    }
+    out += std::string(k_months[month - 1]) + " " + to_ordinal(below_thousand(day)) + ", " + year_to_words(year);
+    return c_pos + 4;
+}
+
+// Phone-style digit groups: 555-1234, 555-123-4567, 1-800-555-1234. Returns
+// the group lengths, or nothing if s[i] does not start such a number. A bare
+// 3-4 pair is only a phone number if it does not look like a range
+// ("100-1000", "250-1500").
+std::vector<size_t> phone_groups(const std::string & s, size_t i) {
+    static const std::vector<size_t> patterns[] = {{1, 3, 3, 4}, {3, 3, 4}, {3, 4}};
+    const size_t n = s.size();
+
+    std::vector<size_t> groups;
+    size_t j = i;
+    while (true) {
+        size_t k = j;
+        while (k < n && is_digit(s[k])) ++k;
+        groups.push_back(k - j);
+        if (k + 1 < n && s[k] == '-' && is_digit(s[k + 1])) {
+            j = k + 1;
+            continue;
+        }
+        break;
+    }
+    if (groups.size() == 2 && groups[0] == 3 && groups[1] == 4 && i + 8 <= n &&
+        (s[i] < '2' || s.compare(i + 6, 2, "00") == 0)) {
+        return {};
+    }
+    for (const auto & pattern : patterns) {
+        if (groups == pattern) {
+            return groups;
+        }
+    }
+    return {};
+}
+
+std::string digits_to_words(const std::string & digits) {
+    std::string out;
+    for (char d : digits) {
+        if (!out.empty()) {
+            out += ' ';
+        }
+        out += k_ones[d - '0'];
+    }
+    return out;
+}
+
+// Remove markdown / HTML that should not be spoken
+std::string strip_markup(const std::string & s) {
+    std::string out;
+    out.reserve(s.size());
+
+    bool line_start = true;
+    const size_t n = s.size();
+    size_t i = 0;
+
+    while (i < n) {
+        const char c = s[i];
+
+        if (c == '\n') {
+            // Unpunctuated lines (list items, headings) become clauses
+            const size_t last = out.find_last_not_of(' ');
+            if (last != std::string::npos && !std::strchr(".,;:!?", out[last])) {
+                out += ',';
+            }
+            out += ' ';
+            line_start = true;
+            ++i;
+            continue;
+        }
+
+        if (line_start) {
+            if (c == ' ' || c == '\t') {
+                ++i;
+                continue;
+            }
+            line_start = false;
+
+            // Headings, blockquotes, code fences and bullets
+            if (c == '#' || c == '>') {
+                while (i < n && (s[i] == '#' || s[i] == '>')) ++i;
+                continue;
+            }
+            if (starts_with(s, i, "```")) {
+                i += 3;
+                while (i < n && s[i] != '\n') ++i; // language tag
+                continue;
+            }
+            if ((c == '-' || c == '*' || c == '+') && i + 1 < n && s[i + 1] == ' ') {
+                i += 2;
+                continue;
+            }
+            if (starts_with(s, i, "\xE2\x80\xA2")) { // bullet
+                i += 3;
+                continue;
+            }
+            if (is_digit(c)) { // "1. " / "2) " list numbers
+                size_t j = i;
+                while (j < n && is_digit(s[j])) ++j;
+                if (j + 1 < n && (s[j] == '.' || s[j] == ')') && s[j + 1] == ' ') {
+                    i = j + 2;
+                    continue;
+                }
+            }
+        }
+
+        // [text](url) -> text
+        if (c == '[') {
+            const size_t close = s.find(']', i + 1);
+            if (close != std::string::npos && close + 1 < n && s[close + 1] == '(') {
+                const size_t paren = s.find(')', close + 2);
+                if (paren != std::string::npos) {
+                    out.append(s, i + 1, close - i - 1);
+                    i = paren + 1;
+                    continue;
+                }
+            }
+        }
+
+        // Bare URLs are not worth reading out
+        if (starts_with(s, i, "http://") || starts_with(s, i, "https://") || starts_with(s, i, "www.")) {
+            while (i < n && !is_space(s[i])) ++i;
+            out += "link";
+            continue;
+        }
+
+        // <tag> / </tag>
+        if (c == '<' && i + 1 < n && (is_alpha(s[i + 1]) || s[i + 1] == '/')) {
+            const size_t close = s.find('>', i + 1);
+            if (close != std::string::npos && close - i <= 64 &&
+                std::find_if(s.begin() + i, s.begin() + close, is_space) == s.begin() + close) {
+                i = close + 1;
+                continue;
+            }
+        }
+
+        if (c == '`') {
+            ++i;
+            continue;
+        }
+
+        // Emphasis markers; a lone '*' between numbers is multiplication
+        if (c == '*') {
+            const size_t prev = out.find_last_not_of(' ');
+            size_t next = i + 1;
+            while (next < n && s[next] == ' ') ++next;
+            if (prev != std::string::npos && is_digit(out[prev]) && next < n && is_digit(s[next])) {
+                out += " times ";
+            }
+            ++i;
+            continue;
+        }
+
+        // snake_case keeps a space; _emphasis_ markers are dropped
+        if (c == '_') {
+            if (!out.empty() && is_alnum(out.back()) && i + 1 < n && is_alnum(s[i + 1])) {
+                out += ' ';
+            }
+            ++i;
+            continue;
+        }
+
+        if (c == '|') {
+            out += ", ";
+            ++i;
+            continue;
+        }
+
+        out += c;
+        ++i;
+    }
+    return out;
+}
+
+// Try to expand a number token starting at s[i] (a digit). Appends words to
+// out and returns the position after the consumed text.
+size_t expand_number(const std::string & s, size_t i, const std::string & prev_word,
+                     const Currency * currency, std::string & out) {
+    const size_t n = s.size();
+
+    // ISO date: 2024-05-01
+    if (i + 10 <= n && is_digit(s[i]) && is_digit(s[i + 1]) && is_digit(s[i + 2]) && is_digit(s[i + 3]) &&
+        s[i + 4] == '-' && is_digit(s[i + 5]) && is_digit(s[i + 6]) && s[i + 7] == '-' &&
+        is_digit(s[i + 8]) && is_digit(s[i + 9]) && (i + 10 == n || !is_digit(s[i + 10]))) {
+        const unsigned year  = static_cast<unsigned>(std::stoul(s.substr(i, 4)));
+        const unsigned month = static_cast<unsigned>(std::stoul(s.substr(i + 5, 2)));
+        const unsigned day   = static_cast<unsigned>(std::stoul(s.substr(i + 8, 2)));
+        if (month >= 1 && month <= 12 && day >= 1 && day <= 31) {
+            out += std::string(k_months[month - 1]) + " " + to_ordinal(below_thousand(day)) + ", " + year_to_words(year);
+            return i + 10;
+        }
+    }
+
+    if (!currency) {
+        size_t end = expand_slash_date(s, i, out);
+        if (end == i) {
+            end = expand_fraction(s, i, out);
+        }
+        if (end != i) {
+            return end;
+        }
+    }
+
+    // Phone numbers are read digit by digit, a pause between groups
+    const std::vector<size_t> groups = currency ? std::vector<size_t>{} : phone_groups(s, i);
+    if (!groups.empty()) {
+        size_t j = i;
+        for (size_t g = 0; g < groups.size(); ++g) {
+            if (g > 0) {
+                out += ", ";
+                ++j; // '-'
+            }
+            out += digits_to_words(s.substr(j, groups[g]));
+            j += groups[g];
+        }
+        return j;
+    }
+
+    // Integer part, accepting well-formed thousands separators
+    std::string digits;
+    size_t j = i;
+    while (j < n && is_digit(s[j])) digits += s[j++];
+    bool grouped = false;
+    while (j + 3 < n && s[j] == ',' && is_digit(s[j + 1]) && is_digit(s[j + 2]) && is_digit(s[j + 3]) &&
+           (j + 4 == n || !is_digit(s[j + 4])) && (grouped || digits.size() <= 3)) {
+        digits.append(s, j + 1, 3);
+        j += 4;
+        grouped = true;
+    }
+
+    // Clock time: 9:30, 14:05
+    if (!currency && !grouped && digits.size() <= 2 && j + 2 < n && s[j] == ':' &&
+        is_digit(s[j + 1]) && is_digit(s[j + 2]) && (j + 3 == n || !is_digit(s[j + 3]))) {
+        const unsigned hour = static_cast<unsigned>(std::stoul(digits));
+        const unsigned minute = static_cast<unsigned>(std::stoul(s.substr(j + 1, 2)));
+        if (hour < 24 && minute < 60) {
+            out += below_thousand(hour);
+            if (minute == 0) {
+                out += " o'clock";
+            } else {
+                out += (minute < 10 ? " oh " : " ") + below_thousand(minute);
+            }
+            // "9:30 pm" reads like "9:30 p.m."
+            size_t k = j + 3;
+            if (k < n && s[k] == ' ') ++k;
+            const std::string meridiem = lower(s.substr(k, 2));
+            if ((meridiem == "am" || meridiem == "pm") && (k + 2 == n || !is_alnum(s[k + 2]))) {
+                out += meridiem == "am" ? " A M" : " P M";
+                return k + 2;
+            }
+            return j + 3;
+        }
+    }
+
+    // Fractional part
+    std::string fraction;
+    if (j + 1 < n && s[j] == '.' && is_digit(s[j + 1])) {
+        size_t k = j + 1;
+        while (k < n && is_digit(s[k])) fraction += s[k++];
+        j = k;
+    }
+
+    // Very long digit strings (phone numbers, IDs) are read digit by digit
+    if (digits.size() > 15) {
+        out += digits_to_words(digits);
+        return j;
+    }
+
+    const unsigned long long value = std::stoull(digits);
+    std::string words;
+
+    // Version numbers: 2.0.1 -> "two point zero point one"
+    if (!currency && !fraction.empty() && j + 1 < n && s[j] == '.' && is_digit(s[j + 1])) {
+        words = TextNormalizer::number_to_words(value) + " point " +
+                TextNormalizer::number_to_words(std::stoull(fraction.substr(0, 15)));
+        while (j + 1 < n && s[j] == '.' && is_digit(s[j + 1])) {
+            size_t k = j + 1;
+            while (k < n && is_digit(s[k])) ++k;
+            words += " point " + TextNormalizer::number_to_words(std::stoull(s.substr(j + 1, std::min<size_t>(k - j - 1, 15))));
+            j = k;
+        }
+        out += words;
+        return j;
+    }
+
+    if (currency) {
+        words = TextNormalizer::number_to_words(value) + " " + (value == 1 ? currency->singular : currency->plural);
+        if (!fraction.empty()) {
+            const std::string cents = (fraction + "0").substr(0, 2);
+            const unsigned minor = static_cast<unsigned>(std::stoul(cents));
+            if (minor > 0) {
+                words += " and " + below_thousand(minor) + " " + currency->minor;
+            }
+        }
+        out += words;
+        return j;
+    }
+
+    // Ordinals: 1st, 22nd, 3rd, 4th
+    if (fraction.empty() && j + 1 < n) {
+        const std::string suffix = lower(s.substr(j, 2));
+        if ((suffix == "st" || suffix == "nd" || suffix == "rd" || suffix == "th") &&
+            (j + 2 == n || !is_alpha(s[j + 2]))) {
+            out += to_ordinal(TextNormalizer::number_to_words(value));
+            return j + 2;
+        }
+    }
+
+    // Decades and plurals: 1990s, 80s, 1000s
+    if (fraction.empty() && !grouped && j < n && s[j] == 's' && (j + 1 == n || !is_alnum(s[j + 1]))) {
+        if (digits.size() == 4 && value >= 1100 && value <= 2099 && value % 10 == 0) {
+            words = year_to_words(static_cast<unsigned>(value));
+        } else {
+            words = TextNormalizer::number_to_words(value);
+            // "one thousand" -> "thousands"
+            if (value >= 100 && words.compare(0, 4, "one ") == 0 && words.find(' ', 4) == std::string::npos) {
+                words.erase(0, 4);
+            }
+        }
+        out += pluralize(words);
+        return j + 1;
+    }
+
+    // Years after temporal cues: "in 1999", "since 2010"
+    const bool year_cue = std::find(std::begin(k_year_cues), std::end(k_year_cues), prev_word) != std::end(k_year_cues) ||
+                          std::find_if(std::begin(k_months), std::end(k_months),
+                                       [&](const char * m) { return lower(m) == prev_word; }) != std::end(k_months);
+    if (year_cue && !grouped && fraction.empty() && digits.size() == 4 && value >= 1100 && value <= 2099) {
+        words = year_to_words(static_cast<unsigned>(value));
+    } else {
+        words = TextNormalizer::number_to_words(value);
+        if (!fraction.empty()) {
+            words += " point " + digits_to_words(fraction);
+        }
+    }
+
+    // Mixed numbers: 1 1/2 -> "one and one half"
+    bool mixed = false;
+    if (fraction.empty() && !grouped && j + 1 < n && s[j] == ' ' && is_digit(s[j + 1])) {
+        std::string part;
+        const size_t end = expand_fraction(s, j + 1, part);
+        if (end != j + 1) {
+            words += " and " + part;
+            j = end;
+            mixed = true;
+        }
+    }
+
+    // Percent and units directly after the number (optionally one space)
+    size_t k = j;
+    if (k < n && s[k] == ' ') ++k;
+    if (k < n && s[k] == '%') {
+        out += words + " percent";
+        return k + 1;
+    }
+    const bool plural = !(value == 1 && fraction.empty() && !mixed);
+    for (const auto & unit : k_units) {
+        const size_t len = std::strlen(unit.abbr);
+        if (len == 1 && k == j && std::islower(static_cast<unsigned char>(unit.abbr[0]))) {
+            continue;
+        }
+        if (starts_with(s, k, unit.abbr) && (k + len == n || !is_alnum(s[k + len]))) {
+            out += words + " " + (plural ? unit.plural : unit.singular);
+            return k + len;
+        }
+    }
+
+    out += words;
+    return j;
+}
+
+} // namespace
+
+std::string TextNormalizer::number_to_words(unsigned long long n) {
+    if (n == 0) {
+        return k_ones[0];
+    }
+
+    static const struct {
+        unsigned long long value;
+        const char * name;
+    } scales[] = {
+        {1000000000000ull, "trillion"},
+        {1000000000ull,    "billion"},
+        {1000000ull,       "million"},
+        {1000ull,          "thousand"},
+    };
+
+    std::string out;
+    for (const auto & scale : scales) {
+        if (n >= scale.value) {
+            if (!out.empty()) out += ' ';
+            out += number_to_words(n / scale.value) + " " + scale.name;
+            n %= scale.value;
+        }
+    }
+    if (n > 0) {
+        if (!out.empty()) out += ' ';
+        out += below_thousand(static_cast<unsigned>(n));
+    }
+    return out;
+}
+
+std::string TextNormalizer::normalize(const std::string & text) {
+    const std::string s = strip_markup(text);
+    const size_t n = s.size();
+
+    std::string out;
+    out.reserve(n + n / 2);
+    std::string prev_word;
+
+    size_t i = 0;
+    while (i < n) {
+        const char c = s[i];
+        const bool word_start = (i == 0 || !is_alnum(s[i - 1]));
+
+        // Abbreviations
+        if (word_start && is_alpha(c)) {
+            bool replaced = false;
+            for (const auto & r : k_abbreviations) {
+                const size_t len = std::strlen(r.from);
+                if (starts_with(s, i, r.from) && (i + len == n || !is_alnum(s[i + len]))) {
+                    out += r.to;
+                    prev_word = lower(r.to);
+                    i += len;
+                    replaced = true;
+                    break;
+                }
+            }
+            if (replaced) {
+                continue;
+            }
+            // "No. 5" -> "number five"
+            if (starts_with(s, i, "No.") && i + 4 < n && s[i + 3] == ' ' && is_digit(s[i + 4])) {
+                out += "number";
+                prev_word = "number";
+                i += 3;
+                continue;
+            }
+
+            size_t j = i;
+            while (j < n && (is_alpha(s[j]) || s[j] == '\'')) ++j;
+            out.append(s, i, j - i);
+            prev_word = lower(s.substr(i, j - i));
+            i = j;
+            continue;
+        }
+
+        // Currency before a number
+        const Currency * currency = nullptr;
+        size_t symbol_len = 0;
+        for (const auto & cur : k_currencies) {
+            const size_t len = std::strlen(cur.symbol);
+            if (starts_with(s, i, cur.symbol) && i + len < n && is_digit(s[i + len])) {
+                currency = &cur;
+                symbol_len = len;
+                break;
+            }
+        }
+        if (currency) {
+            out += ' ';
+            i = expand_number(s, i + symbol_len, prev_word, currency, out);
+            out += ' ';
+            prev_word.clear();
+            continue;
+        }
+
+        if (is_digit(c) && word_start) {
+            out += ' ';
+            i = expand_number(s, i, prev_word, nullptr, out);
+            out += ' ';
+            prev_word.clear();
+            continue;
+        }
+
+        // Negative numbers and numeric ranges
+        if (c == '-' && i + 1 < n && is_digit(s[i + 1])) {
+            if (i > 0 && is_digit(s[i - 1])) {
+                out += " to ";
+            } else if (i == 0 || is_space(s[i - 1]) || s[i - 1] == '(') {
+                out += " minus ";
+            } else {
+                out += ' ';
+            }
+            ++i;
+            continue;
+        }
+
+        // Symbols
+        switch (c) {
+            case '&': out += " and ";    ++i; continue;
+            case '@': out += " at ";     ++i; continue;
+            case '=': out += " equals "; ++i; continue;
+            case '%': out += " percent"; ++i; continue;
+            case '+':
+                out += (i + 1 < n && (is_digit(s[i + 1]) || s[i + 1] == ' ')) ? " plus " : " ";
+                ++i;
+                continue;
+            case '#':
+                out += (i + 1 < n && is_digit(s[i + 1])) ? "number " : " ";
+                ++i;
+                continue;
+            case '~':
+                out += (i + 1 < n && is_digit(s[i + 1])) ? "about " : " ";
+                ++i;
+                continue;
+            case '/': case '\\': case '^': case '<': case '>': case '{': case '}': case '[': case ']':
+                out += ' ';
+                ++i;
+                continue;
+            default:
+                break;
+        }
+
+        out += c;
+        ++i;
+    }
+
+    // Collapse whitespace and drop spaces before punctuation
+    std::string result;
+    result.reserve(out.size());
+    for (char c : out) {
+        if (is_space(c)) {
+            if (!result.empty() && result.back() != ' ') {
+                result += ' ';
+            }
+            continue;
+        }
+        if (std::strchr(".,;:!?)", c) && !result.empty() && result.back() == ' ') {
+            result.pop_back();
+        }
+        result += c;
+    }
+    while (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
+
+std::vector<std::string> TextSegmenter::push(const std::string & chunk) {
+    m_buffer += chunk;
+
+    std::vector<std::string> segments;
+    size_t len;
+    while ((len = find_boundary()) > 0) {
+        segments.push_back(m_buffer.substr(0, len));
+        m_buffer.erase(0, len);
+    }
+    return segments;
+}
+
+std::string TextSegmenter::flush() {
+    std::string out;
+    out.swap(m_buffer);
+    return out;
+}
+
+size_t TextSegmenter::find_boundary() const {
+    const size_t n = m_buffer.size();
+    size_t content = 0; // non-space characters seen so far
+
+    for (size_t i = 0; i + 1 < n; ++i) {
+        const char c = m_buffer[i];
+        const char next = m_buffer[i + 1];
+
+        if (!is_space(c)) {
+            ++content;
+        }
+
+        if (i + 1 > m_max_chars) {
+            break;
+        }
+
+        if (c == '\n' && content > 0) {
+            return i + 1;
+        }
+
+        if ((c == '.' || c == '!' || c == '?') && content > 1) {
+            // Allow a closing quote or bracket after the terminator
+            size_t end = i + 1;
+            if ((next == '"' || next == ')' || next == '\'') && i + 2 < n) {
+                ++end;
+            }
+            if (!is_space(m_buffer[end])) {
+                continue;
+            }
+            if (c == '.') {
+                // Word before the period: abbreviation, initial or list number?
+                size_t w = i;
+                while (w > 0 && (is_alpha(m_buffer[w - 1]) || is_digit(m_buffer[w - 1]) || m_buffer[w - 1] == '.')) --w;
+                const std::string word = lower(m_buffer.substr(w, i - w));
+                if (word.size() == 1 && is_alpha(word[0])) {
+                    continue;
+                }
+                if (std::find(std::begin(k_no_break), std::end(k_no_break), word) != std::end(k_no_break)) {
+                    continue;
+                }
+                // "No. 5" is a number, "No. I don't" a sentence; wait to see which
+                if (word == "no") {
+                    const size_t after = m_buffer.find_first_not_of(" \t", end);
+                    if (after == std::string::npos || is_digit(m_buffer[after])) {
+                        continue;
+                    }
+                }
+                const bool all_digits = !word.empty() &&
+                    std::all_of(word.begin(), word.end(), [](char d) { return is_digit(d); });
+                const size_t line = m_buffer.find_last_not_of(" \t", w == 0 ? 0 : w - 1);
+                if (all_digits && (w == 0 || line == std::string::npos || m_buffer[line] == '\n' ||
+                                   m_buffer.find_first_not_of(" \t\r\n") == w)) {
+                    continue;
+                }
+            }
+            return end;
+        }
+
+        if ((c == ',' || c == ';' || c == ':') && is_space(next) && content >= m_min_chars) {
+            return i + 1;
+        }
+    }
+
+    // Too long without a boundary: split at the last space before max_chars
+    if (n > m_max_chars) {
+        size_t cut = m_buffer.rfind(' ', m_max_chars);
+        if (cut == std::string::npos || cut == 0) {
+            cut = m_max_chars;
+            while (cut > 0 && (static_cast<unsigned char>(m_buffer[cut]) & 0xC0) == 0x80) {
+                --cut; // keep UTF-8 sequences intact
+            }
+        }
+        return cut;
+    }
+    return 0;
+}
@@ -0,0 +1,371 @@
+#include "tts_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t k_disk_magic   = 0x4354544c; // "LTTC"
+constexpr uint32_t k_disk_version = 1;
+
+constexpr uint64_t k_fnv_offset = 0xcbf29ce484222325ull;
+constexpr uint64_t k_fnv_prime  = 0x100000001b3ull;
+
+uint64_t fnv1a(const void * data, size_t n, uint64_t hash = k_fnv_offset) {
+    const unsigned char * p = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < n; ++i) {
+        hash ^= p[i];
+        hash *= k_fnv_prime;
+    }
+    return hash;
+}
+
+size_t entry_bytes(const std::string & text, const TTSCacheEntry & entry) {
+    return text.size() +
+           entry.audio.size() * sizeof(int16_t) +
+           entry.phoneme_timings.size() * sizeof(PhonemeTimingInfo);
+}
+
+struct DiskHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t fingerprint;
+    uint32_t sample_rate;
+    uint32_t text_len;
+    uint32_t n_samples;
+    uint32_t n_phonemes;
+};
+
+} // namespace
+
+TTSAudioCache::TTSAudioCache(const Options & options, uint64_t model_fingerprint)
+    : m_options(options), m_fingerprint(model_fingerprint) {
+    if (m_options.disk_path.empty()) {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(m_options.disk_path, ec);
+    if (ec) {
+        fprintf(stderr, "%s: cannot create cache directory '%s': %s\n", __func__,
+                m_options.disk_path.c_str(), ec.message().c_str());
+        m_options.disk_path.clear();
+        return;
+    }
+
+    // Rebuild the disk LRU from file mtimes, which lookups refresh
+    struct Found {
+        std::filesystem::file_time_type mtime;
+        DiskNode node;
+    };
+    std::vector<Found> found;
+    for (const auto & file : std::filesystem::directory_iterator(m_options.disk_path, ec)) {
+        if (!file.is_regular_file(ec)) {
+            continue;
+        }
+        if (file.path().extension() == ".tmp") {
+            std::filesystem::remove(file.path(), ec); // interrupted write
+        } else if (file.path().extension() == ".pcm") {
+            found.push_back({file.last_write_time(ec),
+                             DiskNode{file.path().string(), static_cast<size_t>(file.file_size(ec))}});
+        }
+    }
+    std::sort(found.begin(), found.end(), [](const Found & a, const Found & b) { return a.mtime > b.mtime; });
+
+    for (auto & f : found) {
+        m_disk_used += f.node.bytes;
+        m_disk_lru.push_back(std::move(f.node));
+        m_disk_index[m_disk_lru.back().path] = std::prev(m_disk_lru.end());
+    }
+
+    // The budget may have shrunk, or another process overfilled the directory
+    std::vector<std::string> evicted;
+    evict_disk_locked(evicted);
+    for (const auto & file : evicted) {
+        std::remove(file.c_str());
+    }
+}
+
+std::string TTSAudioCache::normalize(const std::string & text) {
+    std::string out;
+    out.reserve(text.size());
+    bool pending_space = false;
+    for (char c : text) {
+        if (std::isspace(static_cast<unsigned char>(c))) {
+            pending_space = !out.empty();
+            continue;
+        }
+        if (pending_space) {
+            out.push_back(' ');
+            pending_space = false;
+        }
+        out.push_back(c);
+    }
+    return out;
+}
+
+uint64_t TTSAudioCache::fingerprint_files(const std::vector<std::string> & paths) {
+    uint64_t hash = k_fnv_offset;
+    for (const auto & path : paths) {
+        hash = fnv1a(path.data(), path.size(), hash);
+
+        std::error_code ec;
+        const auto size  = std::filesystem::file_size(path, ec);
+        const uint64_t size_value = ec ? 0 : static_cast<uint64_t>(size);
+        hash = fnv1a(&size_value, sizeof(size_value), hash);
+
+        const auto mtime = std::filesystem::last_write_time(path, ec);
+        const int64_t mtime_value = ec ? 0 : static_cast<int64_t>(mtime.time_since_epoch().count());
+        hash = fnv1a(&mtime_value, sizeof(mtime_value), hash);
+
+        // Small text configs (voice, speaker, scales) are hashed in full
+        if (!ec && size_value <= (1u << 20) && std::filesystem::path(path).extension() == ".json") {
+            std::ifstream in(path, std::ios::binary);
+            std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+            hash = fnv1a(contents.data(), contents.size(), hash);
+        }
+    }
+    return hash;
+}
+
+bool TTSAudioCache::cacheable(const std::string & normalized) const {
+    return !normalized.empty() && normalized.size() <= m_options.max_text_chars;
+}
+
+bool TTSAudioCache::lookup(const std::string & normalized, bool with_phonemes, TTSCacheEntry & out) {
+    if (!cacheable(normalized)) {
+        return false;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_index.find(normalized);
+        if (it != m_index.end() && (!with_phonemes || !it->second->entry.phoneme_timings.empty())) {
+            m_lru.splice(m_lru.begin(), m_lru, it->second);
+            out = it->second->entry;
+            ++m_hits;
+            if (!m_options.disk_path.empty()) {
+                touch_disk_locked(disk_file(normalized));
+            }
+            return true;
+        }
+    }
+
+    // Disk I/O happens outside the lock so other workers are not stalled
+    TTSCacheEntry from_disk;
+    if (read_disk(normalized, from_disk) && (!with_phonemes || !from_disk.phoneme_timings.empty())) {
+        const std::string path = disk_file(normalized);
+        bool on_disk = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            insert_locked(normalized, from_disk);
+            on_disk = touch_disk_locked(path);
+            ++m_hits;
+            ++m_disk_hits;
+        }
+        // Persist the access so the order survives a restart
+        std::error_code ec;
+        if (on_disk) {
+            std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+        }
+        out = std::move(from_disk);
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ++m_misses;
+    return false;
+}
+
+void TTSAudioCache::insert(const std::string & normalized, const TTSCacheEntry & entry) {
+    if (!cacheable(normalized) || entry.audio.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        insert_locked(normalized, entry);
+    }
+
+    if (!m_options.disk_path.empty()) {
+        write_disk(normalized, entry);
+    }
+}
+
+TTSAudioCache::Stats TTSAudioCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    Stats s;
+    s.hits        = m_hits;
+    s.disk_hits   = m_disk_hits;
+    s.misses      = m_misses;
+    s.entries     = m_lru.size();
+    s.memory_used = m_memory_used;
+    s.disk_files  = m_disk_lru.size();
+    s.disk_used   = m_disk_used;
+    return s;
+}
+
+void TTSAudioCache::insert_locked(const std::string & normalized, const TTSCacheEntry & entry) {
+    const size_t bytes = entry_bytes(normalized, entry);
+    if (bytes > m_options.memory_bytes) {
+        return;
+    }
+
+    auto it = m_index.find(normalized);
+    if (it != m_index.end()) {
+        m_memory_used -= it->second->bytes;
+        m_lru.erase(it->second);
+        m_index.erase(it);
+    }
+
+    while (!m_lru.empty() && m_memory_used + bytes > m_options.memory_bytes) {
+        m_memory_used -= m_lru.back().bytes;
+        m_index.erase(m_lru.back().text);
+        m_lru.pop_back();
+    }
+
+    m_lru.push_front(Node{normalized, entry, bytes});
+    m_index[normalized] = m_lru.begin();
+    m_memory_used += bytes;
+}
+
+std::string TTSAudioCache::disk_file(const std::string & normalized) const {
+    uint64_t hash = fnv1a(&m_fingerprint, sizeof(m_fingerprint));
+    hash = fnv1a(normalized.data(), normalized.size(), hash);
+
+    char name[32];
+    snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(hash));
+    return (std::filesystem::path(m_options.disk_path) / name).string();
+}
+
+bool TTSAudioCache::read_disk(const std::string & normalized, TTSCacheEntry & out) const {
+    if (m_options.disk_path.empty()) {
+        return false;
+    }
+
+    std::ifstream in(disk_file(normalized), std::ios::binary);
+    if (!in) {
+        return false;
+    }
+
+    DiskHeader header{};
+    if (!in.read(reinterpret_cast<char *>(&header), sizeof(header)) ||
+        header.magic != k_disk_magic || header.version != k_disk_version ||
+        header.fingerprint != m_fingerprint || header.text_len != normalized.size()) {
+        return false;
+    }
+
+    // The file name is a hash; compare the stored text to rule out collisions
+    std::string text(header.text_len, '\0');
+    if (!in.read(&text[0], text.size()) || text != normalized) {
+        return false;
+    }
+
+    out.sample_rate = header.sample_rate;
+    out.audio.resize(header.n_samples);
+    out.phoneme_timings.resize(header.n_phonemes);
+    if (!in.read(reinterpret_cast<char *>(out.audio.data()), out.audio.size() * sizeof(int16_t))) {
+        return false;
+    }
+    for (auto & phoneme : out.phoneme_timings) {
+        if (!in.read(reinterpret_cast<char *>(&phoneme.phoneme_id), sizeof(phoneme.phoneme_id)) ||
+            !in.read(reinterpret_cast<char *>(&phoneme.duration_seconds), sizeof(phoneme.duration_seconds))) {
+            return false;
+        }
+    }
+    return !out.audio.empty();
+}
+
+bool TTSAudioCache::touch_disk_locked(const std::string & path) {
+    auto it = m_disk_index.find(path);
+    if (it == m_disk_index.end()) {
+        return false;
+    }
+    m_disk_lru.splice(m_disk_lru.begin(), m_disk_lru, it->second);
+    return true;
+}
+
+void TTSAudioCache::write_disk(const std::string & normalized, const TTSCacheEntry & entry) {
+    const size_t bytes = sizeof(DiskHeader) + normalized.size() +
+                         entry.audio.size() * sizeof(int16_t) +
+                         entry.phoneme_timings.size() * (sizeof(int64_t) + sizeof(float));
+    if (bytes > m_options.disk_bytes) {
+        return;
+    }
+
+    // Workers (or processes) writing the same phrase each get their own temp
+    // file; the last rename wins with a complete file
+    static std::atomic<uint64_t> s_tmp_counter{0};
+    const std::string path = disk_file(normalized);
+    const std::string tmp  = path + "." + std::to_string(getpid()) + "." +
+                             std::to_string(s_tmp_counter.fetch_add(1, std::memory_order_relaxed)) + ".tmp";
+
+    DiskHeader header{};
+    header.magic       = k_disk_magic;
+    header.version     = k_disk_version;
+    header.fingerprint = m_fingerprint;
+    header.sample_rate = entry.sample_rate;
+    header.text_len    = static_cast<uint32_t>(normalized.size());
+    header.n_samples   = static_cast<uint32_t>(entry.audio.size());
+    header.n_phonemes  = static_cast<uint32_t>(entry.phoneme_timings.size());
+
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            return;
+        }
+        out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        out.write(normalized.data(), normalized.size());
+        out.write(reinterpret_cast<const char *>(entry.audio.data()), entry.audio.size() * sizeof(int16_t));
+        for (const auto & phoneme : entry.phoneme_timings) {
+            out.write(reinterpret_cast<const char *>(&phoneme.phoneme_id), sizeof(phoneme.phoneme_id));
+            out.write(reinterpret_cast<const char *>(&phoneme.duration_seconds), sizeof(phoneme.duration_seconds));
+        }
+        if (!out) {
+            std::remove(tmp.c_str());
+            return;
+        }
+    }
+
+    // Rename so concurrent readers never see a partial file
+    std::error_code ec;
+    std::filesystem::rename(tmp, path, ec);
+    if (ec) {
+        std::remove(tmp.c_str());
+        return;
+    }
+
+    std::vector<std::string> evicted;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_disk_index.find(path);
+        if (it != m_disk_index.end()) {
+            m_disk_used -= it->second->bytes;
+            m_disk_lru.erase(it->second);
+        }
+        m_disk_lru.push_front(DiskNode{path, bytes});
+        m_disk_index[path] = m_disk_lru.begin();
+        m_disk_used += bytes;
+        evict_disk_locked(evicted);
+    }
+
+    for (const auto & file : evicted) {
+        std::remove(file.c_str());
+    }
+}
+
+void TTSAudioCache::evict_disk_locked(std::vector<std::string> & evicted) {
+    // The most recent file stays even when it alone exceeds the budget
+    while (m_disk_used > m_options.disk_bytes && m_disk_lru.size() > 1) {
+        m_disk_used -= m_disk_lru.back().bytes;
+        m_disk_index.erase(m_disk_lru.back().path);
+        evicted.push_back(std::move(m_disk_lru.back().path));
+        m_disk_lru.pop_back();
+    }
+}
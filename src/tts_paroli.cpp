@@ -2,10 +2,679 @@
 #include "config_manager.h"
 #include "paroli_daemon.hpp"
 #include "async_pipeline.h"
+#include "pcm_kernels.h"
+#include <nlohmann/json.hpp>
+#include <onnxruntime_cxx_api.h>
+#include <phonemize.hpp>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
 #include <iostream>
 #include <filesystem>
+#include <fstream>
+#include <future>
+#include <list>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <thread>
 #include <vector>
 
+namespace {
+
+// Phrases shorter than this are merged with the next one; very short
+// utterances synthesize with poor prosody and gain little latency.
+constexpr size_t kMinPhraseChars = 20;
+
+bool IsPhraseBreak(char c) {
+    return c == '.' || c == '!' || c == '?' || c == ';' || c == ':' || c == ',';
+}
+
+// Split text at clause punctuation followed by whitespace so each phrase can
+// be synthesized and played while the next one is still being generated.
+std::vector<std::string> SplitPhrases(const std::string &text) {
+    std::vector<std::string> phrases;
+    std::string current;
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        current.push_back(c);
+
+        const bool at_break = c == '\n' ||
+            (IsPhraseBreak(c) && (i + 1 == text.size() || std::isspace(static_cast<unsigned char>(text[i + 1]))));
+        if (at_break && current.size() >= kMinPhraseChars) {
+            phrases.push_back(std::move(current));
+            current.clear();
+        }
+    }
+
+    if (current.find_first_not_of(" \t\r\n") != std::string::npos) {
+        if (!phrases.empty() && current.size() < kMinPhraseChars / 2) {
+            phrases.back() += current;
+        } else {
+            phrases.push_back(std::move(current));
+        }
+    }
+    return phrases;
+}
+
+GraphOptimizationLevel ParseOptimizationLevel(const std::string &level) {
+    if (level == "disabled") return ORT_DISABLE_ALL;
+    if (level == "basic") return ORT_ENABLE_BASIC;
+    if (level == "extended") return ORT_ENABLE_EXTENDED;
+    return ORT_ENABLE_ALL;
+}
+
+// Session options for the TTS models from settings.tts.onnx. Unless set,
+// intra-op threads split the cores among the synthesis workers that
+// TTSProcessor::start_workers() will run, so parallel workers do not each
+// spin up a full-size thread pool.
+Ort::SessionOptions TtsSessionOptions() {
+    auto &config = ConfigManager::getInstance();
+    Ort::SessionOptions options;
+    options.SetGraphOptimizationLevel(ParseOptimizationLevel(config.getTtsOnnxOptimizationLevel()));
+
+    int intra_op = config.getTtsOnnxIntraOpThreads();
+    if (intra_op <= 0) {
+        const int hw_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+        const int workers = config.getTtsWorkers() > 0 ? config.getTtsWorkers()
+                                                       : std::max(1, config.getTtsMaxWorkers());
+        intra_op = std::max(1, hw_threads / std::min(workers, hw_threads));
+    }
+    options.SetIntraOpNumThreads(intra_op);
+    options.SetInterOpNumThreads(std::max(1, config.getTtsOnnxInterOpThreads()));
+    options.SetExecutionMode(config.getTtsOnnxExecutionMode() == "parallel" ? ORT_PARALLEL : ORT_SEQUENTIAL);
+    if (config.getTtsOnnxCpuMemArena()) {
+        options.EnableCpuMemArena();
+    } else {
+        options.DisableCpuMemArena();
+    }
+    return options;
+}
+
+// Return the path of an ONNX Runtime-optimized copy of model_path, creating it
+// in cache_dir on first use. The file name carries the optimization level and
+// a fingerprint of the source model, so a changed model is re-optimized.
+// Level "all" is stored at "extended": layout optimizations are specific to
+// the execution provider and CPU, and are applied again when the session
+// loading the copy runs at "all". Falls back to model_path if optimization
+// fails.
+std::string OptimizedModelPath(const std::string &model_path, const std::string &level, const std::string &cache_dir) {
+    namespace fs = std::filesystem;
+
+    const std::string level_name = level == "disabled" || level == "basic" ? level : "extended";
+
+    char fingerprint[17];
+    snprintf(fingerprint, sizeof(fingerprint), "%016llx",
+             static_cast<unsigned long long>(TTSAudioCache::fingerprint_files({model_path})));
+    const fs::path cached = fs::path(cache_dir) /
+        (fs::path(model_path).stem().string() + "." + level_name + "." + fingerprint + ".onnx");
+
+    std::error_code ec;
+    if (fs::exists(cached, ec)) {
+        return cached.string();
+    }
+
+    fs::create_directories(cache_dir, ec);
+    const fs::path tmp = cached.string() + ".tmp";
+    try {
+        static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "paroli-optimize");
+
+        Ort::SessionOptions options;
+        options.SetGraphOptimizationLevel(ParseOptimizationLevel(level_name));
+        options.SetOptimizedModelFilePath(tmp.c_str());
+
+        // Creating the session runs the graph transformers and writes the result
+        Ort::Session session(env, model_path.c_str(), options);
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to optimize " << model_path << ": " << e.what() << std::endl;
+        fs::remove(tmp, ec);
+        return model_path;
+    }
+
+    fs::rename(tmp, cached, ec);
+    if (ec) {
+        std::cerr << "Failed to store optimized model " << cached << ": " << ec.message() << std::endl;
+        fs::remove(tmp, ec);
+        return model_path;
+    }
+
+    std::cout << "Optimized " << model_path << " -> " << cached << std::endl;
+    return cached.string();
+}
+
+// eSpeak keeps global state, so phonemization is serialized across workers.
+// ParoliSynthesizer phonemizes inside its synthesize calls and initializes
+// eSpeak in its constructor, so those run under this lock as a whole; the
+// phoneme-ID path holds it only while phonemizing a word.
+std::mutex g_espeak_mutex;
+
+// Decode a one-codepoint UTF-8 phoneme_id_map key
+char32_t DecodePhoneme(const std::string &s) {
+    const auto *p = reinterpret_cast<const unsigned char *>(s.data());
+    if (s.empty()) return 0;
+    if (p[0] < 0x80) return p[0];
+    if ((p[0] >> 5) == 0x6 && s.size() >= 2) return ((p[0] & 0x1f) << 6) | (p[1] & 0x3f);
+    if ((p[0] >> 4) == 0xe && s.size() >= 3) return ((p[0] & 0x0f) << 12) | ((p[1] & 0x3f) << 6) | (p[2] & 0x3f);
+    if ((p[0] >> 3) == 0x1e && s.size() >= 4)
+        return ((p[0] & 0x07) << 18) | ((p[1] & 0x3f) << 12) | ((p[2] & 0x3f) << 6) | (p[3] & 0x3f);
+    return 0;
+}
+
+// Text -> phoneme IDs -> PCM for a Paroli voice, with phonemization split
+// from the encoder/decoder so the IDs of recurring words can be cached.
+// ParoliSynthesizer only accepts text, so this runs its own sessions on the
+// same model files. IDs follow Piper's layout: BOS, then every phoneme
+// followed by the pad ID, then EOS.
+class PhonemeIdSynthesizer {
+public:
+    // Null if the voice is not eSpeak-phonemized or its encoder/decoder
+    // inputs are not the Paroli ones this runner knows how to feed
+    static std::unique_ptr<PhonemeIdSynthesizer> load(const std::string &encoder, const std::string &decoder,
+                                                      const std::string &config_path, std::string &error) {
+        auto synth = std::unique_ptr<PhonemeIdSynthesizer>(new PhonemeIdSynthesizer());
+        try {
+            std::ifstream in(config_path);
+            const auto voice = nlohmann::json::parse(in);
+            if (voice.value("phoneme_type", std::string("espeak")) != "espeak") {
+                error = "voice is not phonemized with eSpeak";
+                return nullptr;
+            }
+            synth->espeak_.voice = voice.at("espeak").at("voice").get<std::string>();
+            synth->sample_rate_ = voice.at("audio").at("sample_rate").get<int>();
+            if (voice.contains("inference")) {
+                const auto &inference = voice["inference"];
+                synth->scales_ = {inference.value("noise_scale", 0.667f),
+                                  inference.value("length_scale", 1.0f),
+                                  inference.value("noise_w", 0.8f)};
+            }
+            for (const auto &item : voice.at("phoneme_id_map").items()) {
+                synth->id_map_[DecodePhoneme(item.key())] = item.value().get<std::vector<int64_t>>();
+            }
+            for (char32_t required : {U'_', U'^', U'$', U' '}) {
+                if (!synth->id_map_.count(required)) {
+                    error = "phoneme_id_map lacks pad, BOS, EOS or space";
+                    return nullptr;
+                }
+            }
+
+            static Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "paroli-phoneme-ids");
+            const Ort::SessionOptions options = TtsSessionOptions();
+            synth->encoder_ = std::make_unique<Ort::Session>(env, encoder.c_str(), options);
+            synth->decoder_ = std::make_unique<Ort::Session>(env, decoder.c_str(), options);
+        } catch (const std::exception &e) {
+            error = e.what();
+            return nullptr;
+        }
+
+        Ort::AllocatorWithDefaultOptions allocator;
+        auto names = [&](Ort::Session &session, bool inputs) {
+            std::vector<std::string> out;
+            const size_t n = inputs ? session.GetInputCount() : session.GetOutputCount();
+            for (size_t i = 0; i < n; ++i) {
+                out.emplace_back(inputs ? session.GetInputNameAllocated(i, allocator).get()
+                                        : session.GetOutputNameAllocated(i, allocator).get());
+            }
+            return out;
+        };
+        synth->encoder_inputs_ = names(*synth->encoder_, true);
+        synth->encoder_outputs_ = names(*synth->encoder_, false);
+        synth->decoder_inputs_ = names(*synth->decoder_, true);
+        synth->decoder_outputs_ = names(*synth->decoder_, false);
+
+        auto has = [](const std::vector<std::string> &list, const std::string &name) {
+            return std::find(list.begin(), list.end(), name) != list.end();
+        };
+        for (const auto &name : synth->encoder_inputs_) {
+            if (name != "input" && name != "input_lengths" && name != "scales" && name != "sid") {
+                error = "unknown encoder input " + name;
+                return nullptr;
+            }
+        }
+        if (!has(synth->encoder_inputs_, "input") || !has(synth->encoder_inputs_, "input_lengths")) {
+            error = "encoder has no input/input_lengths";
+            return nullptr;
+        }
+        for (const auto &name : synth->decoder_inputs_) {
+            if (name != "sid" && !has(synth->encoder_outputs_, name)) {
+                error = "decoder input " + name + " is not an encoder output";
+                return nullptr;
+            }
+        }
+        if (synth->decoder_outputs_.empty()) {
+            error = "decoder has no output";
+            return nullptr;
+        }
+        return synth;
+    }
+
+    int sample_rate() const { return sample_rate_; }
+
+    void set_volume(float volume) { volume_ = volume; }
+
+    // Phoneme IDs per sentence. Each whitespace-separated word is phonemized
+    // on its own so its IDs can be cached under key_prefix + word.
+    std::vector<std::vector<int64_t>> phonemize(const std::string &text, const std::string &key_prefix,
+                                                PhonemeCache *cache) const {
+        std::vector<std::vector<int64_t>> sentences;
+        std::vector<int64_t> sentence;
+        auto close_sentence = [&]() {
+            if (sentence.empty()) {
+                return;
+            }
+            std::vector<int64_t> ids = id_map_.at(U'^');
+            append_pad(ids);
+            ids.insert(ids.end(), sentence.begin(), sentence.end());
+            const auto &eos = id_map_.at(U'$');
+            ids.insert(ids.end(), eos.begin(), eos.end());
+            sentences.push_back(std::move(ids));
+            sentence.clear();
+        };
+
+        std::istringstream words(text);
+        std::string word;
+        while (words >> word) {
+            std::vector<int64_t> ids;
+            const std::string key = key_prefix + word;
+            if (!cache || !cache->lookup(key, ids)) {
+                ids = word_ids(word);
+                if (cache) {
+                    cache->insert(key, ids);
+                }
+            }
+            if (ids.empty()) {
+                continue;
+            }
+            if (!sentence.empty()) {
+                const auto &space = id_map_.at(U' ');
+                sentence.insert(sentence.end(), space.begin(), space.end());
+                append_pad(sentence);
+            }
+            sentence.insert(sentence.end(), ids.begin(), ids.end());
+
+            const char last = word.back();
+            if (last == '.' || last == '!' || last == '?') {
+                close_sentence();
+            }
+        }
+        close_sentence();
+        return sentences;
+    }
+
+    // Run the encoder and decoder per sentence; sentences are joined with a
+    // short pause as in Piper
+    std::vector<int16_t> synthesize(const std::vector<std::vector<int64_t>> &sentences) const {
+        std::vector<int16_t> audio;
+        const size_t pause = static_cast<size_t>(sample_rate_ * kSentenceSilenceSeconds);
+        for (size_t i = 0; i < sentences.size(); ++i) {
+            if (i > 0) {
+                audio.insert(audio.end(), pause, 0);
+            }
+            synthesize_sentence(sentences[i], audio);
+        }
+        return audio;
+    }
+
+private:
+    static constexpr float kSentenceSilenceSeconds = 0.2f;
+
+    mutable piper::eSpeakPhonemeConfig espeak_;  // piper takes it non-const; used under g_espeak_mutex
+    std::map<char32_t, std::vector<int64_t>> id_map_;
+    std::vector<float> scales_ = {0.667f, 1.0f, 0.8f};  // noise, length, noise_w
+    int sample_rate_ = 22050;
+    float volume_ = 1.0f;
+
+    std::unique_ptr<Ort::Session> encoder_;
+    std::unique_ptr<Ort::Session> decoder_;
+    std::vector<std::string> encoder_inputs_;
+    std::vector<std::string> encoder_outputs_;
+    std::vector<std::string> decoder_inputs_;
+    std::vector<std::string> decoder_outputs_;
+
+    PhonemeIdSynthesizer() = default;
+
+    void append_pad(std::vector<int64_t> &ids) const {
+        const auto &pad = id_map_.at(U'_');
+        ids.insert(ids.end(), pad.begin(), pad.end());
+    }
+
+    // One word's IDs, each phoneme followed by the pad; phonemes missing
+    // from the voice's map are dropped as Piper does
+    std::vector<int64_t> word_ids(const std::string &word) const {
+        std::vector<std::vector<piper::Phoneme>> phonemes;
+        {
+            std::lock_guard<std::mutex> lock(g_espeak_mutex);
+            piper::phonemize_eSpeak(word, espeak_, phonemes);
+        }
+
+        std::vector<piper::Phoneme> flat;
+        for (const auto &part : phonemes) {
+            if (!flat.empty() && !part.empty()) {
+                flat.push_back(U' ');
+            }
+            flat.insert(flat.end(), part.begin(), part.end());
+        }
+        while (!flat.empty() && flat.back() == U' ') {
+            flat.pop_back();  // eSpeak adds a space after clause punctuation
+        }
+
+        std::vector<int64_t> ids;
+        for (piper::Phoneme phoneme : flat) {
+            auto it = id_map_.find(phoneme);
+            if (it == id_map_.end()) {
+                continue;
+            }
+            ids.insert(ids.end(), it->second.begin(), it->second.end());
+            append_pad(ids);
+        }
+        return ids;
+    }
+
+    // Const and reentrant: the voice is shared by every synthesis worker, so
+    // all per-call state (IDs, scales, tensors) lives on this call's stack
+    void synthesize_sentence(std::vector<int64_t> ids, std::vector<int16_t> &audio) const {
+        auto memory = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+        const int64_t id_shape[] = {1, static_cast<int64_t>(ids.size())};
+        int64_t lengths[] = {static_cast<int64_t>(ids.size())};
+        int64_t speaker[] = {0};
+        std::vector<float> scales = scales_;
+        const int64_t one_shape[] = {1};
+        const int64_t scales_shape[] = {static_cast<int64_t>(scales.size())};
+
+        auto feed = [&](const std::string &name) -> Ort::Value {
+            if (name == "input") {
+                return Ort::Value::CreateTensor<int64_t>(memory, ids.data(), ids.size(), id_shape, 2);
+            }
+            if (name == "input_lengths") {
+                return Ort::Value::CreateTensor<int64_t>(memory, lengths, 1, one_shape, 1);
+            }
+            if (name == "scales") {
+                return Ort::Value::CreateTensor<float>(memory, scales.data(), scales.size(), scales_shape, 1);
+            }
+            return Ort::Value::CreateTensor<int64_t>(memory, speaker, 1, one_shape, 1);  // sid
+        };
+
+        std::vector<const char *> enc_in_names, enc_out_names;
+        std::vector<Ort::Value> enc_in;
+        for (const auto &name : encoder_inputs_) {
+            enc_in_names.push_back(name.c_str());
+            enc_in.push_back(feed(name));
+        }
+        for (const auto &name : encoder_outputs_) {
+            enc_out_names.push_back(name.c_str());
+        }
+        auto encoded = encoder_->Run(Ort::RunOptions{nullptr}, enc_in_names.data(), enc_in.data(), enc_in.size(),
+                                     enc_out_names.data(), enc_out_names.size());
+
+        std::vector<const char *> dec_in_names;
+        std::vector<Ort::Value> dec_in;
+        for (const auto &name : decoder_inputs_) {
+            dec_in_names.push_back(name.c_str());
+            const auto it = std::find(encoder_outputs_.begin(), encoder_outputs_.end(), name);
+            dec_in.push_back(it != encoder_outputs_.end() ? std::move(encoded[it - encoder_outputs_.begin()])
+                                                          : feed(name));
+        }
+        const char *dec_out_name = decoder_outputs_.front().c_str();
+        auto decoded = decoder_->Run(Ort::RunOptions{nullptr}, dec_in_names.data(), dec_in.data(), dec_in.size(),
+                                     &dec_out_name, 1);
+
+        // Peak-normalize to int16 like Piper, then apply the volume
+        const float *samples = decoded.front().GetTensorData<float>();
+        const size_t count = decoded.front().GetTensorTypeAndShapeInfo().GetElementCount();
+        float peak = 0.01f;
+        for (size_t i = 0; i < count; ++i) {
+            peak = std::max(peak, std::fabs(samples[i]));
+        }
+        const size_t offset = audio.size();
+        audio.resize(offset + count);
+        pcm::float_to_int16(samples, audio.data() + offset, count, 32767.0f * volume_ / peak);
+    }
+};
+
+} // namespace
+
+// The models.tts.paroli triple is always available under this name
+static const char *const kDefaultVoice = "default";
+
+// One loaded voice, shared by every TTSParoli instance speaking with it. ONNX
+// sessions are safe to run from several threads; the text synthesizer is only
+// called under g_espeak_mutex. Phoneme timings come from Paroli's text
+// synthesizer; plain synthesis goes through the phoneme-ID path when the
+// phoneme cache is on and the model is supported.
+struct ParoliVoice {
+    std::unique_ptr<ParoliSynthesizer> text;
+    std::unique_ptr<PhonemeIdSynthesizer> ids;  // null when unavailable
+};
+
+// Loaded voices for every configured voice, shared by a TTSParoli and its
+// clones (one per synthesis worker). Each voice is loaded once and its
+// sessions are shared by all workers using it. Loads run either on the
+// thread that first needs the voice or in the background (preload()); a
+// thread asking for a voice that is still loading waits for that load
+// instead of starting another. Voices no worker holds are evicted least
+// recently used first once the estimated model memory exceeds the budget.
+class ParoliVoicePool {
+public:
+    struct Voice {
+        std::string encoder;
+        std::string decoder;
+        std::string config;
+        size_t bytes = 0;  // estimated from the model files
+    };
+
+    ParoliVoicePool(std::map<std::string, Voice> voices, size_t budget_bytes, std::string espeak_data_path)
+        : voices_(std::move(voices)), budget_bytes_(budget_bytes), espeak_data_path_(std::move(espeak_data_path)) {}
+
+    bool has_voice(const std::string &name) const { return voices_.count(name) > 0; }
+
+    std::vector<std::string> names() const {
+        std::vector<std::string> names;
+        for (const auto &voice : voices_) {
+            names.push_back(voice.first);
+        }
+        return names;
+    }
+
+    // The loaded voice, waiting for a load in progress or loading it on this
+    // thread; null on failure
+    std::shared_ptr<ParoliVoice> acquire(const std::string &name) {
+        auto pending = start_load(name, std::launch::deferred);
+        if (!pending.valid()) {
+            return nullptr;
+        }
+        auto voice = pending.get();
+        if (!voice) {
+            forget_failed(name);
+        }
+        return voice;
+    }
+
+    // Start loading the voice in the background unless it is loaded or loading
+    void preload(const std::string &name) {
+        start_load(name, std::launch::async);
+    }
+
+    // Preload voices in name order while they fit in the budget next to what
+    // is already loaded
+    void preload_within_budget() {
+        for (const auto &voice : voices_) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (loaded_.count(voice.first) || loaded_bytes_ + voice.second.bytes > budget_bytes_) {
+                    continue;
+                }
+            }
+            preload(voice.first);
+        }
+    }
+
+    // Evict voices no worker holds any more while over the budget
+    void trim() {
+        std::vector<Loading> evicted;
+        std::lock_guard<std::mutex> lock(mutex_);
+        evict_locked(evicted);
+    }
+
+private:
+    using Loading = std::shared_future<std::shared_ptr<ParoliVoice>>;
+
+    const std::map<std::string, Voice> voices_;
+    const size_t budget_bytes_;
+    const std::string espeak_data_path_;
+
+    std::mutex mutex_;
+    std::map<std::string, Loading> loaded_;  // loaded and loading voices
+    std::list<std::string> recent_;          // names in loaded_, most recent first
+    size_t loaded_bytes_ = 0;
+
+    Loading start_load(const std::string &name, std::launch policy) {
+        auto voice = voices_.find(name);
+        if (voice == voices_.end()) {
+            return {};
+        }
+
+        std::vector<Loading> evicted;  // unloaded outside the lock
+        std::lock_guard<std::mutex> lock(mutex_);
+        recent_.remove(name);
+        recent_.push_front(name);
+        auto it = loaded_.find(name);
+        if (it == loaded_.end()) {
+            loaded_bytes_ += voice->second.bytes;
+            evict_locked(evicted);
+            it = loaded_.emplace(name, std::async(policy, [this, voice] {
+                     return load(voice->first, voice->second);
+                 }).share()).first;
+        }
+        return it->second;
+    }
+
+    void forget_failed(const std::string &name) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = loaded_.find(name);
+        if (it != loaded_.end() && IsReady(it->second) && !it->second.get()) {
+            loaded_.erase(it);
+            recent_.remove(name);
+            loaded_bytes_ -= voices_.at(name).bytes;
+        }
+    }
+
+    static bool IsReady(const Loading &loading) {
+        return loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+    }
+
+    void evict_locked(std::vector<Loading> &evicted) {
+        for (auto name = recent_.rbegin(); name != recent_.rend() && loaded_bytes_ > budget_bytes_;) {
+            auto it = loaded_.find(*name);
+            // Loads in progress and voices a worker holds stay
+            if (!IsReady(it->second) || it->second.get().use_count() > 1) {
+                ++name;
+                continue;
+            }
+            std::cout << "Unloading voice " << *name << " (voice memory budget)" << std::endl;
+            loaded_bytes_ -= voices_.at(*name).bytes;
+            evicted.push_back(std::move(it->second));
+            loaded_.erase(it);
+            name = std::make_reverse_iterator(recent_.erase(std::next(name).base()));
+        }
+    }
+
+    std::shared_ptr<ParoliVoice> load(const std::string &name, const Voice &voice) const {
+        const auto start_time = std::chrono::steady_clock::now();
+        auto& config = ConfigManager::getInstance();
+
+        // Load pre-optimized graphs when a cache directory is configured, so
+        // graph optimization runs once instead of on every start
+        std::string encoder_model = voice.encoder;
+        std::string decoder_model = voice.decoder;
+        const std::string optimized_dir = config.getTtsOnnxOptimizedModelDir();
+        if (!optimized_dir.empty()) {
+            const std::string level = config.getTtsOnnxOptimizationLevel();
+            encoder_model = OptimizedModelPath(voice.encoder, level, optimized_dir);
+            decoder_model = OptimizedModelPath(voice.decoder, level, optimized_dir);
+        }
+
+        ParoliSynthesizer::InitOptions opts;
+        opts.encoderPath = encoder_model;
+        opts.decoderPath = decoder_model;
+        opts.modelConfigPath = voice.config;
+        opts.eSpeakDataPath = espeak_data_path_;
+        opts.accelerator = ""; // Use CPU by default
+
+        try {
+            std::unique_ptr<ParoliSynthesizer> synthesizer;
+            {
+                std::lock_guard<std::mutex> lock(g_espeak_mutex);
+                synthesizer = std::make_unique<ParoliSynthesizer>(opts);
+            }
+            if (!synthesizer->isInitialized()) {
+                std::cerr << "Failed to initialize ParoliSynthesizer for voice " << name << ": "
+                          << synthesizer->getLastError() << std::endl;
+                return nullptr;
+            }
+
+            // Set volume to 0.8 (80%)
+            synthesizer->setVolume(0.8f);
+
+            auto loaded = std::make_shared<ParoliVoice>();
+            loaded->text = std::move(synthesizer);
+            if (config.getTtsPhonemeCacheEnabled()) {
+                std::string error;
+                loaded->ids = PhonemeIdSynthesizer::load(encoder_model, decoder_model, voice.config, error);
+                if (loaded->ids) {
+                    loaded->ids->set_volume(0.8f);
+                } else {
+                    std::cerr << "Phoneme-ID synthesis unavailable for voice " << name << " (" << error
+                              << "), synthesizing from text" << std::endl;
+                }
+            }
+
+            std::cout << "Loaded voice " << name << " in "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(
+                             std::chrono::steady_clock::now() - start_time).count()
+                      << " ms\n";
+            return loaded;
+        } catch (const std::exception& e) {
+            std::cerr << "Exception loading voice " << name << ": " << e.what() << std::endl;
+            return nullptr;
+        }
+    }
+};
+
+// Pool holding the base model as the default voice plus every voice
+// configured under models.tts.paroli.voices
+static std::shared_ptr<ParoliVoicePool> CreateVoicePool(const std::string &encoder, const std::string &decoder,
+                                                         const std::string &model_config, const std::string &espeak_data) {
+    auto& config = ConfigManager::getInstance();
+    auto file_bytes = [](const std::string &path) -> size_t {
+        std::error_code ec;
+        const auto size = std::filesystem::file_size(path, ec);
+        return ec ? 0 : static_cast<size_t>(size);
+    };
+
+    // The phoneme-ID path holds a second pair of sessions per loaded voice
+    const size_t sessions = config.getTtsPhonemeCacheEnabled() ? 2 : 1;
+
+    std::map<std::string, ParoliVoicePool::Voice> voices;
+    voices[kDefaultVoice] = {encoder, decoder, model_config, sessions * (file_bytes(encoder) + file_bytes(decoder))};
+    for (const auto &name : config.getTtsVoiceNames()) {
+        ParoliVoicePool::Voice voice;
+        voice.encoder = config.getTtsVoiceModelPath(name, "encoder");
+        voice.decoder = config.getTtsVoiceModelPath(name, "decoder");
+        voice.config = config.getTtsVoiceModelPath(name, "config");
+        if (voice.encoder.empty() || voice.decoder.empty() || voice.config.empty()) {
+            std::cerr << "Skipping voice " << name << ": model files not found" << std::endl;
+            continue;
+        }
+        voice.bytes = sessions * (file_bytes(voice.encoder) + file_bytes(voice.decoder));
+        voices[name] = voice;
+    }
+
+    const size_t budget = static_cast<size_t>(std::max(0, config.getTtsVoiceMemoryBudgetMb())) << 20;
+    return std::make_shared<ParoliVoicePool>(std::move(voices), budget, espeak_data);
+}
+
 TTSParoli::TTSParoli() {
 }
 
@@ -14,6 +683,8 @@ TTSParoli::~TTSParoli() {
 }
 
 bool TTSParoli::init() {
+    const auto start_time = std::chrono::steady_clock::now();
+
     // Initialize from configuration
     auto& config = ConfigManager::getInstance();
     
@@ -49,25 +720,51 @@ bool TTSParoli::init() {
     }
     
     try {
-        // Initialize ParoliSynthesizer
-        ParoliSynthesizer::InitOptions opts;
-        opts.encoderPath = encoder_path;
-        opts.decoderPath = decoder_path;
-        opts.modelConfigPath = config_path;
-        opts.eSpeakDataPath = espeak_data_path;
-        opts.accelerator = ""; // Use CPU by default
-        
-        synthesizer = std::make_unique<ParoliSynthesizer>(opts);
-        
-        if (!synthesizer->isInitialized()) {
-            std::cerr << "Failed to initialize ParoliSynthesizer: " << synthesizer->getLastError() << std::endl;
+        // Clones arrive with the pool, voice and cache of the instance they
+        // were made from
+        if (!pool) {
+            pool = CreateVoicePool(encoder_path, decoder_path, config_path, espeak_data_path);
+            voice_name = config.getTtsDefaultVoice();
+            if (!pool->has_voice(voice_name)) {
+                std::cerr << "Unknown default voice " << voice_name << ", using the default model" << std::endl;
+                voice_name = kDefaultVoice;
+            }
+        }
+
+        synthesizer = pool->acquire(voice_name);
+        if (!synthesizer) {
             return false;
         }
+        if (config.getTtsVoicesPreload()) {
+            // Other voices load off the synthesis path, so switching to them
+            // later does not stall speech
+            pool->preload_within_budget();
+        }
+
+        if (!cache && config.getTtsCacheEnabled()) {
+            TTSAudioCache::Options cache_opts;
+            cache_opts.memory_bytes = static_cast<size_t>(std::max(0, config.getTtsCacheMemoryMb())) << 20;
+            cache_opts.max_text_chars = static_cast<size_t>(std::max(0, config.getTtsCacheMaxTextChars()));
+            cache_opts.disk_path = config.getTtsCacheDiskPath();
+            cache_opts.disk_bytes = static_cast<size_t>(std::max(0, config.getTtsCacheDiskMb())) << 20;
+            std::vector<std::string> model_files = {encoder_path, decoder_path, config_path};
+            for (const auto &name : config.getTtsVoiceNames()) {
+                for (const char *component : {"encoder", "decoder", "config"}) {
+                    model_files.push_back(config.getTtsVoiceModelPath(name, component));
+                }
+            }
+            cache = std::make_shared<TTSAudioCache>(cache_opts, TTSAudioCache::fingerprint_files(model_files));
+        }
+
+        if (!phoneme_cache && config.getTtsPhonemeCacheEnabled()) {
+            phoneme_cache = std::make_shared<PhonemeCache>(
+                static_cast<size_t>(std::max(0, config.getTtsPhonemeCacheMemoryKb())) << 10);
+        }
         
-        // Set volume to 0.8 (80%)
-        synthesizer->setVolume(0.8f);
-        
-        std::cout << "TTS (Paroli) initialized\n";
+        std::cout << "TTS (Paroli) initialized in "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(
+                         std::chrono::steady_clock::now() - start_time).count()
+                  << " ms\n";
         return true;
         
     } catch (const std::exception& e) {
@@ -76,6 +773,123 @@ bool TTSParoli::init() {
     }
 }
 
+bool TTSParoli::set_voice(const std::string &voice) {
+    if (voice.empty() || voice == voice_name) {
+        return true;
+    }
+    if (!pool || !pool->has_voice(voice)) {
+        std::cerr << "Unknown voice: " << voice << std::endl;
+        return false;
+    }
+
+    const auto start_time = std::chrono::steady_clock::now();
+    auto next = pool->acquire(voice);
+    if (!next) {
+        return false;
+    }
+    synthesizer = std::move(next);
+    voice_name = voice;
+    pool->trim();
+
+    std::cout << "Switched to voice " << voice << " in "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count()
+              << " ms\n";
+    return true;
+}
+
+void TTSParoli::preload_voice(const std::string &voice) {
+    if (pool && pool->has_voice(voice)) {
+        pool->preload(voice);
+    }
+}
+
+std::vector<std::string> TTSParoli::voices() const {
+    return pool ? pool->names() : std::vector<std::string>{};
+}
+
+bool TTSParoli::synthesize(const std::string &text, bool with_phoneme_timings, TTSCacheEntry& out) {
+#ifdef ENABLE_STATS_LOGGING
+    const auto start_time = std::chrono::steady_clock::now();
+    auto record = [&](SynthesisStats& stats) {
+        stats.calls++;
+        stats.chars += text.size();
+        stats.audio_seconds += out.sample_rate ? static_cast<double>(out.audio.size()) / out.sample_rate : 0.0;
+        stats.total_ms += std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start_time).count();
+    };
+#endif
+
+    // Voices share the cache, so anything but the default model is keyed by name
+    std::string key;
+    if (cache) {
+        key = TTSAudioCache::normalize(text);
+        if (voice_name != kDefaultVoice) {
+            key = voice_name + '\x1f' + key;
+        }
+    }
+    if (cache && cache->lookup(key, with_phoneme_timings, out)) {
+#ifdef ENABLE_STATS_LOGGING
+        record(cached_stats);
+#endif
+        return true;
+    }
+
+    out.sample_rate = synthesizer->text->nativeSampleRate();
+    out.phoneme_timings.clear();
+    out.audio.clear();
+#ifdef ENABLE_STATS_LOGGING
+    SynthesisStats* stats = &synthesized_stats;
+#endif
+    if (!with_phoneme_timings && synthesizer->ids) {
+        // Phonemize (serving recurring words from the phoneme cache), then
+        // run only the encoder/decoder
+        try {
+            const std::string key_prefix = voice_name + '\x1f';
+            out.audio = synthesizer->ids->synthesize(
+                synthesizer->ids->phonemize(text, key_prefix, phoneme_cache.get()));
+        } catch (const std::exception& e) {
+            std::cerr << "Phoneme-ID synthesis failed, synthesizing from text: " << e.what() << std::endl;
+            out.audio.clear();
+        }
+#ifdef ENABLE_STATS_LOGGING
+        if (!out.audio.empty()) {
+            stats = &phoneme_id_stats;
+        }
+#endif
+    }
+
+    if (!out.audio.empty()) {
+        // Already synthesized from phoneme IDs
+    } else if (with_phoneme_timings) {
+        std::lock_guard<std::mutex> lock(g_espeak_mutex);
+        auto result = synthesizer->text->synthesizePcmWithTiming(text);
+        out.audio = std::move(result.audio);
+        out.phoneme_timings.reserve(result.phoneme_timings.size());
+        for (const auto& piper_phoneme : result.phoneme_timings) {
+            PhonemeTimingInfo our_phoneme;
+            our_phoneme.phoneme_id = piper_phoneme.phoneme_id;
+            our_phoneme.duration_seconds = piper_phoneme.duration_seconds;
+            out.phoneme_timings.push_back(our_phoneme);
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(g_espeak_mutex);
+        out.audio = synthesizer->text->synthesizePcm(text);
+    }
+
+    if (out.audio.empty()) {
+        std::cerr << "Failed to generate audio for text: " << text << std::endl;
+        return false;
+    }
+
+    if (cache) {
+        cache->insert(key, out);
+    }
+#ifdef ENABLE_STATS_LOGGING
+    record(*stats);
+#endif
+    return true;
+}
+
 bool TTSParoli::speak(const std::string &text, async_pipeline::AudioChunkMessage& audio_chunk) {
     if (!synthesizer) {
         std::cerr << "TTS not initialized" << std::endl;
@@ -88,16 +902,14 @@ bool TTSParoli::speak(const std::string &text, async_pipeline::AudioChunkMessage
 
     try {
         // Generate complete audio for the text
-        std::vector<int16_t> audio_data = synthesizer->synthesizePcm(text);
-        
-        if (audio_data.empty()) {
-            std::cerr << "Failed to generate audio for text: " << text << std::endl;
+        TTSCacheEntry result;
+        if (!synthesize(text, false, result)) {
             return false;
         }
         
         // Write audio data to the provided AudioChunkMessage
-        audio_chunk.audio_data = std::move(audio_data);
-        audio_chunk.sample_rate = synthesizer->nativeSampleRate();
+        audio_chunk.audio_data = std::move(result.audio);
+        audio_chunk.sample_rate = result.sample_rate;
         
         return true;
         
@@ -119,26 +931,17 @@ bool TTSParoli::speakWithPhonemeTimings(const std::string &text, async_pipeline:
 
     try {
         // Generate complete audio for the text with timing information
-        auto result = synthesizer->synthesizePcmWithTiming(text);
-        
-        if (result.audio.empty()) {
-            std::cerr << "Failed to generate audio for text: " << text << std::endl;
+        TTSCacheEntry result;
+        if (!synthesize(text, true, result)) {
             return false;
         }
         
         // Copy phoneme timing information
-        phoneme_timings.clear();
-        phoneme_timings.reserve(result.phoneme_timings.size());
-        for (const auto& piper_phoneme : result.phoneme_timings) {
-            PhonemeTimingInfo our_phoneme;
-            our_phoneme.phoneme_id = piper_phoneme.phoneme_id;
-            our_phoneme.duration_seconds = piper_phoneme.duration_seconds;
-            phoneme_timings.push_back(our_phoneme);
-        }
+        phoneme_timings = std::move(result.phoneme_timings);
         
         // Write audio data to the provided AudioChunkMessage
         audio_chunk.audio_data = std::move(result.audio);
-        audio_chunk.sample_rate = synthesizer->nativeSampleRate();
+        audio_chunk.sample_rate = result.sample_rate;
         
         return true;
         
@@ -148,9 +951,104 @@ bool TTSParoli::speakWithPhonemeTimings(const std::string &text, async_pipeline:
     }
 }
 
+bool TTSParoli::speak_stream(const std::string &text, const TTSChunkCallback& on_audio_chunk, const TTSCancelCallback& cancel, bool with_phoneme_timings) {
+    if (!synthesizer) {
+        std::cerr << "TTS not initialized" << std::endl;
+        return false;
+    }
+
+    if (text.empty() || !on_audio_chunk) {
+        return true;
+    }
+
+    // ParoliSynthesizer only exposes whole-utterance synthesis, so stream at
+    // phrase granularity: the first phrase plays while the rest is generated.
+    const std::vector<std::string> phrases = SplitPhrases(text);
+
+    try {
+        for (size_t i = 0; i < phrases.size(); ++i) {
+            if (cancel && cancel()) {
+                return true;
+            }
+
+            TTSCacheEntry result;
+            if (!synthesize(phrases[i], with_phoneme_timings, result)) {
+                return false;
+            }
+
+            TTSStreamChunk chunk;
+            chunk.audio = std::move(result.audio);
+            chunk.sample_rate = result.sample_rate;
+            chunk.phoneme_timings = std::move(result.phoneme_timings);
+            chunk.last = (i + 1 == phrases.size());
+
+            if (!on_audio_chunk(chunk)) {
+                return true;
+            }
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        std::cerr << "TTS synthesis error: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::unique_ptr<ITTS> TTSParoli::clone() const {
+    // Instances share the voice pool and with it every loaded voice's ONNX
+    // sessions; init() reads the same config. The audio cache is shared so
+    // every worker benefits from its hits.
+    auto copy = std::make_unique<TTSParoli>();
+    copy->pool = pool;
+    copy->voice_name = voice_name;
+    copy->cache = cache;
+    copy->phoneme_cache = phoneme_cache;
+    return copy;
+}
+
+unsigned int TTSParoli::sample_rate() const {
+    return synthesizer ? static_cast<unsigned int>(synthesizer->text->nativeSampleRate()) : 0;
+}
+
 void TTSParoli::shutdown() {
     if (!synthesizer) {
         return; // Already shut down
     }    
     synthesizer.reset();
+    if (pool) {
+        pool->trim();
+    }
+
+#ifdef ENABLE_STATS_LOGGING
+    auto print_latency = [](const char* label, const SynthesisStats& stats) {
+        if (stats.calls == 0) {
+            return;
+        }
+        std::cout << "TTS " << label << ": " << stats.calls << " calls, "
+                  << stats.total_ms / stats.calls << " ms avg, "
+                  << stats.total_ms / std::max<uint64_t>(1, stats.chars) << " ms/char, RTF "
+                  << (stats.audio_seconds > 0.0 ? stats.total_ms / 1000.0 / stats.audio_seconds : 0.0)
+                  << std::endl;
+    };
+    print_latency("synthesized", synthesized_stats);
+    print_latency("synthesized from phoneme IDs", phoneme_id_stats);
+    print_latency("cached", cached_stats);
+
+    if (phoneme_cache && phoneme_cache.use_count() == 1) {
+        const auto stats = phoneme_cache->stats();
+        std::cout << "TTS phoneme cache: " << stats.hits << " word hits, " << stats.misses
+                  << " misses, hit rate " << 100.0 * stats.hit_rate() << "%, " << stats.entries
+                  << " words, " << (stats.memory_used >> 10) << " KiB" << std::endl;
+    }
+
+    if (cache && cache.use_count() == 1) {
+        const auto stats = cache->stats();
+        std::cout << "TTS cache: " << stats.hits << " hits (" << stats.disk_hits << " from disk), "
+                  << stats.misses << " misses, hit rate " << 100.0 * stats.hit_rate() << "%, "
+                  << stats.entries << " entries, " << (stats.memory_used >> 10) << " KiB; disk "
+                  << stats.disk_files << " files, " << (stats.disk_used >> 10) << " KiB" << std::endl;
+    }
+#endif
+    cache.reset();
+    phoneme_cache.reset();
 }
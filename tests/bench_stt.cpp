@@ -0,0 +1,401 @@
+// SherpaSTT fed from WAV files through add_source()/accept_audio(), one
+// source per file, paced at real time with the microphone disabled. Results
+// must come back tagged with the source they were spoken on. Reports the
+// latency from the end of each file's audio to its final result, and the word
+// error rate against reference transcripts.
+//
+// Then throughput against the number of concurrent streams: N sources, each
+// given the files in turn, are fed as fast as accept_audio() takes them, and
+// the audio seconds recognized per wall-clock second (and its inverse, the
+// real-time factor) are reported for each N.
+//
+// Usage: bench_stt [--config models.json] [--streams N] [file.wav ...]
+// --streams measures only N streams; by default N sweeps from 1 to
+// settings.stt.max_streams - 1 (slot 0 is the microphone's).
+// Without files, the test_wavs/ directory next to the sherpa encoder is used.
+// The reference for x.wav is x.txt, or its line in trans.txt beside it
+// ("x.wav TEXT", "x TEXT", or line N for N.wav). Exits 77 (skipped) when no
+// sherpa model or WAV file is available.
+
+#include "config_manager.h"
+#include "resampler.h"
+#include "stt_sherpa.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int k_skip        = 77;
+constexpr int k_model_rate  = 16000;
+constexpr int k_chunk       = k_model_rate / 50;   // 20 ms per accept_audio()
+constexpr int k_trailing_ms = 1500;                // silence to close the last segment
+constexpr int k_settle_ms   = 2000;                // no new result for this long ends a throughput run
+
+using Clock = std::chrono::steady_clock;
+
+struct Input {
+    std::string path;
+    std::string reference;       // empty when none was found
+    std::vector<float> samples;  // mono, model rate, trailing silence appended
+    size_t audio_samples = 0;    // samples from the file
+    int source_id = -1;
+    Clock::time_point audio_end; // when the last sample from the file was fed
+};
+
+struct Output {
+    std::string text;
+    Clock::time_point last_result;
+};
+
+// Upper-case words with punctuation other than apostrophes removed
+std::vector<std::string> normalized_words(const std::string & text) {
+    std::string clean;
+    for (unsigned char c : text) {
+        clean += std::isalnum(c) || c == '\'' ? static_cast<char>(std::toupper(c)) : ' ';
+    }
+    std::istringstream in(clean);
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Word-level edit distance: substitutions + deletions + insertions
+size_t word_errors(const std::vector<std::string> & ref, const std::vector<std::string> & hyp) {
+    std::vector<size_t> prev(hyp.size() + 1), cur(hyp.size() + 1);
+    for (size_t j = 0; j <= hyp.size(); ++j) {
+        prev[j] = j;
+    }
+    for (size_t i = 1; i <= ref.size(); ++i) {
+        cur[0] = i;
+        for (size_t j = 1; j <= hyp.size(); ++j) {
+            cur[j] = std::min({prev[j] + 1, cur[j - 1] + 1, prev[j - 1] + (ref[i - 1] != hyp[j - 1])});
+        }
+        std::swap(prev, cur);
+    }
+    return prev[hyp.size()];
+}
+
+std::string find_reference(const std::filesystem::path & wav) {
+    auto txt = wav;
+    txt.replace_extension(".txt");
+    std::ifstream in(txt);
+    if (in) {
+        std::stringstream text;
+        text << in.rdbuf();
+        return text.str();
+    }
+
+    std::ifstream trans(wav.parent_path() / "trans.txt");
+    const std::string name = wav.filename().string();
+    const std::string stem = wav.stem().string();
+    const bool numbered = !stem.empty() && std::all_of(stem.begin(), stem.end(), ::isdigit);
+    std::string line;
+    for (size_t n = 0; std::getline(trans, line); ++n) {
+        const auto space = line.find(' ');
+        const std::string first = line.substr(0, space);
+        if (first == name || first == stem) {
+            return space == std::string::npos ? "" : line.substr(space + 1);
+        }
+        if (numbered && n == std::stoul(stem)) {
+            return line;
+        }
+    }
+    return "";
+}
+
+bool load(Input & input) {
+    auto wave = sherpa_onnx::cxx::ReadWave(input.path);
+    if (wave.samples.empty()) {
+        printf("cannot read %s\n", input.path.c_str());
+        return false;
+    }
+    if (wave.sample_rate == k_model_rate) {
+        input.samples = std::move(wave.samples);
+    } else {
+        PolyphaseResampler resampler;
+        if (!resampler.init(wave.sample_rate, k_model_rate)) {
+            printf("cannot resample %s from %d Hz\n", input.path.c_str(), wave.sample_rate);
+            return false;
+        }
+        resampler.process(wave.samples.data(), wave.samples.size(), input.samples);
+    }
+    input.audio_samples = input.samples.size();
+    input.samples.resize(input.samples.size() + k_model_rate * k_trailing_ms / 1000, 0.0f);
+    return true;
+}
+
+struct Throughput {
+    double audio_seconds = 0.0;
+    double wall_seconds = 0.0;
+    bool complete = false;  // every source produced a result
+};
+
+// N sources, source i fed inputs[i % size] without pacing. The run ends once
+// every source has a result and none has arrived for k_settle_ms; wall time
+// runs from the first sample fed to the last result.
+Throughput measure_throughput(SherpaSTT & stt, const std::vector<Input> & inputs, int n_streams) {
+    std::mutex mutex;
+    std::map<int, Clock::time_point> last_result;
+    stt.set_source_result_callback([&](int source_id, const std::string &) {
+        std::lock_guard<std::mutex> lock(mutex);
+        last_result[source_id] = Clock::now();
+    });
+
+    Throughput result;
+    std::vector<int> source_ids;
+    for (int i = 0; i < n_streams; ++i) {
+        const int id = stt.add_source();
+        if (id < 0) {
+            break;
+        }
+        source_ids.push_back(id);
+    }
+    if (static_cast<int>(source_ids.size()) == n_streams && stt.start_streaming([](const std::string &) {})) {
+        const auto start = Clock::now();
+        for (size_t offset = 0;; offset += k_chunk) {
+            bool fed = false;
+            for (size_t i = 0; i < source_ids.size(); ++i) {
+                const auto & samples = inputs[i % inputs.size()].samples;
+                if (offset < samples.size()) {
+                    stt.accept_audio(source_ids[i], samples.data() + offset,
+                                     std::min<size_t>(k_chunk, samples.size() - offset));
+                    fed = true;
+                }
+            }
+            if (!fed) {
+                break;
+            }
+        }
+        for (size_t i = 0; i < source_ids.size(); ++i) {
+            result.audio_seconds += static_cast<double>(inputs[i % inputs.size()].samples.size()) / k_model_rate;
+        }
+
+        const auto deadline = start + std::chrono::duration<double>(2.0 * result.audio_seconds + 30.0);
+        while (Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            std::lock_guard<std::mutex> lock(mutex);
+            Clock::time_point newest = start;
+            for (const auto & kv : last_result) {
+                newest = std::max(newest, kv.second);
+            }
+            result.complete = last_result.size() == source_ids.size();
+            if (result.complete && Clock::now() - newest > std::chrono::milliseconds(k_settle_ms)) {
+                result.wall_seconds = std::chrono::duration<double>(newest - start).count();
+                break;
+            }
+        }
+        stt.stop_streaming();
+    }
+    for (int id : source_ids) {
+        stt.remove_source(id);
+    }
+    stt.set_source_result_callback(nullptr);
+    return result;
+}
+
+std::vector<std::string> default_wavs() {
+    std::vector<std::string> paths;
+    auto & config = ConfigManager::getInstance();
+    if (!config.hasNestedModelPath("stt", "sherpa", "encoder")) {
+        return paths;
+    }
+    const auto dir = std::filesystem::path(config.getNestedModelPath("stt", "sherpa", "encoder"))
+                         .parent_path() / "test_wavs";
+    std::error_code ec;
+    for (const auto & entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".wav") {
+            paths.push_back(entry.path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+} // namespace
+
+int main(int argc, char ** argv) {
+    std::string config_path = LOCAL_LLM_CONFIG;
+    std::vector<std::string> paths;
+    int streams = 0;  // 0 sweeps every stream count the config allows
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if ((arg == "--config" || arg == "-c") && i + 1 < argc) {
+            config_path = argv[++i];
+        } else if (arg == "--streams" && i + 1 < argc) {
+            streams = std::max(1, std::atoi(argv[++i]));
+        } else {
+            paths.push_back(arg);
+        }
+    }
+
+    auto & config = ConfigManager::getInstance();
+    if (!config.loadConfig(config_path) || !config.hasNestedModelPath("stt", "sherpa", "encoder")) {
+        printf("SKIP no sherpa model configured in %s\n", config_path.c_str());
+        return k_skip;
+    }
+    if (paths.empty()) {
+        paths = default_wavs();
+    }
+    if (paths.empty()) {
+        printf("SKIP no WAV files given and no test_wavs/ next to the model\n");
+        return k_skip;
+    }
+
+    std::vector<Input> inputs(paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        inputs[i].path = paths[i];
+        inputs[i].reference = find_reference(paths[i]);
+        if (!load(inputs[i])) {
+            return 1;
+        }
+    }
+
+    SherpaSTT stt;
+    if (!stt.init()) {
+        printf("FAIL SherpaSTT init\n");
+        return 1;
+    }
+
+    std::mutex mutex;
+    std::map<int, Output> outputs;
+    size_t stray_results = 0;
+    stt.set_microphone_enabled(false);
+    stt.set_source_result_callback([&](int source_id, const std::string & text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto & output = outputs[source_id];
+        output.text += (output.text.empty() ? "" : " ") + text;
+        output.last_result = Clock::now();
+    });
+
+    for (auto & input : inputs) {
+        input.source_id = stt.add_source();
+        if (input.source_id < 0) {
+            printf("FAIL %zu files need settings.stt.max_streams >= %zu\n", inputs.size(), inputs.size() + 1);
+            return 1;
+        }
+    }
+
+    // Audio is refused until streaming starts
+    const std::vector<float> probe(k_chunk, 0.0f);
+    if (stt.accept_audio(inputs[0].source_id, probe.data(), probe.size())) {
+        printf("FAIL audio accepted before start_streaming()\n");
+        return 1;
+    }
+
+    if (!stt.start_streaming([&](const std::string &) {
+            std::lock_guard<std::mutex> lock(mutex);
+            ++stray_results;
+        })) {
+        printf("FAIL start_streaming\n");
+        return 1;
+    }
+
+    // All sources advance together, one 20 ms chunk each per tick
+    size_t longest = 0;
+    for (const auto & input : inputs) {
+        longest = std::max(longest, input.samples.size());
+    }
+    const auto start = Clock::now();
+    for (size_t offset = 0; offset < longest; offset += k_chunk) {
+        for (auto & input : inputs) {
+            if (offset < input.samples.size()) {
+                const size_t n = std::min<size_t>(k_chunk, input.samples.size() - offset);
+                stt.accept_audio(input.source_id, input.samples.data() + offset, n);
+                if (offset < input.audio_samples && offset + n >= input.audio_samples) {
+                    input.audio_end = Clock::now();
+                }
+            }
+        }
+        std::this_thread::sleep_until(start + std::chrono::milliseconds(1000 * (offset + k_chunk) / k_model_rate));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    stt.stop_streaming();
+
+    if (stt.accept_audio(inputs[0].source_id, probe.data(), probe.size())) {
+        printf("FAIL audio accepted after stop_streaming()\n");
+        return 1;
+    }
+    for (const auto & input : inputs) {
+        stt.remove_source(input.source_id);
+    }
+
+    bool ok = stray_results == 0;
+    size_t errors = 0, reference_words = 0;
+    std::vector<double> latencies;
+    for (const auto & input : inputs) {
+        const auto it = outputs.find(input.source_id);
+        const Output output = it != outputs.end() ? it->second : Output{};
+        printf("[%d] %s: '%s'\n", input.source_id,
+               std::filesystem::path(input.path).filename().c_str(), output.text.c_str());
+        ok &= !output.text.empty();
+
+        if (!output.text.empty()) {
+            // Includes the VAD's closing silence (settings.stt.vad.min_silence_duration)
+            const double latency_ms =
+                std::chrono::duration<double, std::milli>(output.last_result - input.audio_end).count();
+            latencies.push_back(latency_ms);
+            printf("    end of audio -> final result %.0f ms\n", latency_ms);
+        }
+        if (!input.reference.empty()) {
+            const auto ref = normalized_words(input.reference);
+            const size_t e = word_errors(ref, normalized_words(output.text));
+            errors += e;
+            reference_words += ref.size();
+            printf("    WER %.1f%% (%zu/%zu)\n", ref.empty() ? 0.0 : 100.0 * e / ref.size(), e, ref.size());
+        }
+    }
+
+    if (!latencies.empty()) {
+        std::sort(latencies.begin(), latencies.end());
+        printf("latency: median %.0f ms, max %.0f ms over %zu files\n",
+               latencies[latencies.size() / 2], latencies.back(), latencies.size());
+    }
+    if (reference_words) {
+        printf("WER: %.2f%% (%zu errors / %zu words)\n", 100.0 * errors / reference_words, errors, reference_words);
+    }
+    for (const auto & kv : outputs) {
+        if (std::none_of(inputs.begin(), inputs.end(), [&](const Input & in) { return in.source_id == kv.first; })) {
+            printf("FAIL result for unregistered source %d\n", kv.first);
+            ok = false;
+        }
+    }
+    if (stray_results) {
+        printf("FAIL %zu source results reached the streaming callback\n", stray_results);
+    }
+
+    const int max_sources = std::max(1, config.getSttMaxStreams()) - 1;
+    const int first = streams ? streams : 1;
+    const int last = streams ? streams : max_sources;
+    printf("throughput (unpaced, %zu files round-robin per stream):\n", inputs.size());
+    if (last < first) {
+        printf("  no stream count to sweep; raise settings.stt.max_streams\n");
+    }
+    for (int n = first; n <= last; ++n) {
+        const Throughput t = measure_throughput(stt, inputs, n);
+        if (!t.complete || t.wall_seconds <= 0.0) {
+            printf("FAIL %d streams: %s\n", n,
+                   n > max_sources ? "more than settings.stt.max_streams - 1" : "not every stream produced a result");
+            ok = false;
+            continue;
+        }
+        printf("  N=%-3d %7.1f s audio in %6.2f s: %6.1f audio-s per wall-s, RTF %.3f\n",
+               n, t.audio_seconds, t.wall_seconds, t.audio_seconds / t.wall_seconds,
+               t.wall_seconds / t.audio_seconds);
+    }
+    stt.shutdown();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+// LLM-style responses streamed in 1-4 word chunks through TextSegmenter and
+// TextNormalizer, as TextNormalizerProcessor runs them. Reports segments/s
+// and TTS synthesis calls per response with and without re-segmentation
+// (without it, every LLM chunk is one call), and checks that segmentation
+// neither drops nor reorders text.
+
+#include "text_normalizer.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int k_rounds = 200;
+
+const char * const k_responses[] = {
+    "Sure! The meeting is on 2024-03-05 at 9:30 am in room 4B. Bring about 1/2 of the printed slides, "
+    "and call 555-1234 if you are running late.",
+    "To make the dough, mix 2 1/2 cups of flour with 3/4 cup of water and 1.5 teaspoons of salt. "
+    "Knead it for 10 min, then let it rest for 1 hour at 24 degrees.",
+    "The **first** step is to update to Version 2.1.3, which fixes 1,234 reported issues. "
+    "Prices start at $3.50 per seat, or 50% off for teams of 10-20 people.",
+    "In the 1990s, dial-up modems ran at 56 kbps. By 2010, most homes had broadband; today a 5 GB "
+    "download takes a few seconds on a 1 Gbps line.",
+    "Dr. Smith said the results were clear: 3 of the 4 samples passed, the 21st failed, and the rest "
+    "are pending until 10/15/2024. See No. 5 in the appendix for details.",
+};
+
+std::vector<std::string> split_words(const std::string & text) {
+    std::istringstream in(text);
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// The response as a token stream would deliver it: 1-4 words per chunk
+std::vector<std::string> stream_chunks(const std::string & text, std::mt19937 & rng) {
+    const auto words = split_words(text);
+    std::vector<std::string> chunks;
+    for (size_t i = 0; i < words.size();) {
+        std::string chunk;
+        for (size_t n = 1 + rng() % 4; n > 0 && i < words.size(); --n, ++i) {
+            chunk += words[i] + " ";
+        }
+        chunks.push_back(chunk);
+    }
+    return chunks;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    std::vector<std::vector<std::string>> streams;
+    size_t chunk_count = 0;
+    for (const char * response : k_responses) {
+        streams.push_back(stream_chunks(response, rng));
+        chunk_count += streams.back().size();
+    }
+
+    // Segments must carry the response's words in order
+    bool ok = true;
+    size_t segment_count = 0;
+    for (size_t r = 0; r < streams.size(); ++r) {
+        TextSegmenter segmenter;
+        std::string joined;
+        for (const auto & chunk : streams[r]) {
+            for (const auto & segment : segmenter.push(chunk)) {
+                joined += segment + " ";
+                ++segment_count;
+            }
+        }
+        const std::string rest = segmenter.flush();
+        if (!rest.empty()) {
+            joined += rest;
+            ++segment_count;
+        }
+        if (split_words(joined) != split_words(k_responses[r])) {
+            printf("FAIL response %zu was not segmented losslessly: '%s'\n", r, joined.c_str());
+            ok = false;
+        }
+    }
+
+    size_t segments = 0, out_chars = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < k_rounds; ++round) {
+        for (const auto & stream : streams) {
+            TextSegmenter segmenter;
+            for (const auto & chunk : stream) {
+                for (const auto & segment : segmenter.push(chunk)) {
+                    out_chars += TextNormalizer::normalize(segment).size();
+                    ++segments;
+                }
+            }
+            out_chars += TextNormalizer::normalize(segmenter.flush()).size();
+            ++segments;
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const double responses = static_cast<double>(streams.size());
+    printf("segment + normalize: %.0f segments/s (%zu segments, %zu chars out, %.1f ms)\n",
+           segments / seconds, segments, out_chars, seconds * 1000.0);
+    printf("synth calls per response: %.1f one per LLM chunk, %.1f re-segmented\n",
+           chunk_count / responses, segment_count / responses);
+    return ok ? 0 : 1;
+}
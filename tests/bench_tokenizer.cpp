@@ -0,0 +1,101 @@
+// gpt_tokenize against the original regex split and substr longest-match
+// scan: both must produce the same tokens, and tokens/s is reported for each.
+
+#include "common.h"
+
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <regex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// The tokenizer as it was before the trie: std::regex word split, then
+// longest match by trying every substring from the longest down
+std::vector<gpt_vocab::id> reference_tokenize(const gpt_vocab & vocab, std::string str) {
+    static const std::regex re(R"('s|'t|'re|'ve|'m|'ll|'d| ?[[:alpha:]]+| ?[[:digit:]]+| ?[^\s[:alpha:][:digit:]]+|\s+(?!\S)|\s+)");
+
+    std::vector<std::string> words;
+    std::smatch m;
+    while (std::regex_search(str, m, re)) {
+        words.push_back(m[0]);
+        str = m.suffix();
+    }
+
+    std::vector<gpt_vocab::id> tokens;
+    for (const auto & word : words) {
+        for (int i = 0; i < (int) word.size(); ) {
+            for (int j = word.size() - 1; j >= i; j--) {
+                auto it = vocab.token_to_id.find(word.substr(i, j - i + 1));
+                if (it != vocab.token_to_id.end()) {
+                    tokens.push_back(it->second);
+                    i = j + 1;
+                    break;
+                } else if (j == i) {
+                    i++;  // unknown byte
+                }
+            }
+        }
+    }
+    return tokens;
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(42);
+    const char letters[] = "etaoinshrdlucmfwypvbgkjqxz";
+    const char * const separators[] = {" ", " ", " ", ", ", ". ", "\n", "  ", "'s ", "'ll ", " 42 ", " - ", "\t"};
+
+    // Text shaped like LLM output: words, numbers, punctuation, contractions
+    std::string text;
+    while (text.size() < (1u << 20)) {
+        const int len = 1 + rng() % 9;
+        for (int i = 0; i < len; ++i) {
+            text += letters[std::min<size_t>(rng() % 26, rng() % 26)];  // skewed to common letters
+        }
+        text += separators[rng() % (sizeof(separators) / sizeof(separators[0]))];
+    }
+
+    // Vocabulary of every single byte plus frequent substrings, with and
+    // without the leading space GPT-2 folds into words
+    gpt_vocab vocab;
+    int32_t next_id = 0;
+    for (int c = 1; c < 128; ++c) {
+        vocab.token_to_id[std::string(1, static_cast<char>(c))] = next_id++;
+    }
+    for (size_t i = 0; vocab.token_to_id.size() < 50000 && i + 8 < text.size(); i += 3) {
+        const std::string token = text.substr(i, 2 + rng() % 7);
+        if (vocab.token_to_id.emplace(token, next_id).second) {
+            ++next_id;
+        }
+    }
+    for (const auto & kv : vocab.token_to_id) {
+        vocab.id_to_token[kv.second] = kv.first;
+    }
+
+    const auto build_start = std::chrono::steady_clock::now();
+    vocab.build_trie();
+    const double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_start).count();
+
+    auto time = [](auto fn) {
+        const auto start = std::chrono::steady_clock::now();
+        auto result = fn();
+        return std::make_pair(std::move(result), std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    };
+    const auto [tokens, seconds] = time([&] { return gpt_tokenize(vocab, text); });
+    const auto [expected, ref_seconds] = time([&] { return reference_tokenize(vocab, text); });
+
+    printf("vocab %zu tokens, trie built in %.1f ms\n", vocab.token_to_id.size(), build_ms);
+    printf("gpt_tokenize  %9.0f tokens/s  (%zu tokens from %zu KiB in %.1f ms)\n",
+           tokens.size() / seconds, tokens.size(), text.size() >> 10, seconds * 1e3);
+    printf("reference     %9.0f tokens/s  (%.1f ms)\n", expected.size() / ref_seconds, ref_seconds * 1e3);
+
+    if (tokens != expected) {
+        printf("FAIL tokens differ from the reference tokenizer\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,158 @@
+// Vocabulary load time: encoder.json parse (and, with a cache directory, the
+// binary copy written there), the cached binary load, a bare mmap open and
+// the first gpt_tokenize on the binary vocab, which builds its trie. Lookups
+// and tokens are checked to agree between the JSON and binary vocabularies,
+// and loading without a cache directory must not write anything.
+
+#include "common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char k_json_path[]      = "bench_vocab_load.json";
+const char k_cache_dir[]      = "bench_vocab_cache";
+const char k_truncated_path[] = "bench_vocab_load_truncated.bin";
+const size_t k_vocab_size     = 50257;  // GPT-2
+
+template <typename Fn>
+double time_ms(Fn && fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(7);
+    const char chars[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,!?-'";
+    const size_t n_chars = sizeof(chars) - 1;
+
+    // GPT-2 sized encoder.json of printable tokens in random id order
+    std::set<std::string> unique;
+    for (int c = 32; c < 127; ++c) {
+        if (c != '"' && c != '\\') {
+            unique.insert(std::string(1, static_cast<char>(c)));
+        }
+    }
+    while (unique.size() < k_vocab_size) {
+        std::string token;
+        for (int i = 0, len = 2 + rng() % 9; i < len; ++i) {
+            token += chars[rng() % n_chars];
+        }
+        unique.insert(token);
+    }
+    std::vector<std::string> tokens(unique.begin(), unique.end());
+    std::shuffle(tokens.begin(), tokens.end(), rng);
+
+    std::filesystem::remove_all(k_cache_dir);
+    std::remove((std::string(k_json_path) + ".bin").c_str());
+    {
+        std::ofstream json(k_json_path);
+        json << "{";
+        for (size_t i = 0; i < tokens.size(); ++i) {
+            json << (i ? ", " : "") << "\"" << tokens[i] << "\": " << i;
+        }
+        json << "}";
+    }
+
+    gpt_vocab from_json, from_json_cached, from_cache, from_bin;
+    bool ok = true;
+    const double json_ms  = time_ms([&] { ok &= gpt_vocab_init(k_json_path, from_json); });
+    const bool wrote_without_cache_dir = std::filesystem::exists(std::string(k_json_path) + ".bin");
+    const double write_ms = time_ms([&] { ok &= gpt_vocab_init(k_json_path, from_json_cached, k_cache_dir); });
+    const double cache_ms = time_ms([&] { ok &= gpt_vocab_init(k_json_path, from_cache, k_cache_dir); });
+
+    std::string bin_path;
+    for (const auto & entry : std::filesystem::directory_iterator(k_cache_dir)) {
+        bin_path = entry.path().string();
+    }
+    const double bin_ms   = time_ms([&] { ok &= gpt_vocab_init(bin_path, from_bin); });
+    const double mmap_ms  = time_ms([&] { gpt_vocab_file file; ok &= file.open(bin_path); });
+    const std::string text = "the quick brown fox jumps over 42 lazy dogs, again and again";
+    std::vector<gpt_vocab::id> json_tokens, bin_tokens;
+    const double first_tokenize_ms = time_ms([&] { bin_tokens = gpt_tokenize(from_bin, text); });
+    const double tokenize_ms       = time_ms([&] { bin_tokens = gpt_tokenize(from_bin, text); });
+    json_tokens = gpt_tokenize(from_json, text);
+
+    printf("%zu tokens\n", tokens.size());
+    printf("encoder.json parse                %8.2f ms\n", json_ms);
+    printf("encoder.json parse + cache write  %8.2f ms\n", write_ms);
+    printf("encoder.json via binary cache     %8.2f ms\n", cache_ms);
+    printf("binary vocab                      %8.2f ms\n", bin_ms);
+    printf("mmap open alone                   %8.3f ms\n", mmap_ms);
+    printf("first tokenize (builds the trie)  %8.2f ms, then %.3f ms\n", first_tokenize_ms, tokenize_ms);
+
+    if (wrote_without_cache_dir) {
+        printf("FAIL loading without a cache directory wrote a binary vocab\n");
+        return 1;
+    }
+    if (json_tokens != bin_tokens) {
+        printf("FAIL gpt_tokenize differs between encoder.json and the binary vocab\n");
+        return 1;
+    }
+    if (!ok || from_json.file || from_json_cached.file || !from_cache.file || !from_bin.file) {
+        printf("FAIL load (ok %d, json mapped %d, cache mapped %d, bin mapped %d)\n",
+               ok, !!from_json.file, !!from_cache.file, !!from_bin.file);
+        return 1;
+    }
+
+    // Every token, and random strings that are mostly not tokens, must look
+    // up the same in the parsed and the mapped vocabulary
+    size_t mismatches = 0;
+    for (size_t i = 0; i < tokens.size(); ++i) {
+        const int id = static_cast<int>(i);
+        if (from_json.find(tokens[i]) != id || from_cache.find(tokens[i]) != id || from_cache.token_text(id) != tokens[i]) {
+            ++mismatches;
+        }
+    }
+    for (int k = 0; k < 200000; ++k) {
+        std::string s;
+        for (int i = 0, len = 1 + rng() % 12; i < len; ++i) {
+            s += chars[rng() % n_chars];
+        }
+        mismatches += from_json.find(s) != from_cache.find(s);
+    }
+    if (from_cache.find("") != -1 || !from_cache.token_text(-1).empty() || !from_cache.token_text(k_vocab_size).empty()) {
+        ++mismatches;
+    }
+
+    volatile long sink = 0;
+    const double map_lookup_ms  = time_ms([&] { for (auto & t : tokens) sink = sink + from_json.find(t); });
+    const double hash_lookup_ms = time_ms([&] { for (auto & t : tokens) sink = sink + from_cache.find(t); });
+    printf("%zu lookups: map %.2f ms, perfect hash %.2f ms\n", tokens.size(), map_lookup_ms, hash_lookup_ms);
+
+    // A truncated binary must be rejected rather than read past its end
+    {
+        std::ifstream in(bin_path, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        data.resize(data.size() - 3);
+        std::ofstream(k_truncated_path, std::ios::binary) << data;
+    }
+    gpt_vocab_file truncated;
+    const bool truncated_rejected = !truncated.open(k_truncated_path);
+
+    std::remove(k_json_path);
+    std::filesystem::remove_all(k_cache_dir);
+    std::remove(k_truncated_path);
+
+    if (mismatches) {
+        printf("FAIL %zu lookups differ between encoder.json and the binary vocab\n", mismatches);
+        return 1;
+    }
+    if (!truncated_rejected) {
+        printf("FAIL truncated binary vocab was accepted\n");
+        return 1;
+    }
+    return 0;
+}
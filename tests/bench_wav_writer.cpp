@@ -0,0 +1,236 @@
+// wav_writer write() cost for 20 ms writes of float and int16 audio, paced
+// at 100x real time: in the foreground, with the background ring, and with
+// the background writer it replaced (a mutex-guarded deque of blocks), plus
+// a read-back check of the header sizes and samples. The ring drops audio
+// only if the disk falls 1 MiB behind, which it must not do here.
+
+#include "common.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iterator>
+#include <type_traits>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t k_sample_rate = 16000;
+constexpr size_t   k_samples     = k_sample_rate * 60;    // 1 minute
+constexpr size_t   k_write       = k_sample_rate / 50;    // 20 ms per write()
+constexpr int      k_speedup     = 100;                   // write() every 200 us
+
+// The background writer before the ring: write() locks a mutex to queue
+// full blocks on an unbounded deque and takes an emptied vector back from
+// the writer thread, allocating a new one when none has come back yet
+class deque_wav_writer {
+public:
+    bool open(const char * path, uint32_t sample_rate) {
+        file.open(path, std::ios::binary | std::ios::trunc);
+        const uint32_t fmt_size = 16, byte_rate = sample_rate * 2;
+        const uint16_t format = 1, channels = 1, align = 2, bits = 16;
+        file.write("RIFF\0\0\0\0WAVEfmt ", 16);
+        file.write(reinterpret_cast<const char *>(&fmt_size), 4);
+        file.write(reinterpret_cast<const char *>(&format), 2);
+        file.write(reinterpret_cast<const char *>(&channels), 2);
+        file.write(reinterpret_cast<const char *>(&sample_rate), 4);
+        file.write(reinterpret_cast<const char *>(&byte_rate), 4);
+        file.write(reinterpret_cast<const char *>(&align), 2);
+        file.write(reinterpret_cast<const char *>(&bits), 2);
+        file.write("data\0\0\0\0", 8);
+        block.reserve(k_block);
+        writer = std::thread(&deque_wav_writer::writer_loop, this);
+        return file.good();
+    }
+
+    bool write(const float * data, size_t length) {
+        while (length > 0) {
+            const size_t n = std::min(length, space());
+            const size_t offset = block.size();
+            block.resize(offset + n);
+            pcm::float_to_int16(data, block.data() + offset, n);
+            data += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    bool write(const int16_t * data, size_t length) {
+        while (length > 0) {
+            const size_t n = std::min(length, space());
+            block.insert(block.end(), data, data + n);
+            data += n;
+            length -= n;
+        }
+        return true;
+    }
+
+    bool close() {
+        submit();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        cv.notify_all();
+        writer.join();
+        const uint32_t riff_size = 36 + data_size;
+        file.seekp(4);
+        file.write(reinterpret_cast<const char *>(&riff_size), 4);
+        file.seekp(40);
+        file.write(reinterpret_cast<const char *>(&data_size), 4);
+        file.close();
+        return !file.fail();
+    }
+
+private:
+    static constexpr size_t k_block = 32768;
+
+    std::ofstream file;
+    uint32_t data_size = 0;
+    std::vector<int16_t> block;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::vector<int16_t>> pending;
+    std::vector<std::vector<int16_t>> spare;
+    bool stopping = false;
+
+    size_t space() {
+        if (block.size() >= k_block) {
+            submit();
+        }
+        return k_block - block.size();
+    }
+
+    void submit() {
+        if (block.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.push_back(std::move(block));
+        if (!spare.empty()) {
+            block = std::move(spare.back());
+            spare.pop_back();
+        } else {
+            block = {};
+        }
+        block.reserve(k_block);
+        cv.notify_all();
+    }
+
+    void writer_loop() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            cv.wait(lock, [this] { return !pending.empty() || stopping; });
+            if (pending.empty()) {
+                return;
+            }
+            std::vector<int16_t> data = std::move(pending.front());
+            pending.pop_front();
+            lock.unlock();
+            file.write(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(int16_t));
+            data_size += static_cast<uint32_t>(data.size() * sizeof(int16_t));
+            data.clear();
+            lock.lock();
+            spare.push_back(std::move(data));
+        }
+    }
+};
+
+// The file must declare and hold exactly the samples written
+bool verify(const char * path, const std::vector<int16_t> & expected) {
+    std::ifstream in(path, std::ios::binary);
+    const std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (data.size() != 44 + expected.size() * sizeof(int16_t)) {
+        printf("FAIL %s: %zu bytes\n", path, data.size());
+        return false;
+    }
+    uint32_t riff_size = 0, data_size = 0;
+    memcpy(&riff_size, data.data() + 4, 4);
+    memcpy(&data_size, data.data() + 40, 4);
+    if (riff_size != 36 + data_size || data_size != expected.size() * sizeof(int16_t)) {
+        printf("FAIL %s: header sizes %u/%u\n", path, riff_size, data_size);
+        return false;
+    }
+    if (memcmp(data.data() + 44, expected.data(), data_size) != 0) {
+        printf("FAIL %s: samples differ\n", path);
+        return false;
+    }
+    return true;
+}
+
+// Writer is wav_writer in the given mode, or deque_wav_writer
+template <typename Writer, typename T>
+bool run(const char * name, const char * path, const std::vector<T> & samples,
+         const std::vector<int16_t> & expected, bool background) {
+    Writer writer;
+    bool opened;
+    if constexpr (std::is_same_v<Writer, wav_writer>) {
+        opened = writer.open(path, k_sample_rate, 16, 1, background);
+    } else {
+        opened = writer.open(path, k_sample_rate);
+    }
+    if (!opened) {
+        printf("FAIL %s: cannot open %s\n", name, path);
+        return false;
+    }
+
+    // The slowest write() calls matter for a real-time producer, not just the total
+    std::vector<double> write_us;
+    write_us.reserve(samples.size() / k_write + 1);
+    bool written = true;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t pos = 0; pos < samples.size(); pos += k_write) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds(1000000 / k_speedup * pos / k_sample_rate));
+        const auto t = std::chrono::steady_clock::now();
+        written = writer.write(samples.data() + pos, std::min(k_write, samples.size() - pos)) && written;
+        write_us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t).count());
+    }
+    const auto close_start = std::chrono::steady_clock::now();
+    const bool closed = writer.close();
+    const double close_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - close_start).count();
+
+    double total_us = 0.0;
+    for (double us : write_us) {
+        total_us += us;
+    }
+    std::sort(write_us.begin(), write_us.end());
+    printf("%-24s write() total %7.1f ms  p50 %5.1f us  p99 %6.1f us  max %7.1f us  close() %5.1f ms\n", name,
+           total_us / 1e3, write_us[write_us.size() / 2], write_us[write_us.size() * 99 / 100], write_us.back(),
+           close_ms);
+    if (!written) {
+        printf("FAIL %s: write() dropped audio\n", name);
+    }
+    return written && closed && verify(path, expected);
+}
+
+} // namespace
+
+int main() {
+    std::vector<float> f(k_samples);
+    std::vector<int16_t> s(k_samples);
+    for (size_t i = 0; i < k_samples; ++i) {
+        f[i] = 0.5f * std::sin(0.01f * static_cast<float>(i));
+    }
+    pcm::float_to_int16(f.data(), s.data(), k_samples);
+
+    bool ok = true;
+    ok = run<wav_writer>("float, foreground", "bench_wav_float.wav", f, s, false) && ok;
+    ok = run<wav_writer>("int16, foreground", "bench_wav_int16.wav", s, s, false) && ok;
+    ok = run<wav_writer>("float, background ring", "bench_wav_float_bg.wav", f, s, true) && ok;
+    ok = run<wav_writer>("int16, background ring", "bench_wav_int16_bg.wav", s, s, true) && ok;
+    ok = run<deque_wav_writer>("float, background deque", "bench_wav_float_dq.wav", f, s, true) && ok;
+    ok = run<deque_wav_writer>("int16, background deque", "bench_wav_int16_dq.wav", s, s, true) && ok;
+
+    for (const char * path : {"bench_wav_float.wav", "bench_wav_int16.wav", "bench_wav_float_bg.wav",
+                              "bench_wav_int16_bg.wav", "bench_wav_float_dq.wav", "bench_wav_int16_dq.wav"}) {
+        std::remove(path);
+    }
+    return ok ? 0 : 1;
+}
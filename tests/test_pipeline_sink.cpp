@@ -0,0 +1,250 @@
+// Headless pipeline run: scripted STT, LLM and tone-generating TTS backends
+// drive PipelineManager into a MemoryAudioSink, and the captured samples are
+// checked against what the TTS produced for the LLM's words.
+
+#include "pipeline_manager.h"
+#include "audio_sink.h"
+#include "config_manager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr unsigned int k_sample_rate    = 16000;
+constexpr size_t       k_samples_per_word = k_sample_rate / 20;  // 50 ms of tone per word
+constexpr double       k_amplitude      = 8000.0;
+
+const char k_config_path[] = "test_pipeline_sink.json";
+const char k_utterance[]   = "what is the answer";
+const char * const k_response_chunks[] = {"The answer is simple. ", "It has two ", "sentences."};
+
+std::vector<std::string> split_words(const std::string & text) {
+    std::istringstream in(text);
+    std::vector<std::string> words;
+    for (std::string word; in >> word;) {
+        words.push_back(word);
+    }
+    return words;
+}
+
+// Reports one utterance shortly after streaming starts
+class ScriptedSTT : public ISTT {
+public:
+    bool init() override { return true; }
+
+    bool start_streaming(ResultCallback callback) override {
+        m_thread = std::thread([callback] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            callback(k_utterance);
+        });
+        return true;
+    }
+
+    void stop_streaming() override {
+        if (m_thread.joinable()) {
+            m_thread.join();
+        }
+    }
+
+    void shutdown() override { stop_streaming(); }
+
+private:
+    std::thread m_thread;
+};
+
+// Streams a fixed response in chunks, as a token stream would arrive
+class ScriptedLLM : public ILLM {
+public:
+    bool init() override { return true; }
+
+    bool generate(const std::string & prompt, std::string & response) override {
+        return generate_async(prompt, response, [](const std::string &) {});
+    }
+
+    bool generate_async(const std::string &, std::string & response,
+                        std::function<void(const std::string &)> callback) override {
+        for (const char * chunk : k_response_chunks) {
+            response += chunk;
+            callback(chunk);
+        }
+        return true;
+    }
+
+    void shutdown() override {}
+};
+
+// Speaks every word as 50 ms of a 440 Hz tone and records what it was asked to say
+class ToneTTS : public ITTS {
+public:
+    struct Log {
+        std::mutex mutex;
+        std::vector<std::string> texts;
+        size_t samples = 0;
+    };
+
+    explicit ToneTTS(Log & log) : m_log(log) {}
+
+    bool init() override { return true; }
+
+    bool speak(const std::string & text, async_pipeline::AudioChunkMessage & audio_chunk) override {
+        audio_chunk.audio_data = render(text);
+        audio_chunk.sample_rate = k_sample_rate;
+        return true;
+    }
+
+    bool speakWithPhonemeTimings(const std::string & text, async_pipeline::AudioChunkMessage & audio_chunk,
+                                 std::vector<PhonemeTimingInfo> & phoneme_timings) override {
+        phoneme_timings.clear();
+        return speak(text, audio_chunk);
+    }
+
+    bool speak_stream(const std::string & text, const TTSChunkCallback & on_audio_chunk,
+                      const TTSCancelCallback & cancel, bool) override {
+        if (cancel && cancel()) {
+            return true;
+        }
+        TTSStreamChunk chunk;
+        chunk.audio = render(text);
+        chunk.sample_rate = k_sample_rate;
+        chunk.last = true;
+        on_audio_chunk(chunk);
+        return true;
+    }
+
+    unsigned int sample_rate() const override { return k_sample_rate; }
+
+    void shutdown() override {}
+
+private:
+    Log & m_log;
+
+    std::vector<int16_t> render(const std::string & text) {
+        const size_t n = split_words(text).size() * k_samples_per_word;
+        std::vector<int16_t> audio(n);
+        for (size_t i = 0; i < n; ++i) {
+            audio[i] = static_cast<int16_t>(std::lround(k_amplitude * std::sin(2.0 * M_PI * 440.0 * i / k_sample_rate)));
+        }
+        std::lock_guard<std::mutex> lock(m_log.mutex);
+        m_log.texts.push_back(text);
+        m_log.samples += n;
+        return audio;
+    }
+};
+
+} // namespace
+
+int main() {
+    // Fillers would add audio the LLM never produced. Every other setting is
+    // left out (and tts.voices is not even an object), so the getters the
+    // pipeline reads must fall back to their defaults rather than assert.
+    std::ofstream(k_config_path) << R"({"settings": {"tts": {"fillers": {"enabled": false}, "voices": "none"}}})";
+    auto & settings = ConfigManager::getInstance();
+    if (!settings.loadConfig(k_config_path)) {
+        printf("FAIL loading %s\n", k_config_path);
+        return 1;
+    }
+    if (settings.getTtsFillersEnabled() || settings.getTtsNormalizerMinChars() != 32 ||
+        settings.getTtsDefaultVoice() != "default" || settings.getAudioOutputWavPath() != "tts_output.wav" ||
+        settings.getTtsFillerPhrases().size() != 4) {
+        printf("FAIL settings missing from the config did not return their defaults\n");
+        return 1;
+    }
+
+    async_pipeline::PipelineConfig config;
+    config.enable_alt_text    = false;
+    config.enable_barge_in    = false;
+    config.enable_echo_cancel = false;
+
+    ToneTTS::Log log;
+    async_pipeline::PipelineManager pipeline(config);
+    if (!pipeline.initialize(std::make_unique<ScriptedSTT>(), std::make_unique<ScriptedLLM>(),
+                             std::make_unique<ToneTTS>(log))) {
+        printf("FAIL pipeline initialize\n");
+        return 1;
+    }
+    auto sink = std::make_shared<MemoryAudioSink>();
+    pipeline.set_audio_sink(sink);
+    if (!pipeline.start()) {
+        printf("FAIL pipeline start\n");
+        return 1;
+    }
+
+    // Done once the capture has stopped growing for half a second
+    std::string expected_text;
+    for (const char * chunk : k_response_chunks) {
+        expected_text += chunk;
+    }
+    const size_t expected_words = split_words(expected_text).size();
+    const size_t expected_samples = expected_words * k_samples_per_word;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    size_t last_size = 0;
+    auto last_change = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const size_t size = sink->captured().size();
+        if (size != last_size) {
+            last_size = size;
+            last_change = std::chrono::steady_clock::now();
+        } else if (size >= expected_samples / 2 &&
+                   std::chrono::steady_clock::now() - last_change > std::chrono::milliseconds(500)) {
+            break;
+        }
+    }
+    pipeline.stop();
+    std::remove(k_config_path);
+
+    const auto captured = sink->captured();
+    std::string spoken;
+    size_t synthesized = 0;
+    {
+        std::lock_guard<std::mutex> lock(log.mutex);
+        for (const auto & text : log.texts) {
+            spoken += text + " ";
+        }
+        synthesized = log.samples;
+    }
+
+    int peak = 0;
+    double energy = 0.0;
+    for (int16_t s : captured) {
+        peak = std::max(peak, std::abs(static_cast<int>(s)));
+        energy += static_cast<double>(s) * s;
+    }
+    const double rms = captured.empty() ? 0.0 : std::sqrt(energy / captured.size());
+
+    printf("spoken: '%s'\n", spoken.c_str());
+    printf("captured %zu samples at %u Hz (synthesized %zu, expected %zu), peak %d, rms %.0f\n",
+           captured.size(), sink->sample_rate(), synthesized, expected_samples, peak, rms);
+
+    bool ok = true;
+    if (split_words(spoken) != split_words(expected_text)) {
+        printf("FAIL TTS was not asked to speak the LLM response word for word\n");
+        ok = false;
+    }
+    if (sink->sample_rate() != k_sample_rate) {
+        printf("FAIL sink opened at %u Hz, not the voice rate\n", sink->sample_rate());
+        ok = false;
+    }
+    // Crossfades between chunks and the final fade-out may trim a little
+    if (captured.size() > expected_samples || captured.size() < expected_samples * 9 / 10) {
+        printf("FAIL captured length differs from the synthesized audio\n");
+        ok = false;
+    }
+    // A sine of amplitude A has RMS A/sqrt(2); gain changes or dropped
+    // blocks would move it, clipping or corruption would raise the peak
+    if (peak > k_amplitude * 1.01 || std::fabs(rms - k_amplitude / std::sqrt(2.0)) > 0.1 * k_amplitude) {
+        printf("FAIL captured level does not match the tone\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+// Quality and throughput of PolyphaseResampler: SNR of a resampled tone,
+// passband ripple, and samples per second for the rate pairs the capture and
+// playback paths use.
+
+#define _USE_MATH_DEFINES // for M_PI
+
+#include "resampler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+constexpr double k_min_snr_db      = 90.0;
+constexpr double k_max_ripple_db   = 0.001;
+constexpr double k_passband        = 0.8;   // tested passband, fraction of the lower Nyquist
+constexpr double k_tone_amplitude  = 0.5;
+
+struct RatePair {
+    int in_rate;
+    int out_rate;
+};
+
+// Resample a tone in odd-sized blocks, so block boundaries are exercised
+std::vector<float> resample_tone(PolyphaseResampler & rs, double freq, double seconds) {
+    const size_t n = static_cast<size_t>(seconds * rs.in_rate());
+    std::vector<float> in(n);
+    for (size_t i = 0; i < n; ++i) {
+        in[i] = static_cast<float>(k_tone_amplitude * std::sin(2.0 * M_PI * freq * i / rs.in_rate()));
+    }
+
+    rs.reset();
+    std::vector<float> out;
+    const size_t blocks[] = {160, 317, 1024, 7};
+    for (size_t pos = 0, b = 0; pos < n; ++b) {
+        const size_t len = std::min(blocks[b % 4], n - pos);
+        rs.process(in.data() + pos, len, out);
+        pos += len;
+    }
+    return out;
+}
+
+// Least-squares fit of a * sin + b * cos + c at freq over the steady-state
+// part of the output; returns the fitted amplitude and the residual power
+void fit_tone(const std::vector<float> & y, size_t skip, double freq, int rate, double & amplitude, double & residual) {
+    double ss = 0, sc = 0, cc = 0, s1 = 0, c1 = 0, n = 0, ys = 0, yc = 0, y1 = 0;
+    const size_t end = y.size() - skip;
+    for (size_t i = skip; i < end; ++i) {
+        const double w = 2.0 * M_PI * freq * i / rate;
+        const double s = std::sin(w), c = std::cos(w);
+        ss += s * s; sc += s * c; cc += c * c; s1 += s; c1 += c; n += 1;
+        ys += y[i] * s; yc += y[i] * c; y1 += y[i];
+    }
+
+    // Solve the 3x3 normal equations by Cramer's rule
+    const double m[3][3] = {{ss, sc, s1}, {sc, cc, c1}, {s1, c1, n}};
+    const double r[3] = {ys, yc, y1};
+    auto det = [](const double a[3][3]) {
+        return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) -
+               a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0]) +
+               a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+    };
+    const double d = det(m);
+    double coef[3];
+    for (int k = 0; k < 3; ++k) {
+        double mk[3][3];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j) {
+                mk[i][j] = (j == k) ? r[i] : m[i][j];
+            }
+        }
+        coef[k] = det(mk) / d;
+    }
+
+    amplitude = std::hypot(coef[0], coef[1]);
+    residual = 0.0;
+    for (size_t i = skip; i < end; ++i) {
+        const double w = 2.0 * M_PI * freq * i / rate;
+        const double e = y[i] - (coef[0] * std::sin(w) + coef[1] * std::cos(w) + coef[2]);
+        residual += e * e;
+    }
+    residual /= n;
+}
+
+bool check_quality(const RatePair & pair) {
+    PolyphaseResampler rs;
+    if (!rs.init(pair.in_rate, pair.out_rate)) {
+        printf("FAIL %d -> %d: init\n", pair.in_rate, pair.out_rate);
+        return false;
+    }
+    const size_t skip = 2 * (rs.latency() * pair.out_rate / pair.in_rate + 1);
+
+    // SNR of a 1 kHz tone: everything that is not the tone is noise,
+    // aliasing, imaging or block-boundary error
+    double amplitude = 0, residual = 0;
+    fit_tone(resample_tone(rs, 1000.0, 1.0), skip, 1000.0, pair.out_rate, amplitude, residual);
+    const double snr_db = 10.0 * std::log10(0.5 * amplitude * amplitude / std::max(residual, 1e-30));
+
+    // Passband ripple: spread of the tone gain across the passband
+    const double edge = k_passband * 0.5 * std::min(pair.in_rate, pair.out_rate);
+    double min_gain = 1e9, max_gain = 0;
+    for (int k = 0; k <= 24; ++k) {
+        const double freq = 50.0 + (edge - 50.0) * k / 24;
+        fit_tone(resample_tone(rs, freq, 0.5), skip, freq, pair.out_rate, amplitude, residual);
+        const double gain = amplitude / k_tone_amplitude;
+        min_gain = std::min(min_gain, gain);
+        max_gain = std::max(max_gain, gain);
+    }
+    const double ripple_db = 20.0 * std::log10(max_gain / min_gain);
+
+    const bool ok = snr_db > k_min_snr_db && ripple_db < k_max_ripple_db;
+    printf("%s %5d -> %5d: SNR %.1f dB, ripple %.5f dB up to %.0f Hz\n", ok ? "ok  " : "FAIL",
+           pair.in_rate, pair.out_rate, snr_db, ripple_db, edge);
+    return ok;
+}
+
+void bench_throughput(const RatePair & pair) {
+    PolyphaseResampler rs;
+    rs.init(pair.in_rate, pair.out_rate);
+
+    const size_t block = static_cast<size_t>(pair.in_rate / 50);  // 20 ms
+    const size_t n_blocks = 500;                                   // 10 s of audio
+    std::vector<float> in(block);
+    for (size_t i = 0; i < block; ++i) {
+        in[i] = static_cast<float>(std::sin(0.01 * i));
+    }
+    std::vector<float> out;
+    out.reserve(block * 8);
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t b = 0; b < n_blocks; ++b) {
+        out.clear();
+        rs.process(in.data(), in.size(), out);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double audio_seconds = static_cast<double>(block * n_blocks) / pair.in_rate;
+    printf("     %5d -> %5d: %.1f Msamples/s in, %.0fx real time\n", pair.in_rate, pair.out_rate,
+           block * n_blocks / seconds / 1e6, audio_seconds / seconds);
+}
+
+} // namespace
+
+int main() {
+    // Microphone to the STT models, and TTS voices to common device rates
+    const RatePair pairs[] = {
+        {48000, 16000}, {44100, 16000}, {16000, 48000},
+        {22050, 48000}, {22050, 44100}, {24000, 48000}, {22050, 16000},
+    };
+
+    bool ok = true;
+    for (const auto & pair : pairs) {
+        ok = check_quality(pair) && ok;
+    }
+    for (const auto & pair : pairs) {
+        bench_throughput(pair);
+    }
+    return ok ? 0 : 1;
+}
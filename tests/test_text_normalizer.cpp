@@ -0,0 +1,75 @@
+// TextNormalizer expansions: phone numbers and digit ranges, numbers,
+// fractions, dates and years, each checked against the exact words handed
+// to TTS.
+
+#include "text_normalizer.h"
+
+#include <cstdio>
+#include <exception>
+#include <string>
+
+namespace {
+
+struct Case {
+    const char * input;
+    const char * expected;
+};
+
+const Case k_cases[] = {
+    // Phone numbers, and digit groups that only look like them
+    {"Call 555-1234.",           "Call five five five, one two three four."},
+    {"Call 1-800-555-1234 now.", "Call one, eight zero zero, five five five, one two three four now."},
+    {"100-1000",                 "one hundred to one thousand"},
+    {"999-9",                    "nine hundred ninety-nine to nine"},
+    {"Call 555-1",               "Call five hundred fifty-five to one"},
+    {"pages 300-5",              "pages three hundred to five"},
+
+    // Numbers
+    {"1,234 people",             "one thousand two hundred thirty-four people"},
+    {"1.5",                      "one point five"},
+    {"-3 degrees",               "minus three degrees"},
+    {"the 21st century",         "the twenty-first century"},
+    {"It costs $3.50.",          "It costs three dollars and fifty cents."},
+    {"50%",                      "fifty percent"},
+    {"5 km",                     "five kilometers"},
+    {"Version 2.1.3",            "Version two point one point three"},
+    {"See No. 5.",               "See number five."},
+    {"At 12:30 pm.",             "At twelve thirty P M."},
+
+    // Fractions, and slashes that are not fractions
+    {"1/2 cup",                  "one half cup"},
+    {"3/4",                      "three quarters"},
+    {"1/3 of 10",                "one third of ten"},
+    {"2 1/2 cups",               "two and one half cups"},
+    {"1 1/2 km",                 "one and one half kilometers"},
+    {"3/100",                    "three hundredths"},
+    {"24/7",                     "twenty-four seven"},
+    {"9/11",                     "nine eleven"},
+
+    // Dates, years and decades
+    {"On 2024-03-05 we met.",    "On March fifth, twenty twenty-four we met."},
+    {"In the 1990s.",            "In the nineteen nineties."},
+    {"Due 10/15/2024.",          "Due October fifteenth, twenty twenty-four."},
+    {"Due 15/10/2024.",          "Due October fifteenth, twenty twenty-four."},
+    {"Since 1999 it grew.",      "Since nineteen ninety-nine it grew."},
+};
+
+} // namespace
+
+int main() {
+    int failures = 0;
+    for (const auto & c : k_cases) {
+        std::string got;
+        try {
+            got = TextNormalizer::normalize(c.input);
+        } catch (const std::exception & e) {
+            got = std::string("exception: ") + e.what();
+        }
+        if (got != c.expected) {
+            printf("FAIL '%s'\n  expected '%s'\n  got      '%s'\n", c.input, c.expected, got.c_str());
+            ++failures;
+        }
+    }
+    printf("%zu cases, %d failed\n", sizeof(k_cases) / sizeof(k_cases[0]), failures);
+    return failures ? 1 : 0;
+}
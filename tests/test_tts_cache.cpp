@@ -0,0 +1,142 @@
+// TTSAudioCache disk tier: stays within disk_bytes by deleting the least
+// recently used files, keeps that order across a restart, trims a directory
+// that is over budget when opened, and survives workers writing the same
+// phrase at once.
+
+#include "tts_cache.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+const char k_dir[]        = "test_tts_cache_dir";  // not the executable's own name
+constexpr size_t k_samples = 8000;  // 16 KB of PCM per phrase
+
+TTSCacheEntry make_entry(int seed) {
+    TTSCacheEntry entry;
+    entry.sample_rate = 22050;
+    entry.audio.assign(k_samples, static_cast<int16_t>(seed));
+    return entry;
+}
+
+size_t files_on_disk(const char * extension = ".pcm") {
+    size_t n = 0;
+    for (const auto & file : std::filesystem::directory_iterator(k_dir)) {
+        n += file.path().extension() == extension;
+    }
+    return n;
+}
+
+bool on_disk(const TTSAudioCache::Options & options, const std::string & text) {
+    // A fresh instance with no memory tier can only answer from disk
+    TTSAudioCache::Options disk_only = options;
+    disk_only.memory_bytes = 0;
+    TTSAudioCache cache(disk_only, 1);
+    TTSCacheEntry out;
+    return cache.lookup(text, false, out);
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::remove_all(k_dir);
+
+    TTSAudioCache::Options options;
+    options.memory_bytes = 0;  // every lookup goes to disk
+    options.disk_path    = k_dir;
+    options.disk_bytes   = 5 * (2 * k_samples + 64);  // room for five phrases
+
+    bool ok = true;
+    {
+        TTSAudioCache cache(options, 1);
+        for (int i = 0; i < 5; ++i) {
+            cache.insert("phrase " + std::to_string(i), make_entry(i));
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));  // distinct mtimes
+        }
+
+        // Reading phrase 0 makes phrase 1 the least recently used
+        TTSCacheEntry out;
+        ok &= cache.lookup("phrase 0", false, out) && out.audio.size() == k_samples && out.audio[0] == 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+        cache.insert("phrase 5", make_entry(5));
+        const auto stats = cache.stats();
+        printf("after 6 inserts: %zu files, %zu of %zu bytes\n", stats.disk_files, stats.disk_used, options.disk_bytes);
+        ok &= stats.disk_files == 5 && stats.disk_used <= options.disk_bytes && files_on_disk() == 5;
+        ok &= !on_disk(options, "phrase 1") && on_disk(options, "phrase 0") && on_disk(options, "phrase 5");
+    }
+
+    // After a restart the order comes from file mtimes: phrase 2 goes next
+    {
+        TTSAudioCache cache(options, 1);
+        ok &= cache.stats().disk_files == 5;
+        cache.insert("phrase 6", make_entry(6));
+        ok &= !on_disk(options, "phrase 2") && on_disk(options, "phrase 3") && on_disk(options, "phrase 0");
+        ok &= files_on_disk() == 5 && cache.stats().disk_used <= options.disk_bytes;
+    }
+
+    // Rewriting an existing phrase replaces its file instead of adding bytes
+    {
+        TTSAudioCache cache(options, 1);
+        const size_t before = cache.stats().disk_used;
+        cache.insert("phrase 6", make_entry(7));
+        ok &= cache.stats().disk_used == before && files_on_disk() == 5;
+    }
+    if (!ok) {
+        printf("FAIL disk tier eviction\n");
+    }
+
+    // Reopening with a smaller budget trims the oldest files right away;
+    // the lookups above left phrases 6, 0 and 3 the most recent
+    {
+        TTSAudioCache::Options smaller = options;
+        smaller.disk_bytes = 3 * (2 * k_samples + 64);
+        TTSAudioCache cache(smaller, 1);
+        const auto stats = cache.stats();
+        printf("reopened at 3 phrases: %zu files, %zu of %zu bytes\n", stats.disk_files, stats.disk_used,
+               smaller.disk_bytes);
+        if (stats.disk_files != 3 || stats.disk_used > smaller.disk_bytes || files_on_disk() != 3 ||
+            !on_disk(smaller, "phrase 6") || on_disk(smaller, "phrase 5") || on_disk(smaller, "phrase 4")) {
+            printf("FAIL directory over budget was not trimmed at startup\n");
+            ok = false;
+        }
+    }
+
+    // Workers storing the same phrase concurrently must leave one complete
+    // file holding one of their entries, and no temp files
+    {
+        TTSAudioCache cache(options, 1);
+        std::vector<std::thread> workers;
+        for (int w = 0; w < 4; ++w) {
+            workers.emplace_back([&cache, w] {
+                for (int i = 0; i < 20; ++i) {
+                    cache.insert("shared phrase", make_entry(10 + w));
+                }
+            });
+        }
+        for (auto & worker : workers) {
+            worker.join();
+        }
+
+        TTSCacheEntry out;
+        bool intact = on_disk(options, "shared phrase");
+        TTSAudioCache reader(options, 1);
+        intact &= reader.lookup("shared phrase", false, out) && out.audio.size() == k_samples &&
+                  out.audio[0] >= 10 && out.audio[0] < 14;
+        for (int16_t s : out.audio) {
+            intact &= s == out.audio[0];
+        }
+        if (!intact || files_on_disk(".tmp") != 0) {
+            printf("FAIL concurrent writes of one phrase left a torn file or temp files\n");
+            ok = false;
+        }
+    }
+
+    std::filesystem::remove_all(k_dir);
+    return ok ? 0 : 1;
+}